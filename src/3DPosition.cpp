@@ -6,6 +6,8 @@
 #include <iostream>
 
 #include "3DPosition.h"
+#include "PositionBatch.h"
+#include "FastTrig.h"
 
 BBC_AUDIOTOOLBOX_START
 
@@ -39,7 +41,7 @@ Position& Position::operator /= (const Quaternion& rotation)
 /*--------------------------------------------------------------------------------*/
 bool Position::GetFromParameters(const ParameterSet& parameters, const std::string& name)
 {
-  ParameterSet subparameters = parameters.GetSubParameters(name);
+  ParameterSetView subparameters(parameters, name);
   bool success;
   bool radians = false;
 
@@ -269,6 +271,50 @@ Position operator / (const Position& pos, const Quaternion& rotation)
   return ((rotation.Invert() * Quaternion(pos)) * rotation).GetAxis();
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Generate 3x3 rotation matrix equivalent to rotating a position by this Quaternion
+ *
+ * @note the matrix is calculated from q * p * q' (q' = Invert()) directly so that
+ * it matches operator * (const Position&, const Quaternion&) even for non-unit Quaternions
+ */
+/*--------------------------------------------------------------------------------*/
+void Quaternion::ToRotationMatrix(double matrix[3][3]) const
+{
+  double ww = w * w, xx = x * x, yy = y * y, zz = z * z;
+  double xy = x * y, xz = x * z, yz = y * z;
+  double wx = w * x, wy = w * y, wz = w * z;
+
+  matrix[0][0] = ww + xx - yy - zz;
+  matrix[0][1] = 2.0 * (xy - wz);
+  matrix[0][2] = 2.0 * (xz + wy);
+
+  matrix[1][0] = 2.0 * (xy + wz);
+  matrix[1][1] = ww - xx + yy - zz;
+  matrix[1][2] = 2.0 * (yz - wx);
+
+  matrix[2][0] = 2.0 * (xz - wy);
+  matrix[2][1] = 2.0 * (yz + wx);
+  matrix[2][2] = ww - xx - yy + zz;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Generate 3x3 rotation matrix equivalent to reverse rotating a position by this Quaternion
+ */
+/*--------------------------------------------------------------------------------*/
+void Quaternion::ToInverseRotationMatrix(double matrix[3][3]) const
+{
+  // q' * p * q is the transpose of q * p * q'
+  double fwd[3][3];
+  uint_t i, j;
+
+  ToRotationMatrix(fwd);
+
+  for (i = 0; i < 3; i++)
+  {
+    for (j = 0; j < 3; j++) matrix[i][j] = fwd[j][i];
+  }
+}
+
 /*--------------------------------------------------------------------------------*/
 /** Add a Quaternion to this one
  */
@@ -468,9 +514,209 @@ Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, double t)
     double angle = acos(dot);
     return (q0 * sin(angle * (1.0 - t)) + q * sin(angle * t)) / sin(angle);
   } else {
+    // small angle between them, use linear interpolation (using the negated q1 if necessary)
+    return Lerp(q0, q, t);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Perform Spherical Linear intERPolation between many pairs of unit quaternions
+ *
+ * Uses sin(theta*(1-t)) = sin(theta)cos(theta*t) - cos(theta)sin(theta*t) with
+ * cos(theta) = dot and sin(theta) = sqrt(1 - dot^2) so that only acos(), sin() and cos()
+ * are needed per pair
+ */
+/*--------------------------------------------------------------------------------*/
+void Slerp(const Quaternion *q0, const Quaternion *q1, double t, Quaternion *res, uint_t n)
+{
+  uint_t i;
+
+  if (t < 0.0 || t > 1.0)
+    BBCERROR("Slerp - t should be between 0 and 1");
+
+  for (i = 0; i < n; i++)
+  {
+    const Quaternion& qa = q0[i];
+    const Quaternion& qb = q1[i];
+    double dot = qa.ScalarProduct(qb);
+    double sign = 1.0, a, b;
+
+    // take shortest path (see above)
+    if (dot < 0.0)
+    {
+      dot  = -dot;
+      sign = -1.0;
+    }
+
+    if (dot < 0.95)
+    {
+      double angle = acos(dot);
+      double st    = sin(angle * t);
+      double ct    = cos(angle * t);
+
+      b = st / sqrt(1.0 - dot * dot);
+      a = ct - dot * b;
+    }
+    else
+    {
+      a = 1.0 - t;
+      b = t;
+    }
+
+    b *= sign;
+    res[i] = Quaternion(qa.w * a + qb.w * b,
+                        qa.x * a + qb.x * b,
+                        qa.y * a + qb.y * b,
+                        qa.z * a + qb.z * b);
+  }
+}
+
+/*----------------------------------------------------------------------------------------------------*/
+
+SlerpGenerator::SlerpGenerator() : angle(0.0),
+                                   scale(0.0),
+                                   coeff(2.0),
+                                   step(0),
+                                   steps(0)
+{
+  a[0] = a[1] = 0.0;
+  b[0] = b[1] = 1.0;
+}
+
+SlerpGenerator::SlerpGenerator(const Quaternion& q0, const Quaternion& q1, uint_t steps)
+{
+  Start(q0, q1, steps);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Start a new interpolation
+ */
+/*--------------------------------------------------------------------------------*/
+void SlerpGenerator::Start(const Quaternion& q0, const Quaternion& q1, uint_t steps)
+{
+  double dot = q0.ScalarProduct(q1);
+
+  this->q0    = q0;
+  this->q1    = q1;
+  this->steps = steps;
+  step        = 0;
+
+  // take shortest path (see Slerp())
+  if (dot < 0.0)
+  {
+    dot      = -dot;
+    this->q1 = -q1;
+  }
+
+  if (dot < 0.95)
+  {
+    angle = acos(dot);
+    scale = 1.0 / sin(angle);
+  }
+  else
+  {
     // small angle between them, use linear interpolation
-    return Lerp(q0, q1,t);
+    angle = 0.0;
+    scale = 0.0;
   }
+
+  // for linear interpolation the recurrence becomes w(k+1) = 2.w(k) - w(k-1)
+  coeff = steps ? 2.0 * cos(angle / (double)steps) : 2.0;
+
+  Reseed();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Calculate interpolation weights for the current step exactly
+ */
+/*--------------------------------------------------------------------------------*/
+void SlerpGenerator::Reseed()
+{
+  uint_t i;
+
+  if (step >= steps)
+  {
+    a[0] = a[1] = 0.0;
+    b[0] = b[1] = 1.0;
+    return;
+  }
+
+  // a[0]/b[0] are weights for previous step, a[1]/b[1] for current step
+  for (i = 0; i < 2; i++)
+  {
+    double t = ((double)step + (double)i - 1.0) / (double)steps;
+
+    if (angle > 0.0)
+    {
+      a[i] = sin(angle * (1.0 - t)) * scale;
+      b[i] = sin(angle * t) * scale;
+    }
+    else
+    {
+      a[i] = 1.0 - t;
+      b[i] = t;
+    }
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Advance weights by one step
+ */
+/*--------------------------------------------------------------------------------*/
+void SlerpGenerator::Advance()
+{
+  if (step < steps)
+  {
+    step++;
+
+    if ((step >= steps) || ((step % ReseedInterval) == 0)) Reseed();
+    else
+    {
+      double na = coeff * a[1] - a[0];
+      double nb = coeff * b[1] - b[0];
+
+      a[0] = a[1]; a[1] = na;
+      b[0] = b[1]; b[1] = nb;
+    }
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return the current interpolated Quaternion and advance one step
+ */
+/*--------------------------------------------------------------------------------*/
+Quaternion SlerpGenerator::Next()
+{
+  Quaternion res(q0.w * a[1] + q1.w * b[1],
+                 q0.x * a[1] + q1.x * b[1],
+                 q0.y * a[1] + q1.y * b[1],
+                 q0.z * a[1] + q1.z * b[1]);
+
+  Advance();
+
+  return res;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Generate the next n interpolated Quaternions
+ */
+/*--------------------------------------------------------------------------------*/
+void SlerpGenerator::Generate(Quaternion *res, uint_t n)
+{
+  uint_t i;
+
+  for (i = 0; i < n; i++) res[i] = Next();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Generate the next n interpolated rotations as rotation matrices
+ */
+/*--------------------------------------------------------------------------------*/
+void SlerpGenerator::Generate(double (*matrices)[3][3], uint_t n)
+{
+  uint_t i;
+
+  for (i = 0; i < n; i++) Next().ToRotationMatrix(matrices[i]);
 }
 
 
@@ -480,7 +726,7 @@ Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, double t)
 /*--------------------------------------------------------------------------------*/
 bool Quaternion::GetFromParameters(const ParameterSet& parameters, const std::string& name)
 {
-  ParameterSet subparameters = parameters.GetSubParameters(name);
+  ParameterSetView subparameters(parameters, name);
   bool success = false;
 
   if (subparameters.Get("angle", w) &&
@@ -529,15 +775,18 @@ std::string Quaternion::ToString() const
 
 PositionTransform::PositionTransform()
 {
+  cache.valid = false;
 }
 
 PositionTransform::PositionTransform(const PositionTransform& obj)
 {
+  cache.valid = false;
   operator = (obj);
 }
 
 PositionTransform::PositionTransform(const Quaternion& obj)
 {
+  cache.valid = false;
   operator = (obj);
 }
 
@@ -658,6 +907,161 @@ void PositionTransform::RemoveTransform(Position& pos) const
   }
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Apply transform to batch of positions (one affine matrix multiply per position)
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionTransform::ApplyTransform(PositionBatch& batch) const
+{
+  double matrix[3][4], inverse[3][4];
+
+  GetMatrices(matrix, inverse);
+  batch *= matrix;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove transform from batch of positions (one affine matrix multiply per position)
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionTransform::RemoveTransform(PositionBatch& batch) const
+{
+  double matrix[3][4], inverse[3][4];
+
+  GetMatrices(matrix, inverse);
+  batch *= inverse;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return 3x4 affine matrix equivalent of transform
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionTransform::GetMatrix(double matrix[3][4]) const
+{
+  double inverse[3][4];
+
+  GetMatrices(matrix, inverse);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return 3x4 affine matrix equivalent of removing transform
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionTransform::GetInverseMatrix(double matrix[3][4]) const
+{
+  double forward[3][4];
+
+  GetMatrices(forward, matrix);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return values the matrices are calculated from
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionTransform::GetCacheKey(double key[12]) const
+{
+  key[0]  = pretranslation.polar ? 1.0 : 0.0;
+  key[1]  = pretranslation.pos.elements[0];
+  key[2]  = pretranslation.pos.elements[1];
+  key[3]  = pretranslation.pos.elements[2];
+  key[4]  = posttranslation.polar ? 1.0 : 0.0;
+  key[5]  = posttranslation.pos.elements[0];
+  key[6]  = posttranslation.pos.elements[1];
+  key[7]  = posttranslation.pos.elements[2];
+  key[8]  = rotation.w;
+  key[9]  = rotation.x;
+  key[10] = rotation.y;
+  key[11] = rotation.z;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return apply and remove matrices, from the cache if the transform has not changed
+ * since they were calculated
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionTransform::GetMatrices(double matrix[3][4], double inverse[3][4]) const
+{
+  double key[12];
+  uint_t seq = cache.seqlock.ReadStart();
+  uint_t i, j;
+
+  GetCacheKey(key);
+
+  if (cache.valid.load(std::memory_order_relaxed))
+  {
+    // compare bit patterns so that NaNs and -0 are handled the same as memcmp() would
+    bool match = true;
+
+    for (i = 0; (i < NUMBEROF(key)) && match; i++)
+    {
+      double val = cache.key[i].load(std::memory_order_relaxed);
+      match = (memcmp(&val, &key[i], sizeof(val)) == 0);
+    }
+
+    if (match)
+    {
+      for (i = 0; i < 3; i++)
+      {
+        for (j = 0; j < 4; j++)
+        {
+          matrix[i][j]  = cache.matrix[i][j].load(std::memory_order_relaxed);
+          inverse[i][j] = cache.inverse[i][j].load(std::memory_order_relaxed);
+        }
+      }
+
+      // the copy is only valid if no update started whilst it was being taken
+      if (!cache.seqlock.ReadRetry(seq)) return;
+    }
+  }
+
+  CalcMatrices(matrix, inverse);
+
+  // update the cache unless another thread is already doing so
+  if (cache.seqlock.TryWriteStart(seq))
+  {
+    for (i = 0; i < NUMBEROF(key); i++) cache.key[i].store(key[i], std::memory_order_relaxed);
+    for (i = 0; i < 3; i++)
+    {
+      for (j = 0; j < 4; j++)
+      {
+        cache.matrix[i][j].store(matrix[i][j], std::memory_order_relaxed);
+        cache.inverse[i][j].store(inverse[i][j], std::memory_order_relaxed);
+      }
+    }
+
+    cache.valid.store(true, std::memory_order_relaxed);
+    cache.seqlock.WriteEnd();
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Calculate apply and remove matrices
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionTransform::CalcMatrices(double matrix[3][4], double inverse[3][4]) const
+{
+  Position pre  = pretranslation.Cart();
+  Position post = posttranslation.Cart();
+  double   r[3][3], ri[3][3];
+  uint_t   i, j;
+
+  rotation.ToRotationMatrix(r);
+  rotation.ToInverseRotationMatrix(ri);
+
+  // apply:  pos' = R * (pos + pre) + post = R * pos + (R * pre + post)
+  // remove: pos  = R' * (pos' - post) - pre = R' * pos' - (R' * post + pre)
+  for (i = 0; i < 3; i++)
+  {
+    for (j = 0; j < 3; j++)
+    {
+      matrix[i][j]  = r[i][j];
+      inverse[i][j] = ri[i][j];
+    }
+
+    matrix[i][3]  =   r[i][0] * pre.pos.x  +  r[i][1] * pre.pos.y  +  r[i][2] * pre.pos.z  + post.pos.elements[i];
+    inverse[i][3] = -(ri[i][0] * post.pos.x + ri[i][1] * post.pos.y + ri[i][2] * post.pos.z + pre.pos.elements[i]);
+  }
+}
+
 /*----------------------------------------------------------------------------------------------------*/
 
 ScreenTransform::ScreenTransform() : cx(0.0),
@@ -749,6 +1153,35 @@ void ScreenTransform::RemoveTransform(Position& pos) const
   }
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Apply transform to batch of positions
+ */
+/*--------------------------------------------------------------------------------*/
+void ScreenTransform::ApplyTransform(PositionBatch& batch) const
+{
+  batch *= *this;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove transform from batch of positions
+ */
+/*--------------------------------------------------------------------------------*/
+void ScreenTransform::RemoveTransform(PositionBatch& batch) const
+{
+  batch /= *this;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return scale due to perspective for an array of Z co-ordinates
+ */
+/*--------------------------------------------------------------------------------*/
+void ScreenTransform::GetDistanceScales(const double *z, double *scale, uint_t n) const
+{
+  uint_t i;
+
+  for (i = 0; i < n; i++) scale[i] = (z[i] != dist) ? dist / (dist - z[i]) : 1.0;
+}
+
 /*----------------------------------------------------------------------------------------------------*/
 
 /*--------------------------------------------------------------------------------*/
@@ -763,13 +1196,26 @@ Position::Position(double x, double y, double z) : polar(false)
 
 /*--------------------------------------------------------------------------------*/
 /** Return the same position but as polar co-ordinates
+ *
+ * @param fast true to use approximate trig functions (see FastTrig.h)
  */
 /*--------------------------------------------------------------------------------*/
-Position Position::Polar() const
+Position Position::Polar(bool fast) const
 {
   Position newpos = *this;
         
-  if (!polar)
+  if (!polar && fast)
+  {
+    // same calculation as PositionBatch::ToPolar(true)
+    double d = sqrt(pos.x * pos.x + pos.y * pos.y + pos.z * pos.z);
+    double s = (d > 0.0) ? 1.0 / d : 0.0;
+
+    newpos.polar  = true;
+    newpos.pos.az = FastAtan2(-pos.x * s, pos.y * s) * 180.0 / M_PI;
+    newpos.pos.el = FastAsin(limited::limit(pos.z * s, -1.0, 1.0)) * 180.0 / M_PI;
+    newpos.pos.d  = d;
+  }
+  else if (!polar)
   {
     newpos.polar  = true;
     newpos.pos.az = newpos.pos.el = 0.0;
@@ -803,13 +1249,28 @@ Position Position::Polar() const
 
 /*--------------------------------------------------------------------------------*/
 /** Return the same position but as cartesian co-ordinates
+ *
+ * @param fast true to use approximate trig functions (see FastTrig.h)
  */
 /*--------------------------------------------------------------------------------*/
-Position Position::Cart() const
+Position Position::Cart(bool fast) const
 {
   Position newpos = *this;
         
-  if (polar)
+  if (polar && fast)
+  {
+    // same calculation as PositionBatch::ToCart(true)
+    double sinaz, cosaz, sinel, cosel;
+
+    FastSinCos(pos.az * M_PI / 180.0, sinaz, cosaz);
+    FastSinCos(pos.el * M_PI / 180.0, sinel, cosel);
+
+    newpos.polar = false;
+    newpos.pos.x = pos.d * -sinaz * cosel;
+    newpos.pos.y = pos.d *  cosaz * cosel;
+    newpos.pos.z = pos.d *  sinel;
+  }
+  else if (polar)
   {
     // x = -sin(az) * cos(el)
     // y =  cos(az) * cos(el)
@@ -1243,6 +1704,42 @@ void Position::ToJSON(JSONValue& obj) const
   }
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Write position to a streaming JSON or CBOR writer
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename WRITER>
+static void WritePosition(WRITER& writer, const Position& obj)
+{
+  // members are written in name order to match the output of the above
+  writer.StartObject();
+  if (obj.polar)
+  {
+    writer.Key("az");    writer.Double(obj.pos.az);
+    writer.Key("d");     writer.Double(obj.pos.d);
+    writer.Key("el");    writer.Double(obj.pos.el);
+    writer.Key("polar"); writer.Bool(obj.polar);
+  }
+  else
+  {
+    writer.Key("polar"); writer.Bool(obj.polar);
+    writer.Key("x");     writer.Double(obj.pos.x);
+    writer.Key("y");     writer.Double(obj.pos.y);
+    writer.Key("z");     writer.Double(obj.pos.z);
+  }
+  writer.EndObject();
+}
+
+void Position::ToJSON(JSONWriter& writer) const
+{
+  WritePosition(writer, *this);
+}
+
+void Position::ToJSON(CBORWriter& writer) const
+{
+  WritePosition(writer, *this);
+}
+
 bool Position::FromJSON(const JSONValue& obj)
 {
   Position pos;
@@ -1269,6 +1766,75 @@ bool Position::FromJSON(const JSONValue& obj)
   return success;
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Read position from a streaming JSON or CBOR reader
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename READER>
+static bool ReadPosition(READER& reader, Position& obj)
+{
+  static const char *names[] = {"x", "y", "z", "az", "el", "d"};
+  Position pos;
+  double   values[NUMBEROF(names)];
+  uint_t   found = 0;               // bitmask of valid values
+  bool     success = false;
+
+  if (reader.Next() == READER::Token_ObjectStart)
+  {
+    // the members can be in any order so store values until the end of the object
+    while (reader.Next() == READER::Token_Key)
+    {
+      const std::string& name = reader.GetKey();
+      uint_t i;
+
+      // non-existence of "polar" member is okay
+      if (name == "polar") json::FromJSON(reader, pos.polar);
+      else
+      {
+        for (i = 0; (i < NUMBEROF(names)) && (name != names[i]); i++) ;
+
+        if (i == NUMBEROF(names)) reader.SkipValue();
+        else if (json::FromJSON(reader, values[i])) found |= 1U << i;
+        else found &= ~(1U << i);
+      }
+    }
+
+    if (reader.GetToken() == READER::Token_ObjectEnd)
+    {
+      if (pos.polar)
+      {
+        if ((success = ((found & 0x38) == 0x38)) == true)
+        {
+          pos.pos.az = values[3];
+          pos.pos.el = values[4];
+          pos.pos.d  = values[5];
+        }
+      }
+      else if ((success = ((found & 0x07) == 0x07)) == true)
+      {
+        pos.pos.x = values[0];
+        pos.pos.y = values[1];
+        pos.pos.z = values[2];
+      }
+    }
+  }
+  else reader.Skip();
+
+  if (success) obj = pos;
+
+  return success;
+}
+
+bool Position::FromJSON(JSONReader& reader)
+{
+  return ReadPosition(reader, *this);
+}
+
+bool Position::FromJSON(CBORReader& reader)
+{
+  return ReadPosition(reader, *this);
+}
+
 void Quaternion::ToJSON(JSONValue& obj) const
 {
   obj["w"] = w;
@@ -1277,6 +1843,31 @@ void Quaternion::ToJSON(JSONValue& obj) const
   obj["z"] = z;
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Write rotation to a streaming JSON or CBOR writer
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename WRITER>
+static void WriteQuaternion(WRITER& writer, const Quaternion& obj)
+{
+  writer.StartObject();
+  writer.Key("w"); writer.Double(obj.w);
+  writer.Key("x"); writer.Double(obj.x);
+  writer.Key("y"); writer.Double(obj.y);
+  writer.Key("z"); writer.Double(obj.z);
+  writer.EndObject();
+}
+
+void Quaternion::ToJSON(JSONWriter& writer) const
+{
+  WriteQuaternion(writer, *this);
+}
+
+void Quaternion::ToJSON(CBORWriter& writer) const
+{
+  WriteQuaternion(writer, *this);
+}
+
 bool Quaternion::FromJSON(const JSONValue& obj)
 {
   Quaternion rot;
@@ -1291,6 +1882,57 @@ bool Quaternion::FromJSON(const JSONValue& obj)
 
   return success;
 }
+
+/*--------------------------------------------------------------------------------*/
+/** Read rotation from a streaming JSON or CBOR reader
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename READER>
+static bool ReadQuaternion(READER& reader, Quaternion& obj)
+{
+  static const char *names[] = {"w", "x", "y", "z"};
+  double values[NUMBEROF(names)];
+  uint_t found = 0;                 // bitmask of valid values
+  bool   success = false;
+
+  if (reader.Next() == READER::Token_ObjectStart)
+  {
+    while (reader.Next() == READER::Token_Key)
+    {
+      const std::string& name = reader.GetKey();
+      uint_t i;
+
+      for (i = 0; (i < NUMBEROF(names)) && (name != names[i]); i++) ;
+
+      if (i == NUMBEROF(names)) reader.SkipValue();
+      else if (json::FromJSON(reader, values[i])) found |= 1U << i;
+      else found &= ~(1U << i);
+    }
+
+    success = ((reader.GetToken() == READER::Token_ObjectEnd) && (found == 0x0f));
+  }
+  else reader.Skip();
+
+  if (success)
+  {
+    obj.w = values[0];
+    obj.x = values[1];
+    obj.y = values[2];
+    obj.z = values[3];
+  }
+
+  return success;
+}
+
+bool Quaternion::FromJSON(JSONReader& reader)
+{
+  return ReadQuaternion(reader, *this);
+}
+
+bool Quaternion::FromJSON(CBORReader& reader)
+{
+  return ReadQuaternion(reader, *this);
+}
 #endif
 
 BBC_AUDIOTOOLBOX_END
@@ -3,14 +3,18 @@
 
 #include <math.h>
 #include <string>
+#include <atomic>
 
 #include "ParameterSet.h"
+#include "3DVector.h"
+#include "SequenceLock.h"
 
 BBC_AUDIOTOOLBOX_START
 
 class PositionTransform;
 class ScreenTransform;
 class Quaternion;
+class PositionBatch;
 
 /*--------------------------------------------------------------------------------*/
 /** Position object - holds polar or cartesian co-ordinates with all angles in degrees
@@ -65,15 +69,19 @@ public:
     
   /*--------------------------------------------------------------------------------*/
   /** Return the same position but as polar co-ordinates
+   *
+   * @param fast true to use approximate trig functions (see FastTrig.h)
    */
   /*--------------------------------------------------------------------------------*/
-  Position Polar() const;
+  Position Polar(bool fast = false) const;
 
   /*--------------------------------------------------------------------------------*/
   /** Return the same position but as cartesian co-ordinates
+   *
+   * @param fast true to use approximate trig functions (see FastTrig.h)
    */
   /*--------------------------------------------------------------------------------*/
-  Position Cart() const;
+  Position Cart(bool fast = false) const;
 
   /*--------------------------------------------------------------------------------*/
   /** Limit azimuth and elevation
@@ -254,11 +262,35 @@ public:
   /*--------------------------------------------------------------------------------*/
   virtual void ToJSON(JSONValue& obj) const;
 
+  /*--------------------------------------------------------------------------------*/
+  /** Write object to streaming JSON writer
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void ToJSON(JSONWriter& writer) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write object to streaming CBOR writer
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void ToJSON(CBORWriter& writer) const;
+
   /*--------------------------------------------------------------------------------*/
   /** Set object from JSON
    */
   /*--------------------------------------------------------------------------------*/
   virtual bool FromJSON(const JSONValue& value);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set object from the next value of a streaming JSON reader
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(JSONReader& reader);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set object from the next value of a streaming CBOR reader
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(CBORReader& reader);
 #endif
   
   bool polar;                 // true if co-ordinates are polar
@@ -484,6 +516,21 @@ public:
   /*--------------------------------------------------------------------------------*/
   friend Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, double t);
 
+  /*--------------------------------------------------------------------------------*/
+  /** Perform Spherical Linear intERPolation between many pairs of unit quaternions
+   *
+   * @param q0 array of initial orientations
+   * @param q1 array of final orientations
+   * @param t  A value between 0 and 1 (0 returns q0, 1 returns q1)
+   * @param res array of results (may be either q0 or q1)
+   * @param n number of pairs
+   *
+   * @note equivalent to res[i] = Slerp(q0[i], q1[i], t) but with the range check and
+   * interpolation weights that are common to all pairs only calculated once
+   */
+  /*--------------------------------------------------------------------------------*/
+  friend void Slerp(const Quaternion *q0, const Quaternion *q1, double t, Quaternion *res, uint_t n);
+
   /*--------------------------------------------------------------------------------*/
   /** Extract rotation (either angular or pure Quaternion) from a set of parameters
    */
@@ -496,19 +543,23 @@ public:
   /*--------------------------------------------------------------------------------*/
   void SetParameters(ParameterSet& parameters, const std::string& name) const;
 
-//  void ToRotationMatrix(std::vector<double>& r) const
-//  {
-//    r.resize(9);
-//    r[0] = 1 - (2 * y * y + 2 * z * z);
-//    r[1] = 2 * x * y + 2 * z * w;
-//    r[2] = 2 * x * z - 2 * y * w;
-//    r[3] = 2 * x * y - 2 * z * w;
-//    r[4] = 1 - (2 * x * x + 2 * z * z);
-//    r[5] = 2 * y * z + 2 * x * w;
-//    r[6] = 2 * x * z + 2 * y * w;
-//    r[7] = 2 * y * z - 2 * x * w;
-//    r[8] = 1 - (2 * x * x + 2 * y * y);
-//  }
+  /*--------------------------------------------------------------------------------*/
+  /** Generate 3x3 rotation matrix equivalent to rotating a position by this Quaternion
+   *
+   * @param matrix matrix such that pos * matrix == pos * (*this) (see Position::operator *= (const double vals[3][3]))
+   *
+   * @note for rotating many positions by the same Quaternion this is much cheaper than Quaternion algebra
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ToRotationMatrix(double matrix[3][3]) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Generate 3x3 rotation matrix equivalent to reverse rotating a position by this Quaternion
+   *
+   * @param matrix matrix such that pos * matrix == pos / (*this)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ToInverseRotationMatrix(double matrix[3][3]) const;
 
   /*--------------------------------------------------------------------------------*/
   /** Generate friendly text string
@@ -523,16 +574,129 @@ public:
   /*--------------------------------------------------------------------------------*/
   virtual void ToJSON(JSONValue& obj) const;
 
+  /*--------------------------------------------------------------------------------*/
+  /** Write object to streaming JSON writer
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void ToJSON(JSONWriter& writer) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write object to streaming CBOR writer
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void ToJSON(CBORWriter& writer) const;
+
   /*--------------------------------------------------------------------------------*/
   /** Set object from JSON
    */
   /*--------------------------------------------------------------------------------*/
   virtual bool FromJSON(const JSONValue& value);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set object from the next value of a streaming JSON reader
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(JSONReader& reader);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set object from the next value of a streaming CBOR reader
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(CBORReader& reader);
 #endif
 
   double w, x, y, z;
 };
 
+/*--------------------------------------------------------------------------------*/
+/** Incremental Slerp generator
+ *
+ * Generates evenly spaced Slerp()'s between two Quaternions without any trig per step:
+ * the interpolation weights sin((1-t).angle) and sin(t.angle) are generated by the Chebyshev
+ * recurrence sin((k+1)w) = 2.cos(w).sin(kw) - sin((k-1)w), which costs two multiplies and two
+ * subtractions per step
+ *
+ * The recurrence is re-seeded exactly every ReseedInterval steps to stop rounding errors
+ * accumulating
+ *
+ * Typical usage is per-sample or per sub-block interpolation of a rotation:
+ *
+ *   SlerpGenerator gen(current, target, nsamples);
+ *   gen.Generate(rotations, nsamples);   // rotations[i] == Slerp(current, target, i / nsamples)
+ */
+/*--------------------------------------------------------------------------------*/
+class SlerpGenerator
+{
+public:
+  SlerpGenerator();
+  SlerpGenerator(const Quaternion& q0, const Quaternion& q1, uint_t steps);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start a new interpolation
+   *
+   * @param q0 The initial orientation (returned by the first call to Next())
+   * @param q1 The final orientation (returned, possibly negated, after 'steps' calls to Next() and thereafter)
+   * @param steps number of steps from q0 to q1
+   *
+   * @note Assumes that quaternions have unit-length i.e. have been normalised
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Start(const Quaternion& q0, const Quaternion& q1, uint_t steps);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of steps taken so far
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetStep() const {return step;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the final orientation has been reached
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Finished() const {return (step >= steps);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return the current interpolated Quaternion and advance one step
+   */
+  /*--------------------------------------------------------------------------------*/
+  Quaternion Next();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Generate the next n interpolated Quaternions
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Generate(Quaternion *res, uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Generate the next n interpolated rotations as rotation matrices (see Quaternion::ToRotationMatrix())
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Generate(double (*matrices)[3][3], uint_t n);
+
+  static const uint_t ReseedInterval = 256;
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Calculate interpolation weights for the current step exactly
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Reseed();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Advance weights by one step
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Advance();
+
+protected:
+  Quaternion q0, q1;            // q1 is negated if necessary to take the shortest path
+  double     angle;             // angle between q0 and q1 (0 for linear interpolation)
+  double     scale;             // 1 / sin(angle)
+  double     coeff;             // 2.cos(angle / steps)
+  double     a[2], b[2];        // weights of q0 and q1 for the previous and current step
+  uint_t     step, steps;
+};
+
 /*----------------------------------------------------------------------------------------------------*/
 
 /*--------------------------------------------------------------------------------*/
@@ -600,6 +764,23 @@ public:
   Quaternion rotation;
   Position   posttranslation;
 
+  /*--------------------------------------------------------------------------------*/
+  /** Return 3x4 affine matrix equivalent of transform
+   *
+   * @note pos' = matrix[0..2][0..2] * pos + matrix[0..2][3]
+   * @note the matrix is cached and only recalculated when the transform changes
+   * @note the const methods (including the batch methods) can be called from several
+   * threads at once as long as the transform itself is not being changed
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetMatrix(double matrix[3][4]) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return 3x4 affine matrix equivalent of removing transform
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetInverseMatrix(double matrix[3][4]) const;
+
   /*--------------------------------------------------------------------------------*/
   /** Apply transform to position
    */
@@ -611,6 +792,54 @@ public:
    */
   /*--------------------------------------------------------------------------------*/
   void RemoveTransform(Position& pos) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply transform to batch of positions (one affine matrix multiply per position)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ApplyTransform(PositionBatch& batch) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove transform from batch of positions (one affine matrix multiply per position)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void RemoveTransform(PositionBatch& batch) const;
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Return apply and remove matrices, from the cache if the transform has not changed
+   * since they were calculated
+   *
+   * @note the public members can be changed at any time so the values used to
+   * calculate the matrices are kept for comparison
+   *
+   * @note the cache is protected by a SequenceLock so that concurrent callers never see
+   * a partially updated cache; if another thread is updating the cache, the matrices are
+   * calculated without updating it
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetMatrices(double matrix[3][4], double inverse[3][4]) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Calculate apply and remove matrices
+   */
+  /*--------------------------------------------------------------------------------*/
+  void CalcMatrices(double matrix[3][4], double inverse[3][4]) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return values the matrices are calculated from
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetCacheKey(double key[12]) const;
+
+protected:
+  mutable struct {
+    SequenceLock        seqlock;
+    std::atomic<bool>   valid;          // false if never calculated
+    std::atomic<double> key[12];        // values used to calculate matrices (see GetCacheKey())
+    std::atomic<double> matrix[3][4];
+    std::atomic<double> inverse[3][4];
+  } cache;
 };
 
 /*--------------------------------------------------------------------------------*/
@@ -653,6 +882,16 @@ public:
   /*--------------------------------------------------------------------------------*/
   double GetDistanceScale(const Position& pos) const {return GetDistanceScale(pos.Cart().pos.z);}
 
+  /*--------------------------------------------------------------------------------*/
+  /** Return scale due to perspective for an array of Z co-ordinates
+   *
+   * @param z array of n Z co-ordinates
+   * @param scale array of n entries to receive scales
+   * @param n number of entries
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetDistanceScales(const double *z, double *scale, uint_t n) const;
+
   /*--------------------------------------------------------------------------------*/
   /** Apply transform to position
    */
@@ -664,12 +903,66 @@ public:
    */
   /*--------------------------------------------------------------------------------*/
   void RemoveTransform(Position& pos) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply transform to batch of positions (see PositionBatch::operator *= (const ScreenTransform&))
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ApplyTransform(PositionBatch& batch) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove transform from batch of positions (see PositionBatch::operator /= (const ScreenTransform&))
+   */
+  /*--------------------------------------------------------------------------------*/
+  void RemoveTransform(PositionBatch& batch) const;
   
   double cx, cy;        // screen centre
   double sx, sy;        // screen scale
   double dist;          // perspective distance
 };
 
+/*--------------------------------------------------------------------------------*/
+/** Conversion between Position/Quaternion/transforms and lightweight equivalents (see 3DVector.h)
+ *
+ * @note Positions are converted to cartesian
+ */
+/*--------------------------------------------------------------------------------*/
+inline Vec3d ToVec3d(const Position& pos) {Position cart = pos.Cart(); return Vec3d(cart.pos.x, cart.pos.y, cart.pos.z);}
+inline Vec3f ToVec3f(const Position& pos) {return Vec3f(ToVec3d(pos));}
+template<typename T>
+inline Position ToPosition(const BasicVec3<T>& vec) {return Position((double)vec.x, (double)vec.y, (double)vec.z);}
+
+inline Quatd ToQuatd(const Quaternion& q) {return Quatd(q.w, q.x, q.y, q.z);}
+inline Quatf ToQuatf(const Quaternion& q) {return Quatf(ToQuatd(q));}
+template<typename T>
+inline Quaternion ToQuaternion(const BasicQuat<T>& q) {return Quaternion((double)q.w, (double)q.x, (double)q.y, (double)q.z);}
+
+inline PositionTransformd ToPositionTransformd(const PositionTransform& trans) {return PositionTransformd(ToVec3d(trans.pretranslation), ToQuatd(trans.rotation), ToVec3d(trans.posttranslation));}
+inline PositionTransformf ToPositionTransformf(const PositionTransform& trans) {return PositionTransformf(ToVec3f(trans.pretranslation), ToQuatf(trans.rotation), ToVec3f(trans.posttranslation));}
+template<typename T>
+inline PositionTransform ToPositionTransform(const BasicPositionTransform<T>& trans)
+{
+  PositionTransform res;
+  res.pretranslation  = ToPosition(trans.pretranslation);
+  res.rotation        = ToQuaternion(trans.rotation);
+  res.posttranslation = ToPosition(trans.posttranslation);
+  return res;
+}
+
+inline ScreenTransformd ToScreenTransformd(const ScreenTransform& trans) {return ScreenTransformd(trans.cx, trans.cy, trans.sx, trans.sy, trans.dist);}
+inline ScreenTransformf ToScreenTransformf(const ScreenTransform& trans) {return ScreenTransformf((float)trans.cx, (float)trans.cy, (float)trans.sx, (float)trans.sy, (float)trans.dist);}
+template<typename T>
+inline ScreenTransform ToScreenTransform(const BasicScreenTransform<T>& trans)
+{
+  ScreenTransform res;
+  res.cx   = (double)trans.cx;
+  res.cy   = (double)trans.cy;
+  res.sx   = (double)trans.sx;
+  res.sy   = (double)trans.sy;
+  res.dist = (double)trans.dist;
+  return res;
+}
+
 extern bool        Evaluate(const std::string& str, Position& val);
 extern bool        Evaluate(const std::string& str, Quaternion& val);
 extern std::string StringFrom(const Position& val);
@@ -0,0 +1,346 @@
+#ifndef __3D_VECTOR__
+#define __3D_VECTOR__
+
+#include <math.h>
+
+#include "misc.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Lightweight cartesian 3D vector
+ *
+ * Unlike Position this has no virtual functions and no co-ordinate system flag so it is
+ * trivially copyable and dense (24 bytes for double, 12 bytes for float), making arrays
+ * of them suitable for memcpy and SIMD processing
+ *
+ * Arithmetic is constexpr where C++11 allows
+ *
+ * Use ToVec3d()/ToVec3f() and ToPosition() (3DPosition.h) to convert to and from Position
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename T>
+struct BasicVec3
+{
+  T x, y, z;
+
+  BasicVec3() = default;
+  constexpr BasicVec3(T _x, T _y, T _z) : x(_x), y(_y), z(_z) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Explicit conversion between precisions
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename T2>
+  constexpr explicit BasicVec3(const BasicVec3<T2>& obj) : x((T)obj.x), y((T)obj.y), z((T)obj.z) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Arithmetic
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr BasicVec3 operator + (const BasicVec3& obj) const {return BasicVec3(x + obj.x, y + obj.y, z + obj.z);}
+  constexpr BasicVec3 operator - (const BasicVec3& obj) const {return BasicVec3(x - obj.x, y - obj.y, z - obj.z);}
+  constexpr BasicVec3 operator - ()                     const {return BasicVec3(-x, -y, -z);}
+  constexpr BasicVec3 operator * (T val)                const {return BasicVec3(x * val, y * val, z * val);}
+  constexpr BasicVec3 operator / (T val)                const {return BasicVec3(x / val, y / val, z / val);}
+  friend constexpr BasicVec3 operator * (T val, const BasicVec3& obj) {return obj * val;}
+
+  BasicVec3& operator += (const BasicVec3& obj) {x += obj.x; y += obj.y; z += obj.z; return *this;}
+  BasicVec3& operator -= (const BasicVec3& obj) {x -= obj.x; y -= obj.y; z -= obj.z; return *this;}
+  BasicVec3& operator *= (T val)                {x *= val;   y *= val;   z *= val;   return *this;}
+  BasicVec3& operator /= (T val)                {x /= val;   y /= val;   z /= val;   return *this;}
+
+  constexpr bool operator == (const BasicVec3& obj) const {return ((x == obj.x) && (y == obj.y) && (z == obj.z));}
+  constexpr bool operator != (const BasicVec3& obj) const {return !operator == (obj);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Dot and cross products
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr T         Dot(const BasicVec3& obj)   const {return x * obj.x + y * obj.y + z * obj.z;}
+  constexpr BasicVec3 Cross(const BasicVec3& obj) const {return BasicVec3(y * obj.z - obj.y * z, obj.x * z - x * obj.z, x * obj.y - obj.x * y);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return square of length, length and unit vector version
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr T SquaredLength() const {return Dot(*this);}
+  T           Length()        const {return sqrt(SquaredLength());}
+  BasicVec3   Unit()          const {T d = Length(); return (d > (T)0) ? *this * ((T)1 / d) : *this;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Create vector from polar co-ordinates (same convention as Position)
+   *
+   * @param az azimuth in degrees (anticlockwise from front)
+   * @param el elevation in degrees
+   * @param d distance
+   */
+  /*--------------------------------------------------------------------------------*/
+  static BasicVec3 FromPolar(T az, T el, T d)
+  {
+    const T deg2rad = (T)(M_PI / 180.0);
+    T cel = cos(el * deg2rad);
+
+    return BasicVec3(d * -sin(az * deg2rad) * cel,
+                     d *  cos(az * deg2rad) * cel,
+                     d *  sin(el * deg2rad));
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Convert vector to polar co-ordinates (same convention as Position)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ToPolar(T& az, T& el, T& d) const
+  {
+    const T rad2deg = (T)(180.0 / M_PI);
+
+    az = el = (T)0;
+    d  = Length();
+    if (d > (T)0)
+    {
+      T id = (T)1 / d;
+      el = asin(limited::limit(z * id, (T)-1, (T)1)) * rad2deg;
+      if ((x != (T)0) || (y != (T)0)) az = atan2(-x, y) * rad2deg;
+    }
+  }
+};
+
+typedef BasicVec3<double> Vec3d;
+typedef BasicVec3<float>  Vec3f;
+
+/*--------------------------------------------------------------------------------*/
+/** Lightweight Quaternion
+ *
+ * Non-virtual, trivially copyable equivalent of Quaternion (32 bytes for double, 16 bytes for float)
+ *
+ * Use ToQuatd()/ToQuatf() and ToQuaternion() (3DPosition.h) to convert to and from Quaternion
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename T>
+struct BasicQuat
+{
+  T w, x, y, z;
+
+  BasicQuat() = default;
+  constexpr BasicQuat(T _w, T _x, T _y, T _z) : w(_w), x(_x), y(_y), z(_z) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Explicit conversion between precisions
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename T2>
+  constexpr explicit BasicQuat(const BasicQuat<T2>& obj) : w((T)obj.w), x((T)obj.x), y((T)obj.y), z((T)obj.z) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return identity (no rotation) Quaternion
+   */
+  /*--------------------------------------------------------------------------------*/
+  static constexpr BasicQuat Identity() {return BasicQuat((T)1, (T)0, (T)0, (T)0);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Arithmetic (see Quaternion)
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr BasicQuat operator + (const BasicQuat& obj) const {return BasicQuat(w + obj.w, x + obj.x, y + obj.y, z + obj.z);}
+  constexpr BasicQuat operator - (const BasicQuat& obj) const {return BasicQuat(w - obj.w, x - obj.x, y - obj.y, z - obj.z);}
+  constexpr BasicQuat operator - ()                     const {return BasicQuat(-w, -x, -y, -z);}
+  constexpr BasicQuat operator * (T val)                const {return BasicQuat(w * val, x * val, y * val, z * val);}
+  constexpr BasicQuat operator / (T val)                const {return BasicQuat(w / val, x / val, y / val, z / val);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply second rotation to first
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr BasicQuat operator * (const BasicQuat& obj) const
+  {
+    return BasicQuat(w * obj.w - x * obj.x - y * obj.y - z * obj.z,
+                     w * obj.x + x * obj.w + y * obj.z - z * obj.y,
+                     w * obj.y - x * obj.z + y * obj.w + z * obj.x,
+                     w * obj.z + x * obj.y - y * obj.x + z * obj.w);
+  }
+
+  BasicQuat& operator *= (const BasicQuat& obj) {*this = *this * obj; return *this;}
+
+  constexpr bool operator == (const BasicQuat& obj) const {return ((w == obj.w) && (x == obj.x) && (y == obj.y) && (z == obj.z));}
+  constexpr bool operator != (const BasicQuat& obj) const {return !operator == (obj);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Invert the rotation (conjugate)
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr BasicQuat Invert() const {return BasicQuat(w, -x, -y, -z);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return scalar (dot) product
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr T Dot(const BasicQuat& obj) const {return w * obj.w + x * obj.x + y * obj.y + z * obj.z;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return normalised version
+   */
+  /*--------------------------------------------------------------------------------*/
+  BasicQuat Normalised() const {return *this * ((T)1 / sqrt(Dot(*this)));}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Rotate/reverse rotate vector
+   *
+   * @note uses the same algebra as operator * (const Position&, const Quaternion&) so results are identical
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr BasicVec3<T> Rotate(const BasicVec3<T>& vec) const
+  {
+    return Vector((*this * BasicQuat((T)0, vec.x, vec.y, vec.z)) * Invert());
+  }
+  constexpr BasicVec3<T> InverseRotate(const BasicVec3<T>& vec) const
+  {
+    return Vector((Invert() * BasicQuat((T)0, vec.x, vec.y, vec.z)) * *this);
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Generate 3x3 rotation matrix equivalent to Rotate() (see Quaternion::ToRotationMatrix())
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ToRotationMatrix(T matrix[3][3]) const
+  {
+    T ww = w * w, xx = x * x, yy = y * y, zz = z * z;
+    T xy = x * y, xz = x * z, yz = y * z;
+    T wx = w * x, wy = w * y, wz = w * z;
+
+    matrix[0][0] = ww + xx - yy - zz;
+    matrix[0][1] = (T)2 * (xy - wz);
+    matrix[0][2] = (T)2 * (xz + wy);
+
+    matrix[1][0] = (T)2 * (xy + wz);
+    matrix[1][1] = ww - xx + yy - zz;
+    matrix[1][2] = (T)2 * (yz - wx);
+
+    matrix[2][0] = (T)2 * (xz - wy);
+    matrix[2][1] = (T)2 * (yz + wx);
+    matrix[2][2] = ww - xx - yy + zz;
+  }
+
+protected:
+  static constexpr BasicVec3<T> Vector(const BasicQuat& q) {return BasicVec3<T>(q.x, q.y, q.z);}
+};
+
+typedef BasicQuat<double> Quatd;
+typedef BasicQuat<float>  Quatf;
+
+/*--------------------------------------------------------------------------------*/
+/** Lightweight equivalent of PositionTransform (translate, rotate, translate)
+ *
+ * Translations are always cartesian, use ToPositionTransformd()/ToPositionTransformf() and
+ * ToPositionTransform() (3DPosition.h) to convert to and from PositionTransform
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename T>
+struct BasicPositionTransform
+{
+  BasicVec3<T> pretranslation;
+  BasicQuat<T> rotation;
+  BasicVec3<T> posttranslation;
+
+  BasicPositionTransform() = default;
+  constexpr BasicPositionTransform(const BasicVec3<T>& pre, const BasicQuat<T>& rot, const BasicVec3<T>& post) : pretranslation(pre),
+                                                                                                              rotation(rot),
+                                                                                                              posttranslation(post) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply/remove transform to/from vector
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr BasicVec3<T> Apply(const BasicVec3<T>& vec)  const {return rotation.Rotate(vec + pretranslation) + posttranslation;}
+  constexpr BasicVec3<T> Remove(const BasicVec3<T>& vec) const {return rotation.InverseRotate(vec - posttranslation) - pretranslation;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return 3x4 affine matrix equivalent of transform (see PositionTransform::GetMatrix())
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetMatrix(T matrix[3][4]) const
+  {
+    T      r[3][3];
+    uint_t i, j;
+
+    rotation.ToRotationMatrix(r);
+
+    // pos' = R * (pos + pre) + post = R * pos + (R * pre + post)
+    for (i = 0; i < 3; i++)
+    {
+      for (j = 0; j < 3; j++) matrix[i][j] = r[i][j];
+    }
+    matrix[0][3] = r[0][0] * pretranslation.x + r[0][1] * pretranslation.y + r[0][2] * pretranslation.z + posttranslation.x;
+    matrix[1][3] = r[1][0] * pretranslation.x + r[1][1] * pretranslation.y + r[1][2] * pretranslation.z + posttranslation.y;
+    matrix[2][3] = r[2][0] * pretranslation.x + r[2][1] * pretranslation.y + r[2][2] * pretranslation.z + posttranslation.z;
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply transform to an array of vectors (one affine matrix multiply per vector)
+   *
+   * @note src and dst may be the same array
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Apply(const BasicVec3<T> *src, BasicVec3<T> *dst, uint_t n) const
+  {
+    T      m[3][4];
+    uint_t i;
+
+    GetMatrix(m);
+    for (i = 0; i < n; i++)
+    {
+      BasicVec3<T> vec = src[i];
+      dst[i] = BasicVec3<T>(m[0][0] * vec.x + m[0][1] * vec.y + m[0][2] * vec.z + m[0][3],
+                            m[1][0] * vec.x + m[1][1] * vec.y + m[1][2] * vec.z + m[1][3],
+                            m[2][0] * vec.x + m[2][1] * vec.y + m[2][2] * vec.z + m[2][3]);
+    }
+  }
+};
+
+typedef BasicPositionTransform<double> PositionTransformd;
+typedef BasicPositionTransform<float>  PositionTransformf;
+
+/*--------------------------------------------------------------------------------*/
+/** Lightweight equivalent of ScreenTransform
+ *
+ * Use ToScreenTransformd()/ToScreenTransformf() and ToScreenTransform() (3DPosition.h) to
+ * convert to and from ScreenTransform
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename T>
+struct BasicScreenTransform
+{
+  T cx, cy;             // centre of screen
+  T sx, sy;             // scale of screen
+  T dist;               // perspective distance
+
+  BasicScreenTransform() = default;
+  constexpr BasicScreenTransform(T _cx, T _cy, T _sx, T _sy, T _dist) : cx(_cx), cy(_cy), sx(_sx), sy(_sy), dist(_dist) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return distance scale factor (see ScreenTransform::GetDistanceScale())
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr T GetDistanceScale(T z) const {return (z != dist) ? dist / (dist - z) : (T)1;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply/remove transform to/from vector
+   *
+   * @note z is NOT changed so that the transform can be removed
+   */
+  /*--------------------------------------------------------------------------------*/
+  constexpr BasicVec3<T> Apply(const BasicVec3<T>& vec) const
+  {
+    return BasicVec3<T>(cx + sx * GetDistanceScale(vec.z) * vec.x, cy + sy * GetDistanceScale(vec.z) * vec.y, vec.z);
+  }
+  constexpr BasicVec3<T> Remove(const BasicVec3<T>& vec) const
+  {
+    return BasicVec3<T>((vec.x - cx) / (sx * GetDistanceScale(vec.z)), (vec.y - cy) / (sy * GetDistanceScale(vec.z)), vec.z);
+  }
+};
+
+typedef BasicScreenTransform<double> ScreenTransformd;
+typedef BasicScreenTransform<float>  ScreenTransformf;
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
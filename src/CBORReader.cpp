@@ -0,0 +1,450 @@
+#include <string.h>
+#include <math.h>
+
+#define BBCDEBUG_LEVEL 0
+#include "CBORReader.h"
+
+BBC_AUDIOTOOLBOX_START
+
+CBORReader::CBORReader(const uint8_t *data, size_t len) : start(data),
+                                                          end(data + len),
+                                                          p(data),
+                                                          numval(0.0),
+                                                          argument(0),
+                                                          token(Token_Null),
+                                                          complete(false),
+                                                          boolval(false),
+                                                          integer(false),
+                                                          negative(false)
+{
+}
+
+CBORReader::CBORReader(const std::vector<uint8_t>& data) : start(data.empty() ? NULL : &data[0]),
+                                                           end(data.empty() ? NULL : &data[0] + data.size()),
+                                                           p(start),
+                                                           numval(0.0),
+                                                           argument(0),
+                                                           token(Token_Null),
+                                                           complete(false),
+                                                           boolval(false),
+                                                           integer(false),
+                                                           negative(false)
+{
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Record error and return Token_Error
+ */
+/*--------------------------------------------------------------------------------*/
+CBORReader::TOKEN CBORReader::SetError(const char *msg)
+{
+  Printf(error, "%s at offset %lu", msg, (ulong_t)(p - start));
+  return token = Token_Error;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set token of complete value
+ */
+/*--------------------------------------------------------------------------------*/
+CBORReader::TOKEN CBORReader::SetValueToken(TOKEN tok)
+{
+  if (stack.empty()) complete = true;
+  return token = tok;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read head of data item (skipping any tags)
+ */
+/*--------------------------------------------------------------------------------*/
+bool CBORReader::ReadHead(uint_t& major, uint_t& info, ullong_t& val)
+{
+  while (true)
+  {
+    if (p >= end)
+    {
+      SetError("Unexpected end of data");
+      return false;
+    }
+
+    major = *p >> 5;
+    info  = *p & 0x1f;
+    val   = info;
+    p++;
+
+    if (info < 24)
+    {
+      // argument is in the initial byte
+    }
+    else if (info <= 27)
+    {
+      // big-endian argument of 1, 2, 4 or 8 bytes
+      uint_t n = 1U << (info - 24);
+
+      if ((size_t)(end - p) < n)
+      {
+        SetError("Unexpected end of data");
+        return false;
+      }
+
+      switch (n)
+      {
+        case 1:
+          val = p[0];
+          break;
+
+        case 2:
+          val = ((uint_t)p[0] << 8) | p[1];
+          break;
+
+        case 4:
+          val = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+          break;
+
+        default:
+          val = (((ullong_t)p[0] << 56) | ((ullong_t)p[1] << 48) | ((ullong_t)p[2] << 40) | ((ullong_t)p[3] << 32) |
+                 ((ullong_t)p[4] << 24) | ((ullong_t)p[5] << 16) | ((ullong_t)p[6] << 8)  | p[7]);
+          break;
+      }
+      p += n;
+    }
+    else if ((info < 31) || (major < 2) || (major == 6))
+    {
+      SetError("Invalid additional information");
+      return false;
+    }
+
+    // tags are ignored
+    if (major != 6) break;
+  }
+
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read text string of length len into val
+ */
+/*--------------------------------------------------------------------------------*/
+bool CBORReader::ReadString(uint_t info, ullong_t len, std::string& val)
+{
+  if (info == 31)
+  {
+    SetError("Indefinite length strings not supported");
+    return false;
+  }
+  if (len > (ullong_t)(end - p))
+  {
+    SetError("Unexpected end of data");
+    return false;
+  }
+
+  val.assign((const char *)p, (size_t)len);
+  p += len;
+
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Start object or array containing n items
+ */
+/*--------------------------------------------------------------------------------*/
+CBORReader::TOKEN CBORReader::StartContainer(bool object, uint_t info, ullong_t n)
+{
+  LEVEL level;
+
+  if (stack.size() >= MaxDepth) return SetError("Nesting too deep");
+
+  level.indefinite = (info == 31);
+  level.object     = object;
+  level.expectkey  = true;
+  level.remaining  = 0;
+
+  if (!level.indefinite)
+  {
+    // every item takes at least one byte so reject impossible counts
+    if (n > ((ullong_t)(end - p) / (object ? 2 : 1))) return SetError("Invalid length");
+    level.remaining = object ? n * 2 : n;
+  }
+
+  stack.push_back(level);
+
+  return token = (object ? Token_ObjectStart : Token_ArrayStart);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Convert IEEE half precision float to double
+ */
+/*--------------------------------------------------------------------------------*/
+static double DecodeHalf(uint_t bits)
+{
+  uint_t exponent = (bits >> 10) & 0x1f;
+  uint_t mantissa = bits & 0x3ff;
+  double val;
+
+  if      (exponent == 0)  val = ldexp((double)mantissa, -24);
+  else if (exponent != 31) val = ldexp((double)(mantissa + 0x400), (int)exponent - 25);
+  else                     val = mantissa ? NAN : INFINITY;
+
+  return (bits & 0x8000) ? -val : val;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read next token
+ */
+/*--------------------------------------------------------------------------------*/
+CBORReader::TOKEN CBORReader::Next()
+{
+  uint_t   major, info;
+  ullong_t val;
+
+  if ((token == Token_Error) || (token == Token_End)) return token;
+
+  if (stack.empty())
+  {
+    // top level value complete
+    if (complete)
+    {
+      if (p < end) return SetError("Unexpected data after value");
+      return token = Token_End;
+    }
+
+    // empty data
+    if (p >= end) return token = Token_End;
+  }
+  else
+  {
+    LEVEL& level = stack.back();
+    bool   done;
+
+    if (level.indefinite)
+    {
+      if (p >= end) return SetError("Unexpected end of data");
+      if ((done = (*p == 0xff)) == true)
+      {
+        if (level.object && !level.expectkey) return SetError("Missing value");
+        p++;
+      }
+    }
+    else done = (level.remaining == 0);
+
+    if (done)
+    {
+      bool object = level.object;
+
+      stack.pop_back();
+      return SetValueToken(object ? Token_ObjectEnd : Token_ArrayEnd);
+    }
+
+    if (!level.indefinite) level.remaining--;
+
+    // items of an object alternate between key and value
+    if (level.object)
+    {
+      if (level.expectkey)
+      {
+        level.expectkey = false;
+        if (!ReadHead(major, info, val)) return token;
+        if (major != 3) return SetError("Expected member name");
+        if (!ReadString(info, val, key)) return token;
+        return token = Token_Key;
+      }
+
+      level.expectkey = true;
+    }
+  }
+
+  if (!ReadHead(major, info, val)) return token;
+
+  switch (major)
+  {
+    case 0:
+      integer  = true;
+      negative = false;
+      argument = val;
+      numval   = (double)val;
+      return SetValueToken(Token_Number);
+
+    case 1:
+      integer  = true;
+      negative = true;
+      argument = val;
+      numval   = -1.0 - (double)val;
+      return SetValueToken(Token_Number);
+
+    case 3:
+      if (!ReadString(info, val, str)) return token;
+      return SetValueToken(Token_String);
+
+    case 4:
+      return StartContainer(false, info, val);
+
+    case 5:
+      return StartContainer(true, info, val);
+
+    case 7:
+      switch (info)
+      {
+        case 20:
+        case 21:
+          boolval = (info == 21);
+          return SetValueToken(Token_Bool);
+
+        case 22:
+        case 23:
+          // null and undefined
+          return SetValueToken(Token_Null);
+
+        case 25:
+          integer = false;
+          numval  = DecodeHalf((uint_t)val);
+          return SetValueToken(Token_Number);
+
+        case 26:
+        {
+          uint32_t bits = (uint32_t)val;
+          float    fval;
+
+          memcpy(&fval, &bits, sizeof(fval));
+          integer = false;
+          numval  = fval;
+          return SetValueToken(Token_Number);
+        }
+
+        case 27:
+        {
+          uint64_t bits = val;
+
+          memcpy(&numval, &bits, sizeof(numval));
+          integer = false;
+          return SetValueToken(Token_Number);
+        }
+
+        case 31:
+          return SetError("Unexpected break");
+
+        default:
+          break;
+      }
+      return SetError("Unsupported simple value");
+
+    default:
+      break;
+  }
+
+  return SetError("Byte strings not supported");
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Skip the rest of the value whose first token has just been read
+ */
+/*--------------------------------------------------------------------------------*/
+bool CBORReader::Skip()
+{
+  if ((token == Token_ObjectStart) || (token == Token_ArrayStart))
+  {
+    size_t depth = stack.size();
+
+    while (stack.size() >= depth)
+    {
+      TOKEN tok = Next();
+      if ((tok == Token_Error) || (tok == Token_End)) return false;
+    }
+  }
+
+  return (token != Token_Error);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return value of the last Token_Number as an integer
+ */
+/*--------------------------------------------------------------------------------*/
+bool CBORReader::GetInteger(sllong_t& val) const
+{
+  const ullong_t max = 0x7fffffffffffffffULL;
+
+  if (!integer || (argument > max)) return false;
+
+  val = negative ? -1 - (sllong_t)argument : (sllong_t)argument;
+
+  return true;
+}
+
+bool CBORReader::GetInteger(ullong_t& val) const
+{
+  if (!integer || negative) return false;
+
+  val = argument;
+
+  return true;
+}
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Read the next value into a jsoncpp value
+ */
+/*--------------------------------------------------------------------------------*/
+bool CBORReader::ReadValue(Json::Value& obj)
+{
+  Next();
+  return ReadTokenValue(obj);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read value whose first token has just been read into a jsoncpp value
+ */
+/*--------------------------------------------------------------------------------*/
+bool CBORReader::ReadTokenValue(Json::Value& obj)
+{
+  switch (token)
+  {
+    case Token_Null:
+      obj = Json::Value();
+      return true;
+
+    case Token_Bool:
+      obj = boolval;
+      return true;
+
+    case Token_Number:
+    {
+      sllong_t sval;
+      ullong_t uval;
+
+      // integers are stored as jsoncpp's reader would store them
+      if      (GetInteger(sval)) obj = (Json::Int64)sval;
+      else if (GetInteger(uval)) obj = (Json::UInt64)uval;
+      else obj = numval;
+      return true;
+    }
+
+    case Token_String:
+      obj = str;
+      return true;
+
+    case Token_ArrayStart:
+      obj = Json::Value(Json::arrayValue);
+      while (Next() != Token_ArrayEnd)
+      {
+        if (!ReadTokenValue(obj[obj.size()])) return false;
+      }
+      return true;
+
+    case Token_ObjectStart:
+      obj = Json::Value(Json::objectValue);
+      while (Next() == Token_Key)
+      {
+        Json::Value& member = obj[key];
+
+        Next();
+        if (!ReadTokenValue(member)) return false;
+      }
+      return (token == Token_ObjectEnd);
+
+    default:
+      break;
+  }
+
+  return false;
+}
+#endif
+
+BBC_AUDIOTOOLBOX_END
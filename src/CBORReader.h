@@ -0,0 +1,226 @@
+#ifndef __BBCAT_CBOR_READER__
+#define __BBCAT_CBOR_READER__
+
+#include <string>
+#include <vector>
+
+#include "misc.h"
+
+#if ENABLE_JSON
+#include <json/json.h>
+#endif
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Streaming CBOR (RFC 8949) reader
+ *
+ * Reads CBOR data one token at a time with the same API and tokens as JSONReader so
+ * that anything that can read itself from a JSONReader can also be read from binary
+ * (see FromJSON(CBORReader&) in JSONSerializable)
+ *
+ * The data must follow the JSON data model: map keys must be text strings, tags are
+ * ignored and undefined is read as null.  Both definite and indefinite length maps and
+ * arrays are supported but byte strings and indefinite length strings are not.  As
+ * with JSONReader, maps and arrays may be nested at most MaxDepth deep so that
+ * malformed data cannot cause stack overflow in recursive readers
+ *
+ * Unlike JSONReader, GetInteger() only succeeds for CBOR integers so that integral
+ * floats (e.g. 2.0) can be told apart from integers
+ *
+ * @note the data MUST remain valid for the lifetime of the reader
+ */
+/*--------------------------------------------------------------------------------*/
+class CBORReader
+{
+public:
+  CBORReader(const uint8_t *data, size_t len);
+  CBORReader(const std::vector<uint8_t>& data);
+  ~CBORReader() {}
+
+  enum
+  {
+    MaxDepth = 1000,                    // maximum nesting of maps and arrays
+  };
+
+  typedef enum
+  {
+    Token_Error = 0,                    // invalid data (see GetError())
+    Token_End,                          // end of data
+    Token_ObjectStart,
+    Token_ObjectEnd,
+    Token_ArrayStart,
+    Token_ArrayEnd,
+    Token_Key,                          // name of object member (see GetKey())
+    Token_Null,
+    Token_Bool,
+    Token_Number,
+    Token_String,
+  } TOKEN;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read next token
+   */
+  /*--------------------------------------------------------------------------------*/
+  TOKEN Next();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return last token read
+   */
+  /*--------------------------------------------------------------------------------*/
+  TOKEN GetToken() const {return token;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Skip the rest of the value whose first token has just been read
+   *
+   * @note does nothing unless the last token was Token_ObjectStart or Token_ArrayStart
+   *
+   * @return false if the data is invalid
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Skip();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read and skip the next value
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool SkipValue() {Next(); return Skip();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the value whose first token has just been read is a scalar
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsScalar() const {return ((token >= Token_Null) && (token <= Token_String));}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return name of the last object member
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::string& GetKey() const {return key;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value of the last Token_Bool
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool GetBool() const {return boolval;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value of the last Token_String
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::string& GetString() const {return str;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value of the last Token_Number as a double
+   */
+  /*--------------------------------------------------------------------------------*/
+  double GetDouble() const {return numval;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value of the last Token_Number as an integer
+   *
+   * @return false if the number is not a CBOR integer or is outside the range of the type
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool GetInteger(sllong_t& val) const;
+  bool GetInteger(ullong_t& val) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the last Token_Number was a CBOR integer
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsInteger() const {return integer;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return description of error
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::string& GetError() const {return error;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return offset of the current position within the data
+   */
+  /*--------------------------------------------------------------------------------*/
+  size_t GetPosition() const {return p - start;}
+
+#if ENABLE_JSON
+  /*--------------------------------------------------------------------------------*/
+  /** Read the next value into a jsoncpp value
+   *
+   * This allows objects that do not support streaming to be read from the stream
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadValue(Json::Value& obj);
+#endif
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Read head of data item (skipping any tags)
+   *
+   * @param major major type (0 - 7)
+   * @param info additional information (0 - 31)
+   * @param val argument (unless info is 31, indefinite length)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadHead(uint_t& major, uint_t& info, ullong_t& val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read text string of length len into val
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadString(uint_t info, ullong_t len, std::string& val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start object or array containing n items
+   */
+  /*--------------------------------------------------------------------------------*/
+  TOKEN StartContainer(bool object, uint_t info, ullong_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Record error and return Token_Error
+   */
+  /*--------------------------------------------------------------------------------*/
+  TOKEN SetError(const char *msg);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set token of complete value
+   */
+  /*--------------------------------------------------------------------------------*/
+  TOKEN SetValueToken(TOKEN tok);
+
+#if ENABLE_JSON
+  /*--------------------------------------------------------------------------------*/
+  /** Read value whose first token has just been read into a jsoncpp value
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadTokenValue(Json::Value& obj);
+#endif
+
+  typedef struct
+  {
+    ullong_t remaining;                 // number of items (keys and values) left
+    bool     object;
+    bool     indefinite;                // ended by a 'break' rather than a count
+    bool     expectkey;                 // next item in an object is a key
+  } LEVEL;
+
+protected:
+  const uint8_t      *start;
+  const uint8_t      *end;
+  const uint8_t      *p;
+  std::vector<LEVEL> stack;
+  std::string        key;
+  std::string        str;
+  std::string        error;
+  double             numval;
+  ullong_t           argument;          // integer argument (value is -1 - argument if negative)
+  TOKEN              token;
+  bool               complete;          // top level value read
+  bool               boolval;
+  bool               integer;
+  bool               negative;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
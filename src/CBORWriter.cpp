@@ -0,0 +1,217 @@
+#include <string.h>
+#include <float.h>
+
+#define BBCDEBUG_LEVEL 0
+#include "CBORWriter.h"
+#include "json.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Encode head (major type and argument) into data
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t CBORWriter::EncodeHead(uint8_t *data, uint8_t major, ullong_t val)
+{
+  uint_t i, n;
+
+  if (val < 24)
+  {
+    data[0] = major | (uint8_t)val;
+    return 1;
+  }
+
+  if      (val <= 0xffULL)       {data[0] = major | 24; n = 1;}
+  else if (val <= 0xffffULL)     {data[0] = major | 25; n = 2;}
+  else if (val <= 0xffffffffULL) {data[0] = major | 26; n = 4;}
+  else                           {data[0] = major | 27; n = 8;}
+
+  // big-endian argument
+  for (i = n; i > 0; i--, val >>= 8) data[i] = (uint8_t)val;
+
+  return n + 1;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append head (major type and argument)
+ */
+/*--------------------------------------------------------------------------------*/
+void CBORWriter::AppendHead(uint8_t major, ullong_t val)
+{
+  uint8_t data[9];
+  uint_t  n = EncodeHead(data, major, val);
+
+  buffer.insert(buffer.end(), data, data + n);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Start/end object or array
+ */
+/*--------------------------------------------------------------------------------*/
+void CBORWriter::StartContainer(bool object)
+{
+  LEVEL level;
+
+  BeginValue();
+
+  level.pos    = buffer.size();
+  level.count  = 0;
+  level.object = object;
+  stack.push_back(level);
+
+  buffer.push_back(object ? Major_Map : Major_Array);
+}
+
+void CBORWriter::EndContainer(bool object)
+{
+  if (!stack.empty() && (stack.back().object == object))
+  {
+    const LEVEL& level = stack.back();
+    uint8_t data[9];
+    uint_t  n = EncodeHead(data, object ? Major_Map : Major_Array, level.count);
+
+    // replace the head written at the start, making room for a longer one if necessary
+    if (n > 1) buffer.insert(buffer.begin() + level.pos + 1, data + 1, data + n);
+    buffer[level.pos] = data[0];
+
+    stack.pop_back();
+  }
+  else BBCERROR("CBORWriter: end of %s without matching start", object ? "object" : "array");
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write name of next object member
+ */
+/*--------------------------------------------------------------------------------*/
+void CBORWriter::Key(const char *name)
+{
+  Key(name, strlen(name));
+}
+
+void CBORWriter::Key(const char *name, size_t len)
+{
+  if (!stack.empty() && stack.back().object)
+  {
+    stack.back().count++;
+    AppendHead(Major_Text, len);
+    buffer.insert(buffer.end(), (const uint8_t *)name, (const uint8_t *)name + len);
+  }
+  else BBCERROR("CBORWriter: key '%s' outside of object", std::string(name, len).c_str());
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write values
+ */
+/*--------------------------------------------------------------------------------*/
+void CBORWriter::Int(sllong_t val)
+{
+  BeginValue();
+  // negative integers are encoded as -1 - argument
+  if (val < 0) AppendHead(Major_NegInt, (ullong_t)(-(val + 1)));
+  else         AppendHead(Major_UInt, (ullong_t)val);
+}
+
+void CBORWriter::Double(double val)
+{
+  uint8_t data[9];
+  uint_t  i, n;
+
+  BeginValue();
+
+  if ((val >= -FLT_MAX) && (val <= FLT_MAX) && ((double)(float)val == val))
+  {
+    // exact as a 32-bit float
+    float    fval = (float)val;
+    uint32_t bits;
+
+    memcpy(&bits, &fval, sizeof(bits));
+    data[0] = Major_Simple | 26;
+    for (i = 4; i > 0; i--, bits >>= 8) data[i] = (uint8_t)bits;
+    n = 5;
+  }
+  else
+  {
+    uint64_t bits;
+
+    memcpy(&bits, &val, sizeof(bits));
+    data[0] = Major_Simple | 27;
+    for (i = 8; i > 0; i--, bits >>= 8) data[i] = (uint8_t)bits;
+    n = 9;
+  }
+
+  buffer.insert(buffer.end(), data, data + n);
+}
+
+void CBORWriter::String(const char *str)
+{
+  String(str, strlen(str));
+}
+
+void CBORWriter::String(const char *str, size_t len)
+{
+  BeginValue();
+  AppendHead(Major_Text, len);
+  buffer.insert(buffer.end(), (const uint8_t *)str, (const uint8_t *)str + len);
+}
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Write jsoncpp value
+ */
+/*--------------------------------------------------------------------------------*/
+void CBORWriter::Write(const Json::Value& obj)
+{
+  switch (obj.type())
+  {
+    case Json::nullValue:
+      Null();
+      break;
+
+    case Json::intValue:
+      Int(obj.asInt64());
+      break;
+
+    case Json::uintValue:
+      UInt(obj.asUInt64());
+      break;
+
+    case Json::realValue:
+      Double(obj.asDouble());
+      break;
+
+    case Json::stringValue:
+      String(obj.asString());
+      break;
+
+    case Json::booleanValue:
+      Bool(obj.asBool());
+      break;
+
+    case Json::arrayValue:
+    {
+      Json::ArrayIndex i;
+
+      StartArray();
+      for (i = 0; i < obj.size(); i++) Write(obj[i]);
+      EndArray();
+      break;
+    }
+
+    case Json::objectValue:
+    {
+      Json::Value::const_iterator it;
+
+      StartObject();
+      for (it = obj.begin(); it != obj.end(); ++it)
+      {
+        Key(JSON_MEMBER_NAME(it));
+        Write(*it);
+      }
+      EndObject();
+      break;
+    }
+  }
+}
+#endif
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,145 @@
+#ifndef __BBCAT_CBOR_WRITER__
+#define __BBCAT_CBOR_WRITER__
+
+#include <vector>
+#include <string>
+
+#include "misc.h"
+
+#if ENABLE_JSON
+#include <json/json.h>
+#endif
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Streaming CBOR (RFC 8949) writer
+ *
+ * Writes the same data as JSONWriter (objects, arrays, strings, numbers, bools and
+ * null) in the compact binary CBOR encoding so that anything that can write itself
+ * to a JSONWriter can also be written as binary (see ToJSON(CBORWriter&) in
+ * JSONSerializable) using the same member names
+ *
+ * Integers are written in the smallest encoding and doubles as 32-bit floats if that
+ * is exact, otherwise as 64-bit floats, so no precision is lost
+ *
+ * The API is the same as JSONWriter and, as with JSONWriter, the buffer is kept
+ * between documents (see Reset())
+ */
+/*--------------------------------------------------------------------------------*/
+class CBORWriter
+{
+public:
+  CBORWriter() {}
+  ~CBORWriter() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Clear output to start a new document (keeping the buffer)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Reset() {buffer.clear(); stack.clear();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start/end object (CBOR map) or array
+   */
+  /*--------------------------------------------------------------------------------*/
+  void StartObject() {StartContainer(true);}
+  void EndObject()   {EndContainer(true);}
+  void StartArray()  {StartContainer(false);}
+  void EndArray()    {EndContainer(false);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write name of next object member
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Key(const char *name);
+  void Key(const char *name, size_t len);
+  void Key(const std::string& name) {Key(name.c_str(), name.length());}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write values
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Null()           {BeginValue(); buffer.push_back(0xf6);}
+  void Bool(bool val)   {BeginValue(); buffer.push_back(val ? 0xf5 : 0xf4);}
+  void Int(sllong_t val);
+  void UInt(ullong_t val) {BeginValue(); AppendHead(Major_UInt, val);}
+  void Double(double val);
+  void String(const char *str);
+  void String(const char *str, size_t len);
+  void String(const std::string& str) {String(str.c_str(), str.length());}
+
+#if ENABLE_JSON
+  /*--------------------------------------------------------------------------------*/
+  /** Write jsoncpp value
+   *
+   * This allows objects that do not support streaming to be written to the stream
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Write(const Json::Value& obj);
+#endif
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return encoded data
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::vector<uint8_t>& GetData() const {return buffer;}
+
+  enum
+  {
+    Major_UInt   = 0x00,
+    Major_NegInt = 0x20,
+    Major_Bytes  = 0x40,
+    Major_Text   = 0x60,
+    Major_Array  = 0x80,
+    Major_Map    = 0xa0,
+    Major_Tag    = 0xc0,
+    Major_Simple = 0xe0,
+  };
+
+protected:
+  typedef struct
+  {
+    size_t   pos;                       // offset of container's head
+    ullong_t count;                     // number of members/elements written
+    bool     object;
+  } LEVEL;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start/end object or array
+   *
+   * @note the number of members/elements is only known at the end so the head is
+   * written for zero items and then updated
+   */
+  /*--------------------------------------------------------------------------------*/
+  void StartContainer(bool object);
+  void EndContainer(bool object);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Prepare for a value (counting elements of arrays)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void BeginValue() {if (!stack.empty() && !stack.back().object) stack.back().count++;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Encode head (major type and argument) into data
+   *
+   * @return number of bytes
+   */
+  /*--------------------------------------------------------------------------------*/
+  static uint_t EncodeHead(uint8_t *data, uint8_t major, ullong_t val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append head (major type and argument)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void AppendHead(uint8_t major, ullong_t val);
+
+protected:
+  std::vector<uint8_t> buffer;
+  std::vector<LEVEL>   stack;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -18,7 +18,9 @@ public:
   CallbackHook(const CallbackHook& obj) : fn(obj.fn), arg(obj.arg) {}
   ~CallbackHook() {}
 
-  void Call() {(*fn)(arg);}
+  void Call() const {(*fn)(arg);}
+
+  bool Matches(void (*_fn)(void *arg), void *_arg) const {return ((_fn == fn) && (_arg == arg));}
 
   typedef std::vector<CallbackHook> LIST;
 
@@ -0,0 +1,162 @@
+
+#include "OSCompiler.h"
+
+#ifdef TARGET_OS_UNIXBSD
+#include <unistd.h>
+#endif
+
+#ifdef TARGET_OS_WINDOWS
+#include "Windows_uSleep.h"
+#endif
+
+#define BBCDEBUG_LEVEL 1
+#include "CallbackList.h"
+
+BBC_AUDIOTOOLBOX_START
+
+CallbackList::CallbackList() : tlock("CallbackList"),
+                               list(new CallbackHook::LIST),
+                               epoch(0)
+{
+  readers[0] = readers[1] = 0;
+}
+
+CallbackList::~CallbackList()
+{
+  delete list.load();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Mark start of read of current snapshot, returning the snapshot
+ *
+ * The reader registers itself against the current epoch and then checks that the
+ * epoch hasn't changed; if it has, a writer may already have finished waiting
+ * for that epoch's readers so the reader must retry
+ */
+/*--------------------------------------------------------------------------------*/
+const CallbackHook::LIST *CallbackList::ReadStart(uint_t& slot) const
+{
+  uint_t e;
+
+  while (true)
+  {
+    e    = epoch.load();
+    slot = e & 1;
+    readers[slot]++;
+    if (epoch.load() == e) break;
+    readers[slot]--;
+  }
+
+  return list.load();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Mark end of read of snapshot
+ */
+/*--------------------------------------------------------------------------------*/
+void CallbackList::ReadEnd(uint_t slot) const
+{
+  readers[slot]--;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Publish new snapshot and delete old one once no readers can be using it
+ *
+ * @note must be called with tlock held
+ */
+/*--------------------------------------------------------------------------------*/
+void CallbackList::Publish(CallbackHook::LIST *newlist)
+{
+  CallbackHook::LIST *oldlist = list.exchange(newlist);
+  uint_t e = epoch.fetch_add(1);
+
+  // any reader that could have seen the old list is registered against the old epoch
+  while (readers[e & 1].load()) usleep(10);
+
+  delete oldlist;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add hook to end of list
+ */
+/*--------------------------------------------------------------------------------*/
+void CallbackList::Add(const CallbackHook& hook)
+{
+  ThreadLock lock(tlock);
+  CallbackHook::LIST *newlist = new CallbackHook::LIST(*list.load());
+
+  newlist->push_back(hook);
+
+  Publish(newlist);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove all hooks matching fn and arg
+ *
+ * @return true if at least one hook was removed
+ */
+/*--------------------------------------------------------------------------------*/
+bool CallbackList::Remove(void (*fn)(void *arg), void *arg)
+{
+  ThreadLock lock(tlock);
+  const CallbackHook::LIST& oldlist = *list.load();
+  CallbackHook::LIST *newlist = new CallbackHook::LIST;
+  uint_t i;
+
+  newlist->reserve(oldlist.size());
+  for (i = 0; i < oldlist.size(); i++)
+  {
+    if (!oldlist[i].Matches(fn, arg)) newlist->push_back(oldlist[i]);
+  }
+
+  if (newlist->size() == oldlist.size())
+  {
+    // nothing removed, no need to publish
+    delete newlist;
+    return false;
+  }
+
+  Publish(newlist);
+
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove all hooks
+ */
+/*--------------------------------------------------------------------------------*/
+void CallbackList::Clear()
+{
+  ThreadLock lock(tlock);
+
+  Publish(new CallbackHook::LIST);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return number of hooks in list
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t CallbackList::Count() const
+{
+  uint_t slot;
+  uint_t n = (uint_t)ReadStart(slot)->size();
+  ReadEnd(slot);
+  return n;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Call every hook in the list (lock-free)
+ */
+/*--------------------------------------------------------------------------------*/
+void CallbackList::Call() const
+{
+  uint_t slot;
+  const CallbackHook::LIST& hooks = *ReadStart(slot);
+  uint_t i;
+
+  for (i = 0; i < hooks.size(); i++) hooks[i].Call();
+
+  ReadEnd(slot);
+}
+
+BBC_AUDIOTOOLBOX_END
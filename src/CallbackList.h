@@ -0,0 +1,89 @@
+#ifndef __LOCK_FREE_CALLBACK_LIST__
+#define __LOCK_FREE_CALLBACK_LIST__
+
+#include <vector>
+#include <atomic>
+
+#include "CallbackHook.h"
+#include "ThreadLock.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Copy-on-write list of CallbackHooks that can be called without locking
+ *
+ * Call() iterates an immutable snapshot of the list without taking any locks, making it
+ * suitable for calling from an audio thread
+ *
+ * Add(), Remove() and Clear() build a new snapshot, publish it atomically and then wait
+ * for any readers of the old snapshot to finish before deleting it (RCU-style).  These
+ * are therefore relatively expensive and should NOT be called from the audio thread
+ *
+ * @note hooks MUST NOT modify the list they are called from (this would deadlock)
+ */
+/*--------------------------------------------------------------------------------*/
+class CallbackList
+{
+public:
+  CallbackList();
+  ~CallbackList();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add hook to end of list
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Add(const CallbackHook& hook);
+  void Add(void (*fn)(void *arg), void *arg) {Add(CallbackHook(fn, arg));}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove all hooks matching fn and arg
+   *
+   * @return true if at least one hook was removed
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Remove(void (*fn)(void *arg), void *arg);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove all hooks
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Clear();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of hooks in list
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Count() const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Call every hook in the list (lock-free)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Call() const;
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Mark start/end of read of current snapshot, returning the snapshot
+   */
+  /*--------------------------------------------------------------------------------*/
+  const CallbackHook::LIST *ReadStart(uint_t& slot) const;
+  void ReadEnd(uint_t slot) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Publish new snapshot and delete old one once no readers can be using it
+   *
+   * @note must be called with tlock held
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Publish(CallbackHook::LIST *newlist);
+
+protected:
+  ThreadLockObject                    tlock;          // serialises writers only
+  std::atomic<CallbackHook::LIST *>   list;
+  std::atomic<uint_t>                 epoch;
+  mutable std::atomic<uint_t>         readers[2];     // number of active readers in each (even/odd) epoch
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -1,23 +1,43 @@
-
 #include <math.h>
+#include <string.h>
 
 #define BBCDEBUG_LEVEL 0
 #include "DistanceModel.h"
+#include "PositionBatch.h"
 
 BBC_AUDIOTOOLBOX_START
 
+DistanceModel::DistanceModel(double decaypower, double speedofsound)
+{
+  SetParameters(decaypower, speedofsound, LevelMode_Exact);
+}
+
+DistanceModel::DistanceModel(const DistanceModel& obj)
+{
+  PARAMETERS params;
+
+  obj.GetParameters(params);
+  SetParameters(params.decaypower, params.speedofsound, params.levelmode);
+}
+
 /*--------------------------------------------------------------------------------*/
-/** A simple singleton to handle time and level calculation based on distance
- *
+/** Assignment operator
  */
 /*--------------------------------------------------------------------------------*/
-DistanceModel::DistanceModel() : decaypower(2.0),
-                                 speedofsound(340.0)
+DistanceModel& DistanceModel::operator = (const DistanceModel& obj)
 {
+  if (&obj != this)
+  {
+    PARAMETERS params;
+
+    obj.GetParameters(params);
+    SetParameters(params.decaypower, params.speedofsound, params.levelmode);
+  }
+  return *this;
 }
 
 /*--------------------------------------------------------------------------------*/
-/** Return singleton instance of this object 
+/** Return shared default model
  */
 /*--------------------------------------------------------------------------------*/
 DistanceModel& DistanceModel::Get()
@@ -27,21 +47,73 @@ DistanceModel& DistanceModel::Get()
 }
 
 /*--------------------------------------------------------------------------------*/
-/** Get level due to distance
+/** Return consistent set of parameters (lock-free)
+ */
+/*--------------------------------------------------------------------------------*/
+void DistanceModel::GetParameters(PARAMETERS& params) const
+{
+  uint_t seq;
+
+  do
+  {
+    seq = seqlock.ReadStart();
+    params.decaypower      = decaypower.load(std::memory_order_relaxed);
+    params.speedofsound    = speedofsound.load(std::memory_order_relaxed);
+    params.log2decaypower  = log2decaypower.load(std::memory_order_relaxed);
+    params.invspeedofsound = invspeedofsound.load(std::memory_order_relaxed);
+    params.levelmode       = levelmode.load(std::memory_order_relaxed);
+  }
+  while (seqlock.ReadRetry(seq));
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set decay power due to distance
+ */
+/*--------------------------------------------------------------------------------*/
+void DistanceModel::SetDecayPower(double power)
+{
+  seqlock.WriteStart();
+  decaypower.store(power, std::memory_order_relaxed);
+  log2decaypower.store(log2(power), std::memory_order_relaxed);
+  seqlock.WriteEnd();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set speed of sound in m/s
+ */
+/*--------------------------------------------------------------------------------*/
+void DistanceModel::SetSpeedOfSound(double speed)
+{
+  seqlock.WriteStart();
+  speedofsound.store(speed, std::memory_order_relaxed);
+  invspeedofsound.store((speed > 0.0) ? 1.0 / speed : 0.0, std::memory_order_relaxed);
+  seqlock.WriteEnd();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set method used to calculate levels
  */
 /*--------------------------------------------------------------------------------*/
-double DistanceModel::GetLevel(double d) const
+void DistanceModel::SetLevelMode(LEVELMODE mode)
 {
-  return pow(decaypower, -d);
+  seqlock.WriteStart();
+  levelmode.store(mode, std::memory_order_relaxed);
+  seqlock.WriteEnd();
 }
 
 /*--------------------------------------------------------------------------------*/
-/** Get delay (in s or samples if delayscale = samplerate) due to distance
+/** Store parameters and precomputed values
  */
 /*--------------------------------------------------------------------------------*/
-double DistanceModel::GetDelay(double d, double delayscale) const
+void DistanceModel::SetParameters(double power, double speed, LEVELMODE mode)
 {
-  return (speedofsound > 0.0) ? delayscale * d / speedofsound : 0.0;
+  seqlock.WriteStart();
+  decaypower.store(power, std::memory_order_relaxed);
+  log2decaypower.store(log2(power), std::memory_order_relaxed);
+  speedofsound.store(speed, std::memory_order_relaxed);
+  invspeedofsound.store((speed > 0.0) ? 1.0 / speed : 0.0, std::memory_order_relaxed);
+  levelmode.store(mode, std::memory_order_relaxed);
+  seqlock.WriteEnd();
 }
 
 /*--------------------------------------------------------------------------------*/
@@ -50,35 +122,135 @@ double DistanceModel::GetDelay(double d, double delayscale) const
 /*--------------------------------------------------------------------------------*/
 void DistanceModel::GetLevelAndDelay(double d, double& level, double& delay, double delayscale) const
 {
-  level = GetLevel(d);
-  delay = GetDelay(d, delayscale);
+  PARAMETERS params;
+
+  GetParameters(params);
+  level = GetLevel(params, d);
+  delay = GetDelay(params, d, delayscale);
 }
 
 /*--------------------------------------------------------------------------------*/
 /** Get level due to distance
  */
 /*--------------------------------------------------------------------------------*/
-double DistanceModel::GetLevel(const Position& pos) const
+double DistanceModel::GetLevel(const PARAMETERS& params, double d)
 {
-  return GetLevel(pos.Polar().pos.d);
+  double level;
+
+  GetLevels(params, &d, &level, 1);
+
+  return level;
 }
 
 /*--------------------------------------------------------------------------------*/
-/** Get delay (in s or samples if delayscale = samplerate) due to distance
+/** Get levels for an array of distances
  */
 /*--------------------------------------------------------------------------------*/
-double DistanceModel::GetDelay(const Position& pos, double delayscale) const
+void DistanceModel::GetLevels(const PARAMETERS& params, const double *d, double *level, uint_t n)
 {
-  return GetDelay(pos.Polar().pos.d, delayscale);
+  uint_t i;
+
+  // the fast methods rely on log2(decaypower) being finite
+  if ((params.levelmode == LevelMode_Exact) || !(params.decaypower > 0.0))
+  {
+    for (i = 0; i < n; i++) level[i] = pow(params.decaypower, -d[i]);
+  }
+  else
+  {
+    // decaypower^-d = 2^-(d * log2(decaypower))
+    const double k = params.log2decaypower;
+
+    if (params.levelmode == LevelMode_Exp2)
+    {
+      for (i = 0; i < n; i++) level[i] = exp2(-d[i] * k);
+    }
+    else
+    {
+      for (i = 0; i < n; i++) level[i] = d[i] * k;
+      TableExp2(level, level, n);
+    }
+  }
 }
 
 /*--------------------------------------------------------------------------------*/
-/** Get level and delay due to distance
+/** Get delays (in s or samples if delayscale = samplerate) for an array of distances
  */
 /*--------------------------------------------------------------------------------*/
-void DistanceModel::GetLevelAndDelay(const Position& pos, double& level, double& delay, double delayscale) const
+void DistanceModel::GetDelays(const PARAMETERS& params, const double *d, double *delay, uint_t n, double delayscale)
 {
-  GetLevelAndDelay(pos.Polar().pos.d, level, delay, delayscale);
+  const double scale = delayscale * params.invspeedofsound;
+  uint_t i;
+
+  for (i = 0; i < n; i++) delay[i] = d[i] * scale;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Get levels and delays for an array of distances
+ */
+/*--------------------------------------------------------------------------------*/
+void DistanceModel::GetLevelsAndDelays(const PARAMETERS& params, const double *d, double *level, double *delay, uint_t n, double delayscale)
+{
+  if (level) GetLevels(params, d, level, n);
+  if (delay) GetDelays(params, d, delay, n, delayscale);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Get levels and delays for a batch of positions
+ */
+/*--------------------------------------------------------------------------------*/
+void DistanceModel::GetLevelsAndDelays(const PARAMETERS& params, const PositionBatch& batch, double *level, double *delay, double delayscale)
+{
+  uint_t n = batch.Size();
+
+  // use the output arrays to hold the distances (all calculations work in-place)
+  if (delay)
+  {
+    batch.GetDistances(delay);
+    if (level) GetLevels(params, delay, level, n);
+    GetDelays(params, delay, delay, n, delayscale);
+  }
+  else if (level)
+  {
+    batch.GetDistances(level);
+    GetLevels(params, level, level, n);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Calculate 2^-x for an array of values using interpolated table
+ *
+ * 2^-x = 2^-i * 2^-f where i = floor(x) and 0 <= f < 1, the first part is exact (constructed
+ * directly as an IEEE double) and the second is linearly interpolated from a table
+ */
+/*--------------------------------------------------------------------------------*/
+void DistanceModel::TableExp2(const double *x, double *res, uint_t n)
+{
+  static const uint_t TableSize = 1024;
+  static const struct TABLE {
+    TABLE() {
+      uint_t i;
+      for (i = 0; i < NUMBEROF(values); i++) values[i] = exp2(-(double)i / (double)TableSize);
+    }
+    // extra entry for when (val - ip) rounds up to 1
+    double values[TableSize + 2];
+  } table;
+  uint_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    // limit to the range of normal doubles (results outside would be denormal/0 or infinity)
+    double val  = limited::limit(x[i], -1000.0, 1000.0);
+    // floor() by truncation of a positive value
+    sint_t ip   = (sint_t)(val + 1024.0) - 1024;
+    double pos  = (val - (double)ip) * (double)TableSize;
+    uint_t ind  = (uint_t)pos;
+    double frac = pos - (double)ind;
+    ullong_t bits = (ullong_t)(1023 - ip) << 52;     // 2^-ip
+    double scale;
+
+    memcpy(&scale, &bits, sizeof(scale));
+    res[i] = scale * (table.values[ind] + frac * (table.values[ind + 1] - table.values[ind]));
+  }
 }
 
 BBC_AUDIOTOOLBOX_END
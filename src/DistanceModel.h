@@ -1,49 +1,115 @@
 #ifndef __DISTANCE_MODEL__
 #define __DISTANCE_MODEL__
 
+#include <math.h>
+
+#include <atomic>
+
 #include "3DPosition.h"
+#include "SequenceLock.h"
 
 BBC_AUDIOTOOLBOX_START
 
 /*--------------------------------------------------------------------------------*/
-/** A simple singleton to handle time and level calculation based on distance
+/** Time and level calculation based on distance
  *
+ * Each render session can have its own model, Get() returns a shared default model
+ * for code that does not need its own
+ *
+ * The parameters may be changed from any thread and read from any number of threads
+ * without locking: they are protected by a sequence lock so GetParameters() always
+ * returns a consistent, immutable snapshot.  Render threads should take a snapshot
+ * once per block and use the static calculation functions on it.
  */
 /*--------------------------------------------------------------------------------*/
 class DistanceModel
 {
 public:
+  DistanceModel(double decaypower = 2.0, double speedofsound = 340.0);
+  DistanceModel(const DistanceModel& obj);
+  ~DistanceModel() {}
+
   /*--------------------------------------------------------------------------------*/
-  /** Return singleton instance of this object 
+  /** Assignment operator
+   */
+  /*--------------------------------------------------------------------------------*/
+  DistanceModel& operator = (const DistanceModel& obj);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return shared default model
    */
   /*--------------------------------------------------------------------------------*/
   static DistanceModel& Get();
 
+  /*--------------------------------------------------------------------------------*/
+  /** Method used to calculate levels
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef enum
+  {
+    LevelMode_Exact = 0,                // pow(decaypower, -d)
+    LevelMode_Exp2,                     // exp2(-d * log2(decaypower)), relative error < 1e-13
+    LevelMode_Table,                    // linearly interpolated table of 2^-x, relative error < 1e-7
+  } LEVELMODE;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Consistent set of parameters plus values precomputed from them
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef struct
+  {
+    double    decaypower;
+    double    speedofsound;
+    double    log2decaypower;           // log2(decaypower)
+    double    invspeedofsound;          // 1 / speedofsound (or 0 for no delay)
+    LEVELMODE levelmode;
+  } PARAMETERS;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return consistent set of parameters (lock-free)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void       GetParameters(PARAMETERS& params) const;
+  PARAMETERS GetParameters() const {PARAMETERS params; GetParameters(params); return params;}
+
   /*--------------------------------------------------------------------------------*/
   /** Set decay power due to distance (==2 for inverse square law, set to 0 for no decay)
    */
   /*--------------------------------------------------------------------------------*/
-  void SetDecayPower(double power)   {decaypower   = power;}
-  double GetDecayPower() const       {return decaypower;}
+  void SetDecayPower(double power);
+  double GetDecayPower() const       {return decaypower.load(std::memory_order_relaxed);}
 
   /*--------------------------------------------------------------------------------*/
   /** Set speed of sound in m/s (set to 0 for no delay)
    */
   /*--------------------------------------------------------------------------------*/
-  void SetSpeedOfSound(double speed) {speedofsound = speed;}
-  double GetSpeedOfSound() const     {return speedofsound;}
+  void SetSpeedOfSound(double speed);
+  double GetSpeedOfSound() const     {return speedofsound.load(std::memory_order_relaxed);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set method used to calculate levels
+   */
+  /*--------------------------------------------------------------------------------*/
+  void      SetLevelMode(LEVELMODE mode);
+  LEVELMODE GetLevelMode() const     {return levelmode.load(std::memory_order_relaxed);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return distance of position from the origin (without converting to polar)
+   */
+  /*--------------------------------------------------------------------------------*/
+  static double GetDistance(const Position& pos) {return pos.polar ? pos.pos.d : sqrt(pos.pos.x * pos.pos.x + pos.pos.y * pos.pos.y + pos.pos.z * pos.pos.z);}
 
   /*--------------------------------------------------------------------------------*/
   /** Get level due to distance
    */
   /*--------------------------------------------------------------------------------*/
-  double GetLevel(double d) const;
+  double GetLevel(double d) const {return GetLevel(GetParameters(), d);}
 
   /*--------------------------------------------------------------------------------*/
   /** Get delay (in s or samples if delayscale = samplerate) due to distance
    */
   /*--------------------------------------------------------------------------------*/
-  double GetDelay(double d, double delayscale = 1.0) const;
+  double GetDelay(double d, double delayscale = 1.0) const {return GetDelay(GetParameters(), d, delayscale);}
 
   /*--------------------------------------------------------------------------------*/
   /** Get level and delay due to distance
@@ -55,30 +121,97 @@ public:
   /** Get level due to distance
    */
   /*--------------------------------------------------------------------------------*/
-  double GetLevel(const Position& pos) const;
+  double GetLevel(const Position& pos) const {return GetLevel(GetDistance(pos));}
 
   /*--------------------------------------------------------------------------------*/
   /** Get delay (in s or samples if delayscale = samplerate) due to distance
    */
   /*--------------------------------------------------------------------------------*/
-  double GetDelay(const Position& pos, double delayscale = 1.0) const;
+  double GetDelay(const Position& pos, double delayscale = 1.0) const {return GetDelay(GetDistance(pos), delayscale);}
 
   /*--------------------------------------------------------------------------------*/
   /** Get level and delay due to distance
    */
   /*--------------------------------------------------------------------------------*/
-  void   GetLevelAndDelay(const Position& pos, double& level, double& delay, double delayscale = 1.0) const;
+  void   GetLevelAndDelay(const Position& pos, double& level, double& delay, double delayscale = 1.0) const {GetLevelAndDelay(GetDistance(pos), level, delay, delayscale);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Get levels for an array of distances (see SetLevelMode())
+   *
+   * @param d array of n distances
+   * @param level array of n entries to receive levels
+   * @param n number of entries
+   */
+  /*--------------------------------------------------------------------------------*/
+  void   GetLevels(const double *d, double *level, uint_t n) const {GetLevels(GetParameters(), d, level, n);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Get delays (in s or samples if delayscale = samplerate) for an array of distances
+   *
+   * @param d array of n distances
+   * @param delay array of n entries to receive delays
+   * @param n number of entries
+   */
+  /*--------------------------------------------------------------------------------*/
+  void   GetDelays(const double *d, double *delay, uint_t n, double delayscale = 1.0) const {GetDelays(GetParameters(), d, delay, n, delayscale);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Get levels and delays for an array of distances
+   *
+   * @note either level or delay may be NULL
+   */
+  /*--------------------------------------------------------------------------------*/
+  void   GetLevelsAndDelays(const double *d, double *level, double *delay, uint_t n, double delayscale = 1.0) const {GetLevelsAndDelays(GetParameters(), d, level, delay, n, delayscale);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Get levels and delays for a batch of positions
+   *
+   * @param batch batch of positions (distances of cartesian batches are calculated without conversion to polar)
+   * @param level array of batch.Size() entries to receive levels (or NULL)
+   * @param delay array of batch.Size() entries to receive delays (or NULL)
+   *
+   * @note the distances are calculated into level or delay so no memory is allocated
+   */
+  /*--------------------------------------------------------------------------------*/
+  void   GetLevelsAndDelays(const PositionBatch& batch, double *level, double *delay, double delayscale = 1.0) const {GetLevelsAndDelays(GetParameters(), batch, level, delay, delayscale);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Calculation functions using a snapshot of parameters (see above for descriptions)
+   *
+   * @note these involve no locking, divides or pow() setup
+   */
+  /*--------------------------------------------------------------------------------*/
+  static double GetLevel(const PARAMETERS& params, double d);
+  static double GetDelay(const PARAMETERS& params, double d, double delayscale = 1.0) {return d * (delayscale * params.invspeedofsound);}
+  static void   GetLevels(const PARAMETERS& params, const double *d, double *level, uint_t n);
+  static void   GetDelays(const PARAMETERS& params, const double *d, double *delay, uint_t n, double delayscale = 1.0);
+  static void   GetLevelsAndDelays(const PARAMETERS& params, const double *d, double *level, double *delay, uint_t n, double delayscale = 1.0);
+  static void   GetLevelsAndDelays(const PARAMETERS& params, const PositionBatch& batch, double *level, double *delay, double delayscale = 1.0);
 
 protected:
-  DistanceModel();
-  ~DistanceModel() {}
+  /*--------------------------------------------------------------------------------*/
+  /** Store parameters and precomputed values
+   */
+  /*--------------------------------------------------------------------------------*/
+  void SetParameters(double power, double speed, LEVELMODE mode);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Calculate 2^-x for an array of values using interpolated table
+   *
+   * @note x is limited to +/-1000
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void TableExp2(const double *x, double *res, uint_t n);
 
 protected:
-  double decaypower;
-  double speedofsound;
+  SequenceLock           seqlock;
+  std::atomic<double>    decaypower;
+  std::atomic<double>    speedofsound;
+  std::atomic<double>    log2decaypower;
+  std::atomic<double>    invspeedofsound;
+  std::atomic<LEVELMODE> levelmode;
 };
 
 BBC_AUDIOTOOLBOX_END
 
 #endif
-
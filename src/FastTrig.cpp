@@ -0,0 +1,154 @@
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define BBCDEBUG_LEVEL 1
+#include "FastTrig.h"
+
+BBC_AUDIOTOOLBOX_START
+
+#if defined(__SSE2__)
+/*--------------------------------------------------------------------------------*/
+/** SSE2 versions of the scalar functions in FastTrig.h
+ *
+ * Each lane performs exactly the same operations as the scalar code so the results
+ * are identical
+ */
+/*--------------------------------------------------------------------------------*/
+static inline __m128d Select(__m128d mask, __m128d a, __m128d b)
+{
+  // mask ? a : b
+  return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+static inline void FastSinCosSSE2(__m128d x, __m128d& s, __m128d& c)
+{
+  const __m128d signmask = _mm_set1_pd(-0.0);
+  const __m128d half     = _mm_set1_pd(0.5);
+  const __m128d one      = _mm_set1_pd(1.0);
+  __m128d bias = Select(_mm_cmpge_pd(x, _mm_setzero_pd()), half, _mm_xor_pd(half, signmask));
+  __m128i ki   = _mm_cvttpd_epi32(_mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(2.0 / M_PI)), bias));
+  __m128d k    = _mm_cvtepi32_pd(ki);
+  __m128d r    = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(k, _mm_set1_pd(1.57079632673412561417e+00))), _mm_mul_pd(k, _mm_set1_pd(6.07710050650619224932e-11)));
+  __m128d r2   = _mm_mul_pd(r, r);
+  __m128d sr, cr;
+
+  sr = _mm_add_pd(_mm_set1_pd(1.0 / 120.0), _mm_mul_pd(r2, _mm_set1_pd(-1.0 / 5040.0)));
+  sr = _mm_add_pd(_mm_set1_pd(-1.0 / 6.0), _mm_mul_pd(r2, sr));
+  sr = _mm_mul_pd(r, _mm_add_pd(one, _mm_mul_pd(r2, sr)));
+
+  cr = _mm_add_pd(_mm_set1_pd(-1.0 / 720.0), _mm_mul_pd(r2, _mm_set1_pd(1.0 / 40320.0)));
+  cr = _mm_add_pd(_mm_set1_pd(1.0 / 24.0), _mm_mul_pd(r2, cr));
+  cr = _mm_add_pd(_mm_set1_pd(-0.5), _mm_mul_pd(r2, cr));
+  cr = _mm_add_pd(one, _mm_mul_pd(r2, cr));
+
+  // expand quadrant bits (32-bit lanes 0 and 1) to 64-bit masks
+  __m128i q     = _mm_shuffle_epi32(ki, _MM_SHUFFLE(1, 1, 0, 0));
+  __m128d swap  = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+  __m128d negs  = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+  __m128d negc  = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+
+  s = Select(swap, cr, sr);
+  c = Select(swap, sr, cr);
+  s = _mm_xor_pd(s, _mm_and_pd(negs, signmask));
+  c = _mm_xor_pd(c, _mm_and_pd(negc, signmask));
+}
+
+static inline __m128d FastAtan2SSE2(__m128d y, __m128d x)
+{
+  const __m128d signmask = _mm_set1_pd(-0.0);
+  __m128d ax = _mm_andnot_pd(signmask, x), ay = _mm_andnot_pd(signmask, y);
+  __m128d gt = _mm_cmpgt_pd(ax, ay);
+  __m128d mx = Select(gt, ax, ay);
+  __m128d mn = Select(gt, ay, ax);
+  __m128d a  = _mm_and_pd(_mm_cmpgt_pd(mx, _mm_setzero_pd()), _mm_div_pd(mn, mx));
+  __m128d a2 = _mm_mul_pd(a, a);
+  __m128d r;
+
+  r = _mm_add_pd(_mm_set1_pd(-0.0161657367), _mm_mul_pd(a2, _mm_set1_pd(0.0028662257)));
+  r = _mm_add_pd(_mm_set1_pd( 0.0429096138), _mm_mul_pd(a2, r));
+  r = _mm_add_pd(_mm_set1_pd(-0.0752896400), _mm_mul_pd(a2, r));
+  r = _mm_add_pd(_mm_set1_pd( 0.1065626393), _mm_mul_pd(a2, r));
+  r = _mm_add_pd(_mm_set1_pd(-0.1420889944), _mm_mul_pd(a2, r));
+  r = _mm_add_pd(_mm_set1_pd( 0.1999355085), _mm_mul_pd(a2, r));
+  r = _mm_add_pd(_mm_set1_pd(-0.3333314528), _mm_mul_pd(a2, r));
+  r = _mm_mul_pd(a, _mm_add_pd(_mm_set1_pd(1.0), _mm_mul_pd(a2, r)));
+
+  r = Select(_mm_cmpgt_pd(ay, ax), _mm_sub_pd(_mm_set1_pd(0.5 * M_PI), r), r);
+  r = Select(_mm_cmplt_pd(x, _mm_setzero_pd()), _mm_sub_pd(_mm_set1_pd(M_PI), r), r);
+
+  // r >= 0 so negation is the same as setting the sign bit
+  return _mm_or_pd(r, _mm_and_pd(y, signmask));
+}
+#endif
+
+/*--------------------------------------------------------------------------------*/
+/** Batch approximate sine and cosine
+ */
+/*--------------------------------------------------------------------------------*/
+void FastSinCos(const double *x, double *s, double *c, uint_t n)
+{
+  uint_t i = 0;
+
+#if defined(__SSE2__)
+  for (; (i + 2) <= n; i += 2)
+  {
+    __m128d vs, vc;
+
+    FastSinCosSSE2(_mm_loadu_pd(x + i), vs, vc);
+
+    _mm_storeu_pd(s + i, vs);
+    _mm_storeu_pd(c + i, vc);
+  }
+#endif
+
+  for (; i < n; i++)
+  {
+    double s1, c1;
+
+    FastSinCos(x[i], s1, c1);
+
+    s[i] = s1;
+    c[i] = c1;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Batch approximate atan2
+ */
+/*--------------------------------------------------------------------------------*/
+void FastAtan2(const double *y, const double *x, double *res, uint_t n)
+{
+  uint_t i = 0;
+
+#if defined(__SSE2__)
+  for (; (i + 2) <= n; i += 2) _mm_storeu_pd(res + i, FastAtan2SSE2(_mm_loadu_pd(y + i), _mm_loadu_pd(x + i)));
+#endif
+
+  for (; i < n; i++) res[i] = FastAtan2(y[i], x[i]);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Batch approximate asin
+ */
+/*--------------------------------------------------------------------------------*/
+void FastAsin(const double *x, double *res, uint_t n)
+{
+  uint_t i = 0;
+
+#if defined(__SSE2__)
+  const __m128d one = _mm_set1_pd(1.0);
+
+  for (; (i + 2) <= n; i += 2)
+  {
+    __m128d vx = _mm_loadu_pd(x + i);
+
+    _mm_storeu_pd(res + i, FastAtan2SSE2(vx, _mm_sqrt_pd(_mm_mul_pd(_mm_sub_pd(one, vx), _mm_add_pd(one, vx)))));
+  }
+#endif
+
+  for (; i < n; i++) res[i] = FastAsin(x[i]);
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,105 @@
+#ifndef __FAST_TRIG__
+#define __FAST_TRIG__
+
+#include <math.h>
+
+#include "misc.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Fast approximate trigonometric functions
+ *
+ * These are opt-in replacements for the libm functions where an absolute accuracy of
+ * around 1e-6 is sufficient (e.g. panning).  All functions take and return radians.
+ *
+ * Maximum absolute errors (measured against libm, see test/fasttrigtests.cpp):
+ *   FastSin(), FastCos(), FastSinCos(): < 4e-7 for |x| <= 1e4 (range reduction error grows
+ *                                       slowly with |x|, valid for |x| < 1e6)
+ *   FastAtan2():                        < 5e-8
+ *   FastAsin():                         < 5e-8 for |x| <= 1
+ *
+ * The batch versions produce identical results to the scalar versions and use SSE2
+ * where available
+ */
+/*--------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------*/
+/** Approximate sine and cosine of x (radians)
+ *
+ * x is reduced to r in [-pi/4, pi/4] (x = r + k * pi/2) and Taylor polynomials of
+ * degree 7 (sin) and 8 (cos) are used
+ */
+/*--------------------------------------------------------------------------------*/
+inline void FastSinCos(double x, double& s, double& c)
+{
+  // pi/2 split into high and low parts for accurate range reduction (Cody-Waite)
+  static const double PIBY2_HI = 1.57079632673412561417e+00;
+  static const double PIBY2_LO = 6.07710050650619224932e-11;
+  double k  = (double)(sint_t)(x * (2.0 / M_PI) + ((x >= 0.0) ? 0.5 : -0.5));
+  double r  = (x - k * PIBY2_HI) - k * PIBY2_LO;
+  double r2 = r * r;
+  double sr = r * (1.0 + r2 * (-1.0 / 6.0 + r2 * (1.0 / 120.0 + r2 * (-1.0 / 5040.0))));
+  double cr = 1.0 + r2 * (-0.5 + r2 * (1.0 / 24.0 + r2 * (-1.0 / 720.0 + r2 * (1.0 / 40320.0))));
+  uint_t q  = (uint_t)(sint_t)k & 3;
+
+  // select quadrant
+  s = (q & 1) ? cr : sr;
+  c = (q & 1) ? sr : cr;
+  if ((q + 0) & 2) s = -s;
+  if ((q + 1) & 2) c = -c;
+}
+
+inline double FastSin(double x) {double s, c; FastSinCos(x, s, c); return s;}
+inline double FastCos(double x) {double s, c; FastSinCos(x, s, c); return c;}
+
+/*--------------------------------------------------------------------------------*/
+/** Approximate atan2(y, x) (radians)
+ *
+ * Uses the polynomial of Abramowitz and Stegun 4.4.49 for atan() over [0, 1] with
+ * octant reconstruction.  FastAtan2(+/-0, +/-0) returns +/-0
+ */
+/*--------------------------------------------------------------------------------*/
+inline double FastAtan2(double y, double x)
+{
+  double ax = fabs(x), ay = fabs(y);
+  double mx = (ax > ay) ? ax : ay;
+  double mn = (ax > ay) ? ay : ax;
+  double a  = (mx > 0.0) ? mn / mx : 0.0;
+  double a2 = a * a;
+  double r  = a * (1.0 + a2 * (-0.3333314528 + a2 * (0.1999355085 + a2 * (-0.1420889944 + a2 * (0.1065626393 +
+                        a2 * (-0.0752896400 + a2 * (0.0429096138 + a2 * (-0.0161657367 + a2 * 0.0028662257))))))));
+
+  if (ay > ax) r = 0.5 * M_PI - r;
+  if (x < 0.0) r = M_PI - r;
+  // use sign bit so that, like atan2(), -0 gives -pi for negative x
+  return signbit(y) ? -r : r;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Approximate asin(x) (radians)
+ *
+ * @note x MUST be in the range -1 to 1
+ */
+/*--------------------------------------------------------------------------------*/
+inline double FastAsin(double x)
+{
+  // (1 - x) * (1 + x) avoids cancellation error of 1 - x * x near |x| = 1
+  return FastAtan2(x, sqrt((1.0 - x) * (1.0 + x)));
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Batch versions of the above
+ *
+ * @param n number of values
+ *
+ * @note input and output arrays may be the same
+ */
+/*--------------------------------------------------------------------------------*/
+extern void FastSinCos(const double *x, double *s, double *c, uint_t n);
+extern void FastAtan2(const double *y, const double *x, double *res, uint_t n);
+extern void FastAsin(const double *x, double *res, uint_t n);
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,544 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define BBCDEBUG_LEVEL 0
+#include "JSONReader.h"
+
+BBC_AUDIOTOOLBOX_START
+
+JSONReader::JSONReader(const char *_str, size_t len) : start(_str),
+                                                       end(_str + len),
+                                                       p(_str),
+                                                       tokenstart(_str),
+                                                       numval(0.0),
+                                                       magnitude(0),
+                                                       token(Token_Null),
+                                                       state(State_Value),
+                                                       first(false),
+                                                       boolval(false),
+                                                       integer(false),
+                                                       negative(false)
+{
+}
+
+JSONReader::JSONReader(const char *_str) : start(_str),
+                                           end(_str + strlen(_str)),
+                                           p(_str),
+                                           tokenstart(_str),
+                                           numval(0.0),
+                                           magnitude(0),
+                                           token(Token_Null),
+                                           state(State_Value),
+                                           first(false),
+                                           boolval(false),
+                                           integer(false),
+                                           negative(false)
+{
+}
+
+JSONReader::JSONReader(const std::string& _str) : start(_str.c_str()),
+                                                  end(_str.c_str() + _str.length()),
+                                                  p(_str.c_str()),
+                                                  tokenstart(_str.c_str()),
+                                                  numval(0.0),
+                                                  magnitude(0),
+                                                  token(Token_Null),
+                                                  state(State_Value),
+                                                  first(false),
+                                                  boolval(false),
+                                                  integer(false),
+                                                  negative(false)
+{
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Record syntax error and return Token_Error
+ */
+/*--------------------------------------------------------------------------------*/
+JSONReader::TOKEN JSONReader::SetError(const char *msg)
+{
+  Printf(error, "%s at offset %lu", msg, (ulong_t)(p - start));
+  return token = Token_Error;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set token and move to state after a value
+ */
+/*--------------------------------------------------------------------------------*/
+JSONReader::TOKEN JSONReader::SetValueToken(TOKEN tok)
+{
+  state = State_Next;
+  first = false;
+  return token = tok;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Skip whitespace and comments
+ */
+/*--------------------------------------------------------------------------------*/
+void JSONReader::SkipWhitespace()
+{
+  while (p < end)
+  {
+    char c = *p;
+
+    if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n')) p++;
+    else if ((c == '/') && ((p + 1) < end) && (p[1] == '/'))
+    {
+      while ((p < end) && (*p != '\n')) p++;
+    }
+    else if ((c == '/') && ((p + 1) < end) && (p[1] == '*'))
+    {
+      for (p += 2; (p < end) && !((*p == '*') && ((p + 1) < end) && (p[1] == '/')); p++) ;
+      p = ((end - p) >= 2) ? p + 2 : end;
+    }
+    else break;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read next token
+ */
+/*--------------------------------------------------------------------------------*/
+JSONReader::TOKEN JSONReader::Next()
+{
+  if ((token == Token_Error) || (token == Token_End)) return token;
+
+  SkipWhitespace();
+
+  if (state == State_Next)
+  {
+    // top level value complete
+    if (stack.empty())
+    {
+      if (p < end) return SetError("Unexpected text after value");
+      return token = Token_End;
+    }
+
+    if (p >= end) return SetError("Unexpected end of text");
+
+    const char container = stack.back();
+    if (*p == ',')
+    {
+      p++;
+      state = (container == '{') ? State_Key : State_Value;
+      SkipWhitespace();
+    }
+    else if (*p == ((container == '{') ? '}' : ']'))
+    {
+      tokenstart = p++;
+      stack.pop_back();
+      return SetValueToken((container == '{') ? Token_ObjectEnd : Token_ArrayEnd);
+    }
+    else return SetError((container == '{') ? "Expected ',' or '}'" : "Expected ',' or ']'");
+  }
+
+  if (p >= end)
+  {
+    // empty text
+    if (stack.empty()) return token = Token_End;
+    return SetError("Unexpected end of text");
+  }
+
+  tokenstart = p;
+
+  if (state == State_Key)
+  {
+    if ((*p == '}') && first)
+    {
+      p++;
+      stack.pop_back();
+      return SetValueToken(Token_ObjectEnd);
+    }
+    if (*p != '"') return SetError("Expected member name");
+    if (!ReadString(key)) return token;
+
+    SkipWhitespace();
+    if ((p >= end) || (*p != ':')) return SetError("Expected ':'");
+    p++;
+
+    state = State_Value;
+    first = false;
+    return token = Token_Key;
+  }
+
+  switch (*p)
+  {
+    case '{':
+      if (stack.size() >= MaxDepth) return SetError("Nesting too deep");
+      p++;
+      stack.push_back('{');
+      state = State_Key;
+      first = true;
+      return token = Token_ObjectStart;
+
+    case '[':
+      if (stack.size() >= MaxDepth) return SetError("Nesting too deep");
+      p++;
+      stack.push_back('[');
+      state = State_Value;
+      first = true;
+      return token = Token_ArrayStart;
+
+    case ']':
+      if (first && !stack.empty() && (stack.back() == '['))
+      {
+        p++;
+        stack.pop_back();
+        return SetValueToken(Token_ArrayEnd);
+      }
+      break;
+
+    case '"':
+      if (!ReadString(str)) return token;
+      return SetValueToken(Token_String);
+
+    case 't':
+      if (!ReadLiteral("true", 4)) return token;
+      boolval = true;
+      return SetValueToken(Token_Bool);
+
+    case 'f':
+      if (!ReadLiteral("false", 5)) return token;
+      boolval = false;
+      return SetValueToken(Token_Bool);
+
+    case 'n':
+      if (!ReadLiteral("null", 4)) return token;
+      return SetValueToken(Token_Null);
+
+    case '-':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+      if (!ReadNumber()) return token;
+      return SetValueToken(Token_Number);
+
+    default:
+      break;
+  }
+
+  return SetError("Expected value");
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Skip the rest of the value whose first token has just been read
+ */
+/*--------------------------------------------------------------------------------*/
+bool JSONReader::Skip()
+{
+  if ((token == Token_ObjectStart) || (token == Token_ArrayStart))
+  {
+    size_t depth = stack.size();
+
+    while (stack.size() >= depth)
+    {
+      TOKEN tok = Next();
+      if ((tok == Token_Error) || (tok == Token_End)) return false;
+    }
+  }
+
+  return (token != Token_Error);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Match literal (true, false, null)
+ */
+/*--------------------------------------------------------------------------------*/
+bool JSONReader::ReadLiteral(const char *literal, size_t len)
+{
+  if (((size_t)(end - p) < len) || (memcmp(p, literal, len) != 0))
+  {
+    SetError("Expected value");
+    return false;
+  }
+
+  p += len;
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read 4 hex digits of a \u escape
+ */
+/*--------------------------------------------------------------------------------*/
+bool JSONReader::ReadHex4(uint_t& val)
+{
+  uint_t i;
+
+  if ((end - p) < 4)
+  {
+    SetError("Bad unicode escape");
+    return false;
+  }
+
+  for (i = 0, val = 0; i < 4; i++)
+  {
+    char c = *p++;
+
+    val <<= 4;
+    if      ((c >= '0') && (c <= '9')) val += c - '0';
+    else if ((c >= 'a') && (c <= 'f')) val += c - 'a' + 10;
+    else if ((c >= 'A') && (c <= 'F')) val += c - 'A' + 10;
+    else
+    {
+      SetError("Bad unicode escape");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read string (p points to the opening quote) into val
+ */
+/*--------------------------------------------------------------------------------*/
+bool JSONReader::ReadString(std::string& val)
+{
+  val.clear();
+  p++;
+
+  while (true)
+  {
+    const char *s = p;
+
+    // copy runs of unescaped characters in one go
+    while ((p < end) && (*p != '"') && (*p != '\\')) p++;
+    val.append(s, p - s);
+
+    if (p >= end)
+    {
+      SetError("Unterminated string");
+      return false;
+    }
+    if (*p++ == '"') break;
+
+    if (p >= end)
+    {
+      SetError("Unterminated string");
+      return false;
+    }
+
+    char c = *p++;
+    switch (c)
+    {
+      case '"':
+      case '\\':
+      case '/': val += c;    break;
+      case 'b': val += '\b'; break;
+      case 'f': val += '\f'; break;
+      case 'n': val += '\n'; break;
+      case 'r': val += '\r'; break;
+      case 't': val += '\t'; break;
+
+      case 'u':
+      {
+        uint_t code, low;
+
+        if (!ReadHex4(code)) return false;
+
+        // surrogate pair
+        if ((code >= 0xd800) && (code < 0xdc00))
+        {
+          if (((end - p) < 2) || (p[0] != '\\') || (p[1] != 'u'))
+          {
+            SetError("Expected low surrogate");
+            return false;
+          }
+          p += 2;
+          if (!ReadHex4(low)) return false;
+          if ((low < 0xdc00) || (low >= 0xe000))
+          {
+            SetError("Bad low surrogate");
+            return false;
+          }
+          code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+        }
+
+        // encode as UTF-8
+        if (code < 0x80) val += (char)code;
+        else if (code < 0x800)
+        {
+          val += (char)(0xc0 | (code >> 6));
+          val += (char)(0x80 | (code & 0x3f));
+        }
+        else if (code < 0x10000)
+        {
+          val += (char)(0xe0 | (code >> 12));
+          val += (char)(0x80 | ((code >> 6) & 0x3f));
+          val += (char)(0x80 | (code & 0x3f));
+        }
+        else
+        {
+          val += (char)(0xf0 | (code >> 18));
+          val += (char)(0x80 | ((code >> 12) & 0x3f));
+          val += (char)(0x80 | ((code >> 6) & 0x3f));
+          val += (char)(0x80 | (code & 0x3f));
+        }
+        break;
+      }
+
+      default:
+        p--;
+        SetError("Bad escape sequence");
+        return false;
+    }
+  }
+
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read number
+ *
+ * Integers that fit into 64 bits are converted exactly, everything else via strtod()
+ */
+/*--------------------------------------------------------------------------------*/
+bool JSONReader::ReadNumber()
+{
+  const char *s = p;
+
+  negative  = (*p == '-');
+  integer   = true;
+  magnitude = 0;
+
+  if (negative) p++;
+  if ((p >= end) || (*p < '0') || (*p > '9'))
+  {
+    SetError("Bad number");
+    return false;
+  }
+
+  while ((p < end) && (*p >= '0') && (*p <= '9'))
+  {
+    uint_t digit = *p++ - '0';
+
+    if (magnitude > (((ullong_t)-1 - digit) / 10)) integer = false;
+    else magnitude = magnitude * 10 + digit;
+  }
+
+  if ((p < end) && (*p == '.'))
+  {
+    integer = false;
+    for (p++; (p < end) && (*p >= '0') && (*p <= '9'); p++) ;
+  }
+
+  if ((p < end) && ((*p == 'e') || (*p == 'E')))
+  {
+    integer = false;
+    p++;
+    if ((p < end) && ((*p == '+') || (*p == '-'))) p++;
+    if ((p >= end) || (*p < '0') || (*p > '9'))
+    {
+      SetError("Bad number");
+      return false;
+    }
+    while ((p < end) && (*p >= '0') && (*p <= '9')) p++;
+  }
+
+  // the most negative 64-bit integer has a magnitude of 2^63
+  if (negative && (magnitude > ((ullong_t)1 << 63))) integer = false;
+
+  if (integer) numval = negative ? -(double)magnitude : (double)magnitude;
+  else
+  {
+    // the text is not necessarily terminated so copy the number
+    char buf[64];
+    size_t len = p - s;
+
+    if (len < sizeof(buf))
+    {
+      memcpy(buf, s, len);
+      buf[len] = 0;
+      numval = strtod(buf, NULL);
+    }
+    else numval = strtod(std::string(s, len).c_str(), NULL);
+  }
+
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return value of the last Token_Number as an integer
+ */
+/*--------------------------------------------------------------------------------*/
+bool JSONReader::GetInteger(sllong_t& val) const
+{
+  bool success = false;
+
+  if (token == Token_Number)
+  {
+    if (integer)
+    {
+      if (negative)
+      {
+        val = (magnitude == ((ullong_t)1 << 63)) ? (sllong_t)((ullong_t)1 << 63) : -(sllong_t)magnitude;
+        success = true;
+      }
+      else if (magnitude < ((ullong_t)1 << 63))
+      {
+        val = (sllong_t)magnitude;
+        success = true;
+      }
+    }
+    else if ((numval == floor(numval)) && (numval >= -9223372036854775808.0) && (numval < 9223372036854775808.0))
+    {
+      val = (sllong_t)numval;
+      success = true;
+    }
+  }
+
+  return success;
+}
+
+bool JSONReader::GetInteger(ullong_t& val) const
+{
+  bool success = false;
+
+  if (token == Token_Number)
+  {
+    if (integer)
+    {
+      // allow -0
+      if (!negative || !magnitude)
+      {
+        val = magnitude;
+        success = true;
+      }
+    }
+    else if ((numval == floor(numval)) && (numval >= 0.0) && (numval < 18446744073709551616.0))
+    {
+      val = (ullong_t)numval;
+      success = true;
+    }
+  }
+
+  return success;
+}
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Read the next value into a jsoncpp value
+ */
+/*--------------------------------------------------------------------------------*/
+bool JSONReader::ReadValue(Json::Value& obj)
+{
+  TOKEN tok = Next();
+  bool  success = false;
+
+  if ((tok == Token_ObjectStart) || (tok == Token_ArrayStart) || IsScalar())
+  {
+    const char *s = tokenstart;
+
+    if (Skip())
+    {
+      Json::Reader reader;
+      success = reader.parse(s, p, obj, false);
+    }
+  }
+
+  return success;
+}
+#endif
+
+BBC_AUDIOTOOLBOX_END
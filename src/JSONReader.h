@@ -0,0 +1,241 @@
+#ifndef __BBCAT_JSON_READER__
+#define __BBCAT_JSON_READER__
+
+#include <string>
+#include <vector>
+
+#include "misc.h"
+
+#if ENABLE_JSON
+#include <json/json.h>
+#endif
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Streaming JSON reader
+ *
+ * Reads JSON text one token at a time without building a document tree so that
+ * objects can fill themselves directly from the text (see FromJSON(JSONReader&)
+ * in JSONSerializable)
+ *
+ * Members of an object are returned as a Token_Key (the name is available from
+ * GetKey()) followed by the tokens of the value.  Strings are unescaped into a
+ * buffer that is reused so reading involves no allocation once the buffers are
+ * large enough
+ *
+ * Typical usage:
+ *
+ *  if (reader.Next() == JSONReader::Token_ObjectStart)
+ *  {
+ *    while (reader.Next() == JSONReader::Token_Key)
+ *    {
+ *      if (reader.GetKey() == "x") json::FromJSON(reader, x);
+ *      else reader.SkipValue();
+ *    }
+ *  }
+ *
+ * As with jsoncpp's default reader, C and C++ style comments are allowed and
+ * objects and arrays may be nested at most MaxDepth deep (deeper nesting is an
+ * error rather than risking stack overflow in recursive readers)
+ *
+ * @note the text MUST remain valid for the lifetime of the reader
+ */
+/*--------------------------------------------------------------------------------*/
+class JSONReader
+{
+public:
+  JSONReader(const char *str, size_t len);
+  JSONReader(const char *str);
+  JSONReader(const std::string& str);
+  ~JSONReader() {}
+
+  enum
+  {
+    MaxDepth = 1000,                    // maximum nesting of objects and arrays
+  };
+
+  typedef enum
+  {
+    Token_Error = 0,                    // syntax error (see GetError())
+    Token_End,                          // end of text
+    Token_ObjectStart,
+    Token_ObjectEnd,
+    Token_ArrayStart,
+    Token_ArrayEnd,
+    Token_Key,                          // name of object member (see GetKey())
+    Token_Null,
+    Token_Bool,
+    Token_Number,
+    Token_String,
+  } TOKEN;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read next token
+   */
+  /*--------------------------------------------------------------------------------*/
+  TOKEN Next();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return last token read
+   */
+  /*--------------------------------------------------------------------------------*/
+  TOKEN GetToken() const {return token;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Skip the rest of the value whose first token has just been read
+   *
+   * @note does nothing unless the last token was Token_ObjectStart or Token_ArrayStart
+   *
+   * @return false if there was a syntax error
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Skip();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read and skip the next value
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool SkipValue() {Next(); return Skip();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the value whose first token has just been read is a scalar
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsScalar() const {return ((token >= Token_Null) && (token <= Token_String));}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return name of the last object member
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::string& GetKey() const {return key;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value of the last Token_Bool
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool GetBool() const {return boolval;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value of the last Token_String
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::string& GetString() const {return str;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value of the last Token_Number as a double
+   */
+  /*--------------------------------------------------------------------------------*/
+  double GetDouble() const {return numval;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value of the last Token_Number as an integer
+   *
+   * @return false if the number is not integral or outside the range of the type
+   *
+   * @note as with jsoncpp, reals with integral values (e.g. 2.0) are accepted
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool GetInteger(sllong_t& val) const;
+  bool GetInteger(ullong_t& val) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether the last Token_Number was written as an integer
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsInteger() const {return integer;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return description of syntax error
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::string& GetError() const {return error;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return offset of the current position within the text
+   */
+  /*--------------------------------------------------------------------------------*/
+  size_t GetPosition() const {return p - start;}
+
+#if ENABLE_JSON
+  /*--------------------------------------------------------------------------------*/
+  /** Read the next value into a jsoncpp value
+   *
+   * This allows objects that do not support streaming to be read from the stream
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadValue(Json::Value& obj);
+#endif
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Skip whitespace and comments
+   */
+  /*--------------------------------------------------------------------------------*/
+  void SkipWhitespace();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read string (p points to the opening quote) into val
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadString(std::string& val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read 4 hex digits of a \u escape
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadHex4(uint_t& val);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read number
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadNumber();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Match literal (true, false, null)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadLiteral(const char *literal, size_t len);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Record syntax error and return Token_Error
+   */
+  /*--------------------------------------------------------------------------------*/
+  TOKEN SetError(const char *msg);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set token and move to state after a value
+   */
+  /*--------------------------------------------------------------------------------*/
+  TOKEN SetValueToken(TOKEN tok);
+
+  typedef enum
+  {
+    State_Value = 0,                    // expecting a value
+    State_Key,                          // expecting a member name
+    State_Next,                         // expecting ',' or the end of a container
+  } STATE;
+
+protected:
+  const char        *start;
+  const char        *end;
+  const char        *p;
+  const char        *tokenstart;        // start of last token
+  std::vector<char> stack;              // '{' or '[' for each open container
+  std::string       key;
+  std::string       str;
+  std::string       error;
+  double            numval;
+  ullong_t          magnitude;          // absolute value of integer
+  TOKEN             token;
+  STATE             state;
+  bool              first;              // true before first member/element of a container
+  bool              boolval;
+  bool              integer;            // number written as an integer that fits in 64 bits
+  bool              negative;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define BBCDEBUG_LEVEL 0
+#include "JSONWriter.h"
+#include "json.h"
+
+BBC_AUDIOTOOLBOX_START
+
+JSONWriter::JSONWriter(bool _pretty) : pretty(_pretty),
+                                       complete(false)
+{
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Clear output to start a new document (keeping the buffer)
+ */
+/*--------------------------------------------------------------------------------*/
+void JSONWriter::Reset()
+{
+  buffer.clear();
+  stack.clear();
+  complete = false;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Prepare for an object member or array element
+ */
+/*--------------------------------------------------------------------------------*/
+void JSONWriter::BeginChild(LEVEL& level)
+{
+  if (level.count)      buffer += ',';
+  else if (pretty && level.member)
+  {
+    // as jsoncpp's styled writer, non-empty containers that are member values
+    // start on a new line so move the opening bracket
+    char bracket = buffer[buffer.length() - 1];
+
+    buffer.resize(buffer.length() - 1);
+    NewLine(stack.size() - 1);
+    buffer += bracket;
+  }
+
+  if (pretty) NewLine(stack.size());
+
+  level.count++;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Start/end object or array
+ */
+/*--------------------------------------------------------------------------------*/
+void JSONWriter::StartContainer(bool object)
+{
+  LEVEL level;
+
+  BeginValue();
+
+  level.object = object;
+  level.member = (!stack.empty() && stack.back().object);
+  level.count  = 0;
+  stack.push_back(level);
+
+  buffer += object ? '{' : '[';
+}
+
+void JSONWriter::EndContainer(char bracket)
+{
+  if (!stack.empty())
+  {
+    bool nonempty = (stack.back().count != 0);
+
+    stack.pop_back();
+
+    if (pretty && nonempty) NewLine(stack.size());
+  }
+  else BBCERROR("JSONWriter: '%c' without matching start", bracket);
+
+  buffer += bracket;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write name of next object member
+ */
+/*--------------------------------------------------------------------------------*/
+void JSONWriter::Key(const char *name)
+{
+  Key(name, strlen(name));
+}
+
+void JSONWriter::Key(const char *name, size_t len)
+{
+  if (!stack.empty() && stack.back().object)
+  {
+    BeginChild(stack.back());
+    AppendQuoted(name, len);
+    buffer += pretty ? " : " : ":";
+  }
+  else BBCERROR("JSONWriter: key '%s' outside of object", std::string(name, len).c_str());
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write values
+ */
+/*--------------------------------------------------------------------------------*/
+void JSONWriter::Null()
+{
+  BeginValue();
+  buffer += "null";
+}
+
+void JSONWriter::Bool(bool val)
+{
+  BeginValue();
+  buffer += val ? "true" : "false";
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append decimal integer (much quicker than snprintf())
+ */
+/*--------------------------------------------------------------------------------*/
+static void AppendInteger(std::string& buffer, ullong_t val, bool negative)
+{
+  char str[24], *p = str + sizeof(str);
+
+  do
+  {
+    *--p = '0' + (char)(val % 10);
+    val /= 10;
+  }
+  while (val);
+
+  if (negative) *--p = '-';
+
+  buffer.append(p, str + sizeof(str) - p);
+}
+
+void JSONWriter::Int(sllong_t val)
+{
+  BeginValue();
+  // negate as unsigned to handle the most negative value
+  AppendInteger(buffer, (val < 0) ? (ullong_t)0 - (ullong_t)val : (ullong_t)val, (val < 0));
+}
+
+void JSONWriter::UInt(ullong_t val)
+{
+  BeginValue();
+  AppendInteger(buffer, val, false);
+}
+
+void JSONWriter::Double(double val)
+{
+  BeginValue();
+
+  // formatting follows jsoncpp: 17 significant digits, always recognisable as a real
+  if (isnan(val)) buffer += "null";
+  else if (isinf(val)) buffer += (val < 0.0) ? "-1e+9999" : "1e+9999";
+  else if ((val == floor(val)) && (fabs(val) < 1.0e15) && ((val != 0.0) || !signbit(val)))
+  {
+    // integral values are common (and printed without an exponent by %.17g) so avoid snprintf()
+    AppendInteger(buffer, (ullong_t)fabs(val), (val < 0.0));
+    buffer += ".0";
+  }
+  else
+  {
+    char   str[40];
+    size_t i, n = (size_t)snprintf(str, sizeof(str), "%.17g", val);
+    bool   real = false;
+
+    for (i = 0; i < n; i++)
+    {
+      // undo any locale specific decimal separator
+      if (str[i] == ',') str[i] = '.';
+      if ((str[i] == '.') || (str[i] == 'e')) real = true;
+    }
+
+    buffer.append(str, n);
+    if (!real) buffer += ".0";
+  }
+}
+
+void JSONWriter::String(const char *str)
+{
+  String(str, strlen(str));
+}
+
+void JSONWriter::String(const char *str, size_t len)
+{
+  BeginValue();
+  AppendQuoted(str, len);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Decode a UTF-8 character in the same way as jsoncpp (s is left on the last byte)
+ */
+/*--------------------------------------------------------------------------------*/
+static uint_t DecodeUTF8(const uint8_t *& s, const uint8_t *end)
+{
+  static const uint_t replacement = 0xfffd;
+  uint_t c = s[0];
+
+  if (c < 0x80) return c;
+
+  if (c < 0xe0)
+  {
+    if ((end - s) < 2) return replacement;
+    c = ((c & 0x1f) << 6) | (s[1] & 0x3f);
+    s += 1;
+    return (c < 0x80) ? replacement : c;
+  }
+
+  if (c < 0xf0)
+  {
+    if ((end - s) < 3) return replacement;
+    c = ((c & 0x0f) << 12) | ((s[1] & 0x3f) << 6) | (s[2] & 0x3f);
+    s += 2;
+    if ((c >= 0xd800) && (c <= 0xdfff)) return replacement;
+    return (c < 0x800) ? replacement : c;
+  }
+
+  if (c < 0xf8)
+  {
+    if ((end - s) < 4) return replacement;
+    c = ((c & 0x07) << 18) | ((s[1] & 0x3f) << 12) | ((s[2] & 0x3f) << 6) | (s[3] & 0x3f);
+    s += 3;
+    return (c < 0x10000) ? replacement : c;
+  }
+
+  return replacement;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append \u escape
+ */
+/*--------------------------------------------------------------------------------*/
+static void AppendEscape(std::string& buffer, uint_t c)
+{
+  static const char hex[] = "0123456789abcdef";
+  char str[6] = {'\\', 'u', hex[(c >> 12) & 0xf], hex[(c >> 8) & 0xf], hex[(c >> 4) & 0xf], hex[c & 0xf]};
+
+  buffer.append(str, sizeof(str));
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append quoted and escaped string
+ *
+ * As jsoncpp, control and non-ASCII characters are written as \u escapes
+ */
+/*--------------------------------------------------------------------------------*/
+void JSONWriter::AppendQuoted(const char *str, size_t len)
+{
+  const uint8_t *s   = (const uint8_t *)str;
+  const uint8_t *end = s + len;
+  const uint8_t *p;
+
+  buffer += '"';
+
+  // copy characters that need no escaping in one go
+  for (p = s; (p < end) && (*p >= 0x20) && (*p < 0x80) && (*p != '"') && (*p != '\\'); p++) ;
+  buffer.append(str, p - s);
+
+  for (; p < end; p++)
+  {
+    switch (*p)
+    {
+      case '"':  buffer += "\\\""; break;
+      case '\\': buffer += "\\\\"; break;
+      case '\b': buffer += "\\b";  break;
+      case '\f': buffer += "\\f";  break;
+      case '\n': buffer += "\\n";  break;
+      case '\r': buffer += "\\r";  break;
+      case '\t': buffer += "\\t";  break;
+
+      default:
+      {
+        uint_t c;
+
+        if (*p < 0x20) AppendEscape(buffer, *p);
+        else if ((c = DecodeUTF8(p, end)) < 0x80) buffer += (char)c;
+        else if (c < 0x10000) AppendEscape(buffer, c);
+        else
+        {
+          // surrogate pair
+          c -= 0x10000;
+          AppendEscape(buffer, 0xd800 + ((c >> 10) & 0x3ff));
+          AppendEscape(buffer, 0xdc00 + (c & 0x3ff));
+        }
+        break;
+      }
+    }
+  }
+
+  buffer += '"';
+}
+
+#if ENABLE_JSON
+/*--------------------------------------------------------------------------------*/
+/** Write jsoncpp value
+ */
+/*--------------------------------------------------------------------------------*/
+void JSONWriter::Write(const Json::Value& obj)
+{
+  switch (obj.type())
+  {
+    case Json::nullValue:
+      Null();
+      break;
+
+    case Json::intValue:
+      Int(obj.asInt64());
+      break;
+
+    case Json::uintValue:
+      UInt(obj.asUInt64());
+      break;
+
+    case Json::realValue:
+      Double(obj.asDouble());
+      break;
+
+    case Json::stringValue:
+      String(obj.asString());
+      break;
+
+    case Json::booleanValue:
+      Bool(obj.asBool());
+      break;
+
+    case Json::arrayValue:
+    {
+      Json::ArrayIndex i;
+
+      StartArray();
+      for (i = 0; i < obj.size(); i++) Write(obj[i]);
+      EndArray();
+      break;
+    }
+
+    case Json::objectValue:
+    {
+      Json::Value::const_iterator it;
+
+      StartObject();
+      for (it = obj.begin(); it != obj.end(); ++it)
+      {
+        Key(JSON_MEMBER_NAME(it));
+        Write(*it);
+      }
+      EndObject();
+      break;
+    }
+  }
+}
+#endif
+
+/*--------------------------------------------------------------------------------*/
+/** Return JSON text, completing the document first if necessary
+ */
+/*--------------------------------------------------------------------------------*/
+const std::string& JSONWriter::GetString()
+{
+  if (!complete)
+  {
+    if (buffer.empty() || (buffer == "null")) buffer = "{}";
+    else buffer += '\n';
+    complete = true;
+  }
+
+  return buffer;
+}
+
+BBC_AUDIOTOOLBOX_END
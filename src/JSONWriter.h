@@ -0,0 +1,153 @@
+#ifndef __BBCAT_JSON_WRITER__
+#define __BBCAT_JSON_WRITER__
+
+#include <string>
+#include <vector>
+
+#include "misc.h"
+
+#if ENABLE_JSON
+#include <json/json.h>
+#endif
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Streaming JSON writer
+ *
+ * Writes JSON text directly into a buffer without building a document tree so that
+ * objects can write themselves directly (see ToJSON(JSONWriter&) in JSONSerializable)
+ *
+ * The output is identical to that of json::ToJSONString() (i.e. jsoncpp's styled or
+ * fast writers) provided object members are written in name order, as jsoncpp sorts
+ * them
+ *
+ * The buffer is kept between documents (see Reset()) so once it has grown large
+ * enough writing involves no allocations, making it suitable for sending object state
+ * at high rates
+ *
+ * Typical usage:
+ *
+ *  writer.Reset();
+ *  writer.StartObject();
+ *  writer.Key("x"); writer.Double(x);
+ *  writer.EndObject();
+ *  send(writer.GetString());
+ */
+/*--------------------------------------------------------------------------------*/
+class JSONWriter
+{
+public:
+  JSONWriter(bool pretty = true);
+  ~JSONWriter() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Clear output to start a new document (keeping the buffer)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Reset();
+  void Reset(bool _pretty) {pretty = _pretty; Reset();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether output is pretty (styled) rather than compact
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsPretty() const {return pretty;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start/end object or array
+   */
+  /*--------------------------------------------------------------------------------*/
+  void StartObject() {StartContainer(true);}
+  void EndObject()   {EndContainer('}');}
+  void StartArray()  {StartContainer(false);}
+  void EndArray()    {EndContainer(']');}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write name of next object member
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Key(const char *name);
+  void Key(const char *name, size_t len);
+  void Key(const std::string& name) {Key(name.c_str(), name.length());}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write values
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Null();
+  void Bool(bool val);
+  void Int(sllong_t val);
+  void UInt(ullong_t val);
+  void Double(double val);
+  void String(const char *str);
+  void String(const char *str, size_t len);
+  void String(const std::string& str) {String(str.c_str(), str.length());}
+
+#if ENABLE_JSON
+  /*--------------------------------------------------------------------------------*/
+  /** Write jsoncpp value
+   *
+   * This allows objects that do not support streaming to be written to the stream
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Write(const Json::Value& obj);
+#endif
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return JSON text, completing the document first if necessary
+   *
+   * @note as json::ToJSONString(), an empty (or null) document is returned as '{}'
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::string& GetString();
+
+protected:
+  typedef struct
+  {
+    bool   object;                      // false for array
+    bool   member;                      // container is the value of an object member
+    uint_t count;                       // number of members/elements written
+  } LEVEL;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start/end object or array
+   */
+  /*--------------------------------------------------------------------------------*/
+  void StartContainer(bool object);
+  void EndContainer(char bracket);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Prepare for a value (adding separators and indentation within arrays)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void BeginValue() {if (!stack.empty() && !stack.back().object) BeginChild(stack.back());}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Prepare for an object member or array element
+   */
+  /*--------------------------------------------------------------------------------*/
+  void BeginChild(LEVEL& level);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start new line indented by depth levels
+   */
+  /*--------------------------------------------------------------------------------*/
+  void NewLine(size_t depth) {buffer += '\n'; buffer.append(depth, '\t');}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append quoted and escaped string
+   */
+  /*--------------------------------------------------------------------------------*/
+  void AppendQuoted(const char *str, size_t len);
+
+protected:
+  std::string        buffer;
+  std::vector<LEVEL> stack;
+  bool               pretty;
+  bool               complete;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
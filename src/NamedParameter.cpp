@@ -1,3 +1,4 @@
+#include <string.h>
 
 #define BBCDEBUG_LEVEL 1
 #include "NamedParameter.h"
@@ -33,6 +34,67 @@ namespace json
     ToJSON(&list[0], list.size(), obj, all);
   }
 
+  /*--------------------------------------------------------------------------------*/
+  /** Write list of NamedParameter objects to a streaming JSON or CBOR writer as an object
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename WRITER>
+  static void WriteParameters(const INamedParameter * const *list, uint_t n, WRITER& writer, bool all)
+  {
+    const INamedParameter *stackorder[32];
+    std::vector<const INamedParameter *> heaporder;
+    const INamedParameter **order = stackorder;
+    uint_t i, j, count = 0;
+
+    if (n > NUMBEROF(stackorder))
+    {
+      heaporder.resize(n);
+      order = &heaporder[0];
+    }
+
+    // members must be written in name order (as jsoncpp would) so insertion sort
+    // the parameters that are to be written
+    for (i = 0; i < n; i++)
+    {
+      const INamedParameter *parameter = list[i];
+
+      if (all || parameter->IsSet())
+      {
+        for (j = count; (j > 0) && (strcmp(order[j - 1]->GetName(), parameter->GetName()) > 0); j--) order[j] = order[j - 1];
+        order[j] = parameter;
+        count++;
+      }
+    }
+
+    if (count)
+    {
+      writer.StartObject();
+      for (i = 0; i < count; i++)
+      {
+        writer.Key(order[i]->GetName());
+        order[i]->ToJSON(writer);
+      }
+      writer.EndObject();
+    }
+    else writer.Null();
+  }
+  void ToJSON(const INamedParameter * const *list, uint_t n, JSONWriter& writer, bool all)
+  {
+    WriteParameters(list, n, writer, all);
+  }
+  void ToJSON(const std::vector<INamedParameter *>& list, JSONWriter& writer, bool all)
+  {
+    WriteParameters(&list[0], list.size(), writer, all);
+  }
+  void ToJSON(const INamedParameter * const *list, uint_t n, CBORWriter& writer, bool all)
+  {
+    WriteParameters(list, n, writer, all);
+  }
+  void ToJSON(const std::vector<INamedParameter *>& list, CBORWriter& writer, bool all)
+  {
+    WriteParameters(&list[0], list.size(), writer, all);
+  }
+
   /*--------------------------------------------------------------------------------*/
   /** Convert from a JSON object to a set of NamedParameters
    *
@@ -73,6 +135,75 @@ namespace json
   {
     return FromJSON(obj, &list[0], list.size(), reset);
   }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read an object from a streaming JSON or CBOR reader into a set of NamedParameters
+   *
+   * @param reader streaming reader, the next value of which is the source object
+   * @param list of NamedParameter objects to extract
+   * @param reset true to reset parameters that are not specified
+   *
+   * @return true if the object was read and all [found] parameters were evaluated properly
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename READER>
+  static bool ReadParameters(READER& reader, INamedParameter * const *list, uint_t n, bool reset)
+  {
+    std::vector<bool> found(n, false);
+    uint_t i;
+    bool success = false;
+
+    if (reader.Next() == READER::Token_ObjectStart)
+    {
+      success = true;
+
+      while (reader.Next() == READER::Token_Key)
+      {
+        const std::string& name = reader.GetKey();
+
+        for (i = 0; (i < n) && (name != list[i]->GetName()); i++) ;
+
+        if (i < n)
+        {
+          // if parameter exists, set it
+          BBCDEBUG3(("Member '%s' found", list[i]->GetName()));
+          success &= list[i]->FromJSON(reader);
+          found[i] = true;
+        }
+        else reader.SkipValue();
+      }
+
+      success &= (reader.GetToken() == READER::Token_ObjectEnd);
+
+      if (reset)
+      {
+        // reset parameters that were not found to their defaults
+        for (i = 0; i < n; i++)
+        {
+          if (!found[i]) list[i]->Reset();
+        }
+      }
+    }
+    else reader.Skip();
+
+    return success;
+  }
+  bool FromJSON(JSONReader& reader, INamedParameter * const *list, uint_t n, bool reset)
+  {
+    return ReadParameters(reader, list, n, reset);
+  }
+  bool FromJSON(JSONReader& reader, const std::vector<INamedParameter *>& list, bool reset)
+  {
+    return ReadParameters(reader, &list[0], list.size(), reset);
+  }
+  bool FromJSON(CBORReader& reader, INamedParameter * const *list, uint_t n, bool reset)
+  {
+    return ReadParameters(reader, list, n, reset);
+  }
+  bool FromJSON(CBORReader& reader, const std::vector<INamedParameter *>& list, bool reset)
+  {
+    return ReadParameters(reader, &list[0], list.size(), reset);
+  }
 };
 #endif
 
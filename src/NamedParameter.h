@@ -13,8 +13,12 @@ BBC_AUDIOTOOLBOX_START
 class INamedParameter : public JSONSerializable
 {
 public:
+  INamedParameter() : JSONSerializable(),
+                      generation(0) {}
+  virtual ~INamedParameter() {}
+
   /*--------------------------------------------------------------------------------*/
-  /** Assignment operator (requires upcasting using dynamic_cast<>)
+  /** Assignment operator
    *
    * @note assigning a NamedParameter of a different type will result in no change
    */
@@ -22,13 +26,47 @@ public:
   virtual INamedParameter& operator = (const INamedParameter& obj) = 0;
 
   /*--------------------------------------------------------------------------------*/
-  /** Comparison operator (requires upcasting using dynamic_cast<>)
+  /** Comparison operator
    *
    * @note comparison with a NamedParameter of a different type will return false
    */
   /*--------------------------------------------------------------------------------*/
   virtual bool operator == (const INamedParameter& obj) const = 0;
 
+  /*--------------------------------------------------------------------------------*/
+  /** Return tag identifying the value type of the parameter
+   *
+   * @note all NamedParameter<TYPE> objects of the same TYPE in the same module have the
+   * same tag so this can be used as a fast check of whether two parameters are compatible;
+   * parameters from different modules (e.g. Windows DLLs) may have different tags for the
+   * same TYPE so different tags do NOT mean the parameters are incompatible
+   * @note the default returns NULL (not compatible with any NamedParameter<TYPE>) so that
+   * existing implementations of this interface do not need to supply a tag
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual const void *GetTypeID() const {return NULL;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return a new copy of the parameter (value and type only)
+   *
+   * @note the copy is NOT an instance of the derived class so any overridden default
+   * or textual conversions are not available - it is intended for holding the value
+   * (e.g. for passing between threads)
+   * @note the default returns NULL (parameter cannot be copied)
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual INamedParameter *Clone() const {return NULL;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return generation counter of parameter
+   *
+   * @note the counter is incremented *every* time the parameter is set, assigned or reset
+   * (even if the value does not change) so a change since a previous call can be detected
+   * by comparing the counters (see NamedParameterGroup)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetGeneration() const {return generation;}
+
   /*--------------------------------------------------------------------------------*/
   /** Reset parameter back to its default
    */
@@ -66,6 +104,9 @@ public:
   /*--------------------------------------------------------------------------------*/
   virtual INamedParameter& operator = (const JSONValue& obj) = 0;
 #endif
+
+protected:
+  uint_t generation;
 };
 
 /*--------------------------------------------------------------------------------*/
@@ -74,6 +115,10 @@ public:
  * @param TYPE type of parameter value (int, double, std::string, etc)
  *
  * @note MUST be derived from to supply name
+ *
+ * @note the value accessors (Get(), Set(), casting, etc) are virtual so that derived
+ * classes can override them; Value(), SetValue() and IsValueSet() are non-virtual
+ * equivalents that can be inlined in per-block processing
  */
 /*--------------------------------------------------------------------------------*/
 template<typename TYPE>
@@ -103,6 +148,14 @@ public:
                                           valueset(false) {operator = (obj);}
 #endif
 
+  /*--------------------------------------------------------------------------------*/
+  /** Copy constructor
+   */
+  /*--------------------------------------------------------------------------------*/
+  NamedParameter(const NamedParameter& obj) : INamedParameter(),
+                                              value(obj.value),
+                                              valueset(obj.valueset) {}
+
   /*--------------------------------------------------------------------------------*/
   /** Copy constructor (upcasting as necessary)
    */
@@ -117,14 +170,27 @@ public:
   virtual ~NamedParameter() {}
 
   /*--------------------------------------------------------------------------------*/
-  /** Assignment operator (requires upcasting using dynamic_cast<>)
+  /** Return tag identifying TYPE (see INamedParameter::GetTypeID())
+   */
+  /*--------------------------------------------------------------------------------*/
+  static const void *TypeID() {static char id; return &id;}
+  virtual const void *GetTypeID() const final {return TypeID();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return a new copy of the parameter (value and type only)
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual INamedParameter *Clone() const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Assignment operator
    *
    * @note assigning a NamedParameter of a different type will result in no change
    */
   /*--------------------------------------------------------------------------------*/
   virtual NamedParameter& operator = (const INamedParameter& obj)
   {
-    const NamedParameter *p = dynamic_cast<const NamedParameter *>(&obj);
+    const NamedParameter *p = Cast(obj);
     if (p) *this = *p;
     return *this;
   }
@@ -132,12 +198,12 @@ public:
   /** Concrete assignment operator
    */
   /*--------------------------------------------------------------------------------*/
-  virtual NamedParameter& operator = (const NamedParameter& obj) {value = obj.value; valueset = obj.valueset; return *this;}
+  virtual NamedParameter& operator = (const NamedParameter& obj) {value = obj.value; valueset = obj.valueset; generation++; return *this;}
   /*--------------------------------------------------------------------------------*/
   /** Assignment from value
    */
   /*--------------------------------------------------------------------------------*/
-  virtual NamedParameter& operator = (const TYPE& obj) {value = obj; valueset = true; return *this;}
+  virtual NamedParameter& operator = (const TYPE& obj) {value = obj; MarkAsSet(); return *this;}
 
   /*--------------------------------------------------------------------------------*/
   /** Cast to value type
@@ -146,14 +212,14 @@ public:
   virtual operator const TYPE& () const {return value;}
 
   /*--------------------------------------------------------------------------------*/
-  /** Comparison operator (requires upcasting using dynamic_cast<>)
+  /** Comparison operator
    *
    * @note comparison with a NamedParameter of a different type will return false
    */
   /*--------------------------------------------------------------------------------*/
   virtual bool operator == (const INamedParameter& obj) const
   {
-    const NamedParameter *p = dynamic_cast<const NamedParameter *>(&obj);
+    const NamedParameter *p = Cast(obj);
     return (p && (*p == *this));
   }
 
@@ -188,7 +254,7 @@ public:
   /*--------------------------------------------------------------------------------*/
   /** Return writable reference to value (use with care!)
    *
-   * @note if value is modified, MarkAsSet() MUST be called
+   * @note if value is modified, MarkAsSet() MUST be called (to update the generation counter)
    */
   /*--------------------------------------------------------------------------------*/
   virtual TYPE& GetWritable() {return value;}
@@ -197,14 +263,24 @@ public:
   /** Set value and mark value as set
    */
   /*--------------------------------------------------------------------------------*/
-  virtual TYPE& Set()                {valueset = true; return value;}
-  virtual void  Set(const TYPE& obj) {value = obj; valueset = true;}
+  virtual TYPE& Set()                {MarkAsSet(); return value;}
+  virtual void  Set(const TYPE& obj) {value = obj; MarkAsSet();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Non-virtual value access for per-block processing
+   *
+   * @note these bypass any overrides of the virtual accessors above
+   */
+  /*--------------------------------------------------------------------------------*/
+  const TYPE& Value()      const {return value;}
+  bool        IsValueSet() const {return valueset;}
+  void        SetValue(const TYPE& obj) {value = obj; valueset = true; generation++;}
 
   /*--------------------------------------------------------------------------------*/
   /** Reset parameter back to its default
    */
   /*--------------------------------------------------------------------------------*/
-  virtual void Reset() {value = GetDefaultValue(); valueset = false;}
+  virtual void Reset() {value = GetDefaultValue(); valueset = false; generation++;}
 
   /*--------------------------------------------------------------------------------*/
   /** Return whether parameter has been set
@@ -216,7 +292,7 @@ public:
   /** Mark the parameter as set (if GetWritable() was used, for example)
    */
   /*--------------------------------------------------------------------------------*/
-  virtual void MarkAsSet() {valueset = true;}
+  virtual void MarkAsSet() {valueset = true; generation++;}
 
   /*--------------------------------------------------------------------------------*/
   /** Return textual representation of parameter value
@@ -228,7 +304,7 @@ public:
   /** Convert string to value
    */
   /*--------------------------------------------------------------------------------*/
-  virtual bool FromString(const std::string& str) {bool success = Evaluate(str, value); valueset |= success; return success;}
+  virtual bool FromString(const std::string& str) {bool success = Evaluate(str, value); if (success) MarkAsSet(); return success;}
 
 #if ENABLE_JSON
   /*--------------------------------------------------------------------------------*/
@@ -244,7 +320,29 @@ public:
   virtual bool FromJSON(const JSONValue& obj)
   {
     bool success = json::FromJSON(obj, value);
-    valueset |= success;
+    if (success) MarkAsSet();
+    return success;
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set value from the next value of a streaming JSON reader
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(JSONReader& reader)
+  {
+    bool success = json::FromJSON(reader, value);
+    if (success) MarkAsSet();
+    return success;
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set value from the next value of a streaming CBOR reader
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(CBORReader& reader)
+  {
+    bool success = json::FromJSON(reader, value);
+    if (success) MarkAsSet();
     return success;
   }
 
@@ -259,6 +357,18 @@ public:
    */
   /*--------------------------------------------------------------------------------*/
   virtual void ToJSON(JSONValue& obj) const {return json::ToJSON(value, obj);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write value to streaming JSON writer
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void ToJSON(JSONWriter& writer) const {json::ToJSON(value, writer);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write value to streaming CBOR writer
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void ToJSON(CBORWriter& writer) const {json::ToJSON(value, writer);}
 #endif
 
 protected:
@@ -268,11 +378,49 @@ protected:
   /*--------------------------------------------------------------------------------*/
   virtual TYPE GetDefaultValue() const {return TYPE();}
 
+  /*--------------------------------------------------------------------------------*/
+  /** Return obj as a NamedParameter of this type or NULL if it is a different type
+   *
+   * @note the type tag is checked first and dynamic_cast<> is only used if the tags differ
+   * (each module has its own tag for a TYPE, see INamedParameter::GetTypeID())
+   */
+  /*--------------------------------------------------------------------------------*/
+  static const NamedParameter *Cast(const INamedParameter& obj)
+  {
+    if (obj.GetTypeID() == TypeID()) return static_cast<const NamedParameter *>(&obj);
+    return dynamic_cast<const NamedParameter *>(&obj);
+  }
+
 protected:
   TYPE value;
   bool valueset;
 };
 
+/*--------------------------------------------------------------------------------*/
+/** Value-only copy of a NamedParameter (see INamedParameter::Clone())
+ *
+ * @note the name is copied because GetName() of the original may not return static storage
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename TYPE>
+class NamedParameterCopy : public NamedParameter<TYPE>
+{
+public:
+  NamedParameterCopy(const NamedParameter<TYPE>& obj) : NamedParameter<TYPE>(obj),
+                                                        name(obj.GetName()) {}
+
+  virtual const char *GetName() const {return name.c_str();}
+
+protected:
+  std::string name;
+};
+
+template<typename TYPE>
+INamedParameter *NamedParameter<TYPE>::Clone() const
+{
+  return new NamedParameterCopy<TYPE>(*this);
+}
+
 #if ENABLE_JSON
 namespace json
 {
@@ -286,6 +434,23 @@ namespace json
   /*--------------------------------------------------------------------------------*/
   extern void ToJSON(const std::vector<INamedParameter *>& list, JSONValue& obj, bool all = false);
   extern void ToJSON(const INamedParameter * const *list, uint_t n, JSONValue& obj, bool all = false);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write list of NamedParameter objects to a streaming JSON or CBOR writer as an object
+   *
+   * @param list of NamedParameter objects
+   * @param writer streaming writer
+   * @param all true to include parameters that are at their default
+   *
+   * @note output is the same as converting into an empty JSONValue above (null if no
+   * parameters are written)
+   */
+  /*--------------------------------------------------------------------------------*/
+  extern void ToJSON(const std::vector<INamedParameter *>& list, JSONWriter& writer, bool all = false);
+  extern void ToJSON(const INamedParameter * const *list, uint_t n, JSONWriter& writer, bool all = false);
+  extern void ToJSON(const std::vector<INamedParameter *>& list, CBORWriter& writer, bool all = false);
+  extern void ToJSON(const INamedParameter * const *list, uint_t n, CBORWriter& writer, bool all = false);
+
   /*--------------------------------------------------------------------------------*/
   /** Convert from a JSON object to a set of NamedParameters
    *
@@ -298,6 +463,23 @@ namespace json
   /*--------------------------------------------------------------------------------*/
   extern bool FromJSON(const JSONValue& obj, const std::vector<INamedParameter *>& list, bool reset = true);
   extern bool FromJSON(const JSONValue& obj, INamedParameter * const *list, uint_t n, bool reset = true);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Read an object from a streaming JSON or CBOR reader into a set of NamedParameters
+   *
+   * @param reader streaming reader, the next value of which is the source object
+   * @param list of NamedParameter objects to extract
+   * @param reset true to reset parameters that are not specified
+   *
+   * @return true if the object was read and all [found] parameters were evaluated properly
+   *
+   * @note members that do not match any parameter are skipped
+   */
+  /*--------------------------------------------------------------------------------*/
+  extern bool FromJSON(JSONReader& reader, const std::vector<INamedParameter *>& list, bool reset = true);
+  extern bool FromJSON(JSONReader& reader, INamedParameter * const *list, uint_t n, bool reset = true);
+  extern bool FromJSON(CBORReader& reader, const std::vector<INamedParameter *>& list, bool reset = true);
+  extern bool FromJSON(CBORReader& reader, INamedParameter * const *list, uint_t n, bool reset = true);
 };
 #endif
 
@@ -331,7 +513,7 @@ public:
   __##name##Parameter& operator = (const type& val) {NamedParameter::operator = (val); return *this;}                               \
   const char  *GetName() const {return #name;}                                                                                      \
   std::string ToString() const {std::string res = StringFrom(value, fmt); return res;}                                              \
-  bool        FromString(const std::string& str) {bool success = Evaluate(str, value, true); valueset |= success; return success;}  \
+  bool        FromString(const std::string& str) {bool success = Evaluate(str, value, true); if (success) MarkAsSet(); return success;}\
 };                                                                                                                                  \
 __##name##Parameter name;
 
@@ -349,7 +531,7 @@ public:
   __##name##Parameter& operator = (const uint64_t& val) {NamedParameter::operator = (val); return *this;}                       \
   const char  *GetName() const {return #name;}                                                                                  \
   std::string ToString() const {std::string res = GenerateTime(value); return res;}                                             \
-  bool        FromString(const std::string& str) {bool success = CalcTime(value, str); valueset |= success; return success;}    \
+  bool        FromString(const std::string& str) {bool success = CalcTime(value, str); if (success) MarkAsSet(); return success;}  \
 };                                                                                                                              \
 __##name##Parameter name;
 
@@ -0,0 +1,193 @@
+#include <algorithm>
+
+#define BBCDEBUG_LEVEL 1
+#include "NamedParameterGroup.h"
+
+BBC_AUDIOTOOLBOX_START
+
+NamedParameterGroup::NamedParameterGroup(INamedParameter * const *list, uint_t n)
+{
+  uint_t i;
+
+  for (i = 0; i < n; i++) Add(*list[i]);
+}
+
+NamedParameterGroup::NamedParameterGroup(const std::vector<INamedParameter *>& list)
+{
+  uint_t i;
+
+  for (i = 0; i < list.size(); i++) Add(*list[i]);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add parameter to group
+ */
+/*--------------------------------------------------------------------------------*/
+void NamedParameterGroup::Add(INamedParameter& param)
+{
+  ENTRY entry;
+
+  entry.param      = &param;
+  entry.generation = param.GetGeneration() - 1;       // report as changed by first Consume()
+  entry.changed    = false;
+  entries.push_back(entry);
+
+  // allocate space for the changed list now so that Consume() never allocates
+  changed.reserve(entries.size());
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return whether any parameter has been set since the last Consume() (without consuming)
+ */
+/*--------------------------------------------------------------------------------*/
+bool NamedParameterGroup::HasChanged() const
+{
+  uint_t i;
+
+  for (i = 0; i < entries.size(); i++)
+  {
+    if (entries[i].param->GetGeneration() != entries[i].generation) return true;
+  }
+
+  return false;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Record which parameters have been set since the last Consume()
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t NamedParameterGroup::Consume()
+{
+  uint_t i;
+
+  changed.clear();
+  for (i = 0; i < entries.size(); i++)
+  {
+    ENTRY& entry = entries[i];
+    uint_t generation = entry.param->GetGeneration();
+
+    if ((entry.changed = (generation != entry.generation)) == true)
+    {
+      entry.generation = generation;
+      changed.push_back(i);
+    }
+  }
+
+  return (uint_t)changed.size();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return whether parameter was recorded as changed by the last Consume()
+ */
+/*--------------------------------------------------------------------------------*/
+bool NamedParameterGroup::WasChanged(const INamedParameter& param) const
+{
+  uint_t i;
+
+  for (i = 0; i < entries.size(); i++)
+  {
+    if (entries[i].param == &param) return entries[i].changed;
+  }
+
+  return false;
+}
+
+/*----------------------------------------------------------------------------------------------------*/
+
+NamedParameterMailbox::NamedParameterMailbox(const NamedParameterGroup& group) : posted(group.GetCount()),
+                                                                                  received(group.GetCount()),
+                                                                                  middle(1),
+                                                                                  back(0),
+                                                                                  front(2)
+{
+  uint_t i, j;
+
+  for (i = 0; i < NUMBEROF(slots); i++)
+  {
+    SLOT& slot = slots[i];
+
+    for (j = 0; j < group.GetCount(); j++)
+    {
+      // a clone without a type ID could never be assigned to or from
+      INamedParameter *param = group[j].GetTypeID() ? group[j].Clone() : NULL;
+
+      if (!param && !i) BBCERROR("NamedParameterMailbox: parameter '%s' has no type ID or Clone() and will be ignored", group[j].GetName());
+      slot.params.push_back(param);
+    }
+    slot.generations.resize(group.GetCount());
+  }
+}
+
+NamedParameterMailbox::~NamedParameterMailbox()
+{
+  uint_t i, j;
+
+  for (i = 0; i < NUMBEROF(slots); i++)
+  {
+    for (j = 0; j < slots[i].params.size(); j++) delete slots[i].params[j];
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Post parameters of group that have been set since the last Post() (control thread)
+ */
+/*--------------------------------------------------------------------------------*/
+bool NamedParameterMailbox::Post(const NamedParameterGroup& group)
+{
+  SLOT&  slot = slots[back];
+  uint_t i, n = std::min(group.GetCount(), (uint_t)posted.size());
+  bool   changed = false;
+
+  if (group.GetCount() != posted.size()) BBCERROR("NamedParameterMailbox: posting %u parameters to mailbox of %u parameters", group.GetCount(), (uint_t)posted.size());
+
+  for (i = 0; i < n; i++)
+  {
+    if (!slot.params[i]) continue;
+
+    uint_t generation = group[i].GetGeneration();
+
+    changed |= (generation != posted[i]);
+    posted[i] = generation;
+
+    // the back slot may be older than the last one posted so bring every out of date parameter up to date
+    if (generation != slot.generations[i])
+    {
+      *slot.params[i] = group[i];
+      slot.generations[i] = generation;
+    }
+  }
+
+  // publish the slot, taking the previous middle slot as the new back slot
+  if (changed) back = middle.exchange(back | Slot_New, std::memory_order_acq_rel) & Slot_Mask;
+
+  return changed;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Copy parameters posted since the last Receive() into group (audio thread)
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t NamedParameterMailbox::Receive(NamedParameterGroup& group)
+{
+  uint_t i, n = std::min(group.GetCount(), (uint_t)received.size()), count = 0;
+
+  if (!(middle.load(std::memory_order_relaxed) & Slot_New)) return 0;
+
+  // take the latest posted slot, giving back the current front slot
+  front = middle.exchange(front, std::memory_order_acq_rel) & Slot_Mask;
+
+  const SLOT& slot = slots[front];
+  for (i = 0; i < n; i++)
+  {
+    if (slot.params[i] && (slot.generations[i] != received[i]))
+    {
+      group[i] = *slot.params[i];
+      received[i] = slot.generations[i];
+      count++;
+    }
+  }
+
+  return count;
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,164 @@
+#ifndef __NAMED_PARAMETER_GROUP__
+#define __NAMED_PARAMETER_GROUP__
+
+#include <vector>
+#include <atomic>
+
+#include "NamedParameter.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Group of NamedParameters with change tracking
+ *
+ * Consume() compares the generation counter of each parameter with the one seen at the
+ * previous Consume() and records which parameters were set in between so that processors
+ * only need to recompute state derived from parameters that have changed:
+ *
+ *   if (group.Consume())
+ *   {
+ *     if (group.WasChanged(0)) ...
+ *   }
+ *
+ * Parameters are reported as changed by the first Consume() after they are added
+ *
+ * @note the group does NOT own the parameters
+ * @note Consume() does not allocate memory so can be called from the audio thread
+ */
+/*--------------------------------------------------------------------------------*/
+class NamedParameterGroup
+{
+public:
+  NamedParameterGroup() {}
+  NamedParameterGroup(INamedParameter * const *list, uint_t n);
+  NamedParameterGroup(const std::vector<INamedParameter *>& list);
+  ~NamedParameterGroup() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add parameter to group
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Add(INamedParameter& param);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of parameters in group
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetCount() const {return (uint_t)entries.size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return parameter at index
+   */
+  /*--------------------------------------------------------------------------------*/
+  INamedParameter& operator [] (uint_t index) const {return *entries[index].param;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether any parameter has been set since the last Consume() (without consuming)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool HasChanged() const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Record which parameters have been set since the last Consume()
+   *
+   * @return number of parameters changed
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Consume();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether parameter was recorded as changed by the last Consume()
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool WasChanged(uint_t index) const {return entries[index].changed;}
+  bool WasChanged(const INamedParameter& param) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return indices of parameters recorded as changed by the last Consume()
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::vector<uint_t>& GetChanged() const {return changed;}
+
+protected:
+  typedef struct
+  {
+    INamedParameter *param;
+    uint_t          generation;         // generation at last Consume()
+    bool            changed;
+  } ENTRY;
+
+protected:
+  std::vector<ENTRY>  entries;
+  std::vector<uint_t> changed;
+};
+
+/*--------------------------------------------------------------------------------*/
+/** Lock-free mailbox for passing parameter updates from one (control) thread to
+ * another (audio) thread
+ *
+ * The mailbox holds three copies of the parameters (triple buffering) and only one
+ * atomic exchange is needed to post or receive a consistent set of values:
+ *
+ * Control thread: set parameters of its own group and then call Post()
+ * Audio thread:   call Receive() once per block to copy new values into its own group
+ *                 (which then reports them through Consume())
+ *
+ * Only parameters that have been set since the last Post()/Receive() are copied and if
+ * several Post()'s occur between Receive()'s, only the latest values are received
+ *
+ * @note the groups passed to Post() and Receive() MUST contain parameters of the same
+ * types in the same order as the group the mailbox was created from
+ * @note there must be only one posting thread and one receiving thread
+ * @note parameters without a type ID or Clone() (see INamedParameter) cannot be passed
+ * through the mailbox and are ignored
+ * @note receiving does not allocate memory unless the parameter values themselves do
+ * (e.g. std::string)
+ */
+/*--------------------------------------------------------------------------------*/
+class NamedParameterMailbox
+{
+public:
+  NamedParameterMailbox(const NamedParameterGroup& group);
+  ~NamedParameterMailbox();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Post parameters of group that have been set since the last Post() (control thread)
+   *
+   * @return true if any parameters were posted
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Post(const NamedParameterGroup& group);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Copy parameters posted since the last Receive() into group (audio thread)
+   *
+   * @return number of parameters copied
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Receive(NamedParameterGroup& group);
+
+protected:
+  typedef struct
+  {
+    std::vector<INamedParameter *> params;         // NULL for parameters that cannot be passed
+    std::vector<uint_t>            generations;    // generation of posted parameter each value came from
+  } SLOT;
+
+  enum
+  {
+    Slot_Mask = 3,
+    Slot_New  = 4,                      // set in middle when a slot has been posted but not received
+  };
+
+protected:
+  SLOT                slots[3];
+  std::vector<uint_t> posted;           // generations of posting parameters at last Post()
+  std::vector<uint_t> received;         // generations of posting parameters at last Receive()
+  std::atomic<uint_t> middle;           // slot being exchanged (plus Slot_New)
+  uint_t              back;             // slot owned by posting thread
+  uint_t              front;            // slot owned by receiving thread
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
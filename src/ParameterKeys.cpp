@@ -0,0 +1,340 @@
+#include <string.h>
+
+#include <algorithm>
+
+#define BBCDEBUG_LEVEL 0
+#include "ParameterKeys.h"
+
+BBC_AUDIOTOOLBOX_START
+
+const ParameterKeys::KEY ParameterKeys::Invalid;
+const uint_t ParameterKeys::Removed;
+const uint_t ParameterKeys::Dead;
+
+ParameterKeys::ParameterKeys() : count(0),
+                                 live(0),
+                                 removecount(MinRemoveCount),
+                                 readers(0),
+                                 table(new TABLE(1024)),
+                                 used(0),
+                                 tlock("ParameterKeys")
+{
+  uint_t i;
+
+  for (i = 0; i < NUMBEROF(chunks); i++) chunks[i].store(NULL, std::memory_order_relaxed);
+}
+
+ParameterKeys::~ParameterKeys()
+{
+  uint_t i;
+
+  for (i = 0; i < NUMBEROF(chunks); i++) delete[] chunks[i].load();
+  for (i = 0; i < oldtables.size(); i++) delete oldtables[i];
+  delete table.load();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return global table
+ */
+/*--------------------------------------------------------------------------------*/
+ParameterKeys& ParameterKeys::Get()
+{
+  // never destroyed because static ParameterSets may release names during shutdown
+  static ParameterKeys *keys = new ParameterKeys;
+  return *keys;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** FNV-1a hash of name (continuing from hash of previous part of name)
+ */
+/*--------------------------------------------------------------------------------*/
+uint32_t ParameterKeys::Hash(const char *name, size_t len, uint32_t hash)
+{
+  size_t i;
+
+  for (i = 0; i < len; i++) hash = (hash ^ (uint8_t)name[i]) * 16777619U;
+
+  return hash;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Find '<name of parent>.<name>', optionally adding a reference
+ */
+/*--------------------------------------------------------------------------------*/
+ParameterKeys::KEY ParameterKeys::Find(KEY parent, const std::string& name, bool addref) const
+{
+  if (parent == Invalid) return Find(NULL, name.c_str(), name.length(), Hash(name.c_str(), name.length()), addref);
+
+  const NODE& node = GetNode(parent);
+  return Find(&node, name.c_str(), name.length(), Hash(name.c_str(), name.length(), Hash(".", 1, node.hash)), addref);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Find name (prefixed by name of parent and '.' if parent is not NULL) with pre-calculated hash
+ */
+/*--------------------------------------------------------------------------------*/
+ParameterKeys::KEY ParameterKeys::Find(const NODE *parent, const char *name, size_t len, uint32_t hash, bool addref) const
+{
+  KEY key = Invalid;
+
+  // removed names and replaced tables are not re-used whilst any lookups are in progress
+  // (see Reclaim())
+  readers.fetch_add(1, std::memory_order_seq_cst);
+
+  const TABLE *tab   = table.load(std::memory_order_acquire);
+  const char  *pname = parent ? parent->name.c_str() : NULL;
+  size_t       plen  = parent ? parent->name.length() + 1 : 0;
+  uint_t i = hash & tab->mask, slot;
+
+  // the acquire on the slot makes the node it refers to visible
+  while ((slot = tab->slots[i].load(std::memory_order_acquire)) != 0)
+  {
+    if (slot != Removed)
+    {
+      const NODE& node = GetNode(chunks, slot - 1);
+      const char  *str = node.name.c_str();
+
+      if ((node.hash == hash) &&
+          (node.name.length() == (plen + len)) &&
+          (!plen || ((memcmp(str, pname, plen - 1) == 0) && (str[plen - 1] == '.'))) &&
+          (memcmp(str + plen, name, len) == 0))
+      {
+        key = node.key;
+
+        if (addref)
+        {
+          uint_t refs = node.refs.load(std::memory_order_relaxed);
+
+          // a name that is being removed cannot be referenced again
+          while ((refs != Dead) && !node.refs.compare_exchange_weak(refs, refs + 1, std::memory_order_relaxed)) ;
+          if (refs == Dead) key = Invalid;
+        }
+        break;
+      }
+    }
+
+    i = (i + 1) & tab->mask;
+  }
+
+  readers.fetch_sub(1, std::memory_order_release);
+
+  return key;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add node index to hash table
+ *
+ * @return true if a previously empty slot was used
+ */
+/*--------------------------------------------------------------------------------*/
+bool ParameterKeys::Insert(TABLE *tab, uint_t index, uint32_t hash)
+{
+  uint_t i = hash & tab->mask, slot;
+
+  // the name is not in the table so the first removed slot can be re-used
+  while (((slot = tab->slots[i].load(std::memory_order_relaxed)) != 0) && (slot != Removed)) i = (i + 1) & tab->mask;
+
+  tab->slots[i].store(index + 1, std::memory_order_release);
+
+  return (slot == 0);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return key of name with a reference added, adding it (and its parents) if necessary
+ */
+/*--------------------------------------------------------------------------------*/
+ParameterKeys::KEY ParameterKeys::Intern(const char *name, size_t len)
+{
+  uint32_t hash = Hash(name, len);
+  KEY key;
+
+  if ((key = Find(NULL, name, len, hash, true)) == Invalid)
+  {
+    KEY    parent = Invalid;
+    size_t p      = len;
+
+    // intern parent first (outside of the lock)
+    while ((p > 0) && (name[p - 1] != '.')) p--;
+    if ((p > 0) && ((parent = Intern(name, p - 1)) == Invalid)) return Invalid;
+
+    ThreadLock lock(tlock);
+
+    // check again in case another thread has just added it
+    if ((key = Find(NULL, name, len, hash)) != Invalid)
+    {
+      // names in the table cannot become dead whilst the lock is held
+      AddRef(key);
+
+      // the existing name already references its parent
+      if (parent != Invalid) Release(parent);
+    }
+    else if (((key = Add(name, len, hash, parent)) == Invalid) && (parent != Invalid)) Release(parent);
+  }
+
+  return key;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add new name to the table (with the lock held)
+ *
+ * @return key (with one reference) or Invalid if the table is full
+ */
+/*--------------------------------------------------------------------------------*/
+ParameterKeys::KEY ParameterKeys::Add(const char *name, size_t len, uint32_t hash, KEY parent)
+{
+  TABLE  *tab = table.load(std::memory_order_relaxed);
+  uint_t index;
+  KEY    key;
+
+  if (reusable.empty())
+  {
+    // removing unreferenced names is linear in the size of the table so only do it when
+    // the number of names has doubled since it was last done
+    if (live.load(std::memory_order_relaxed) >= removecount)
+    {
+      RemoveUnreferenced();
+      removecount = std::max(2 * live.load(std::memory_order_relaxed), (uint_t)MinRemoveCount);
+    }
+
+    Reclaim();
+  }
+
+  if (!reusable.empty())
+  {
+    index = reusable.back();
+    reusable.pop_back();
+
+    // next generation of the slot so that keys of the removed name do not match
+    if ((key = GetNode(chunks, index).key + (1U << IndexBits)) == Invalid) key = index;
+  }
+  else
+  {
+    NODE *chunk;
+
+    if ((count >> ChunkBits) >= (uint_t)MaxChunks)
+    {
+      BBCERROR("Parameter name table full, cannot add '%s'", std::string(name, len).c_str());
+      return Invalid;
+    }
+
+    if ((chunk = chunks[count >> ChunkBits].load(std::memory_order_relaxed)) == NULL)
+    {
+      chunk = new NODE[ChunkSize];
+      chunks[count >> ChunkBits].store(chunk, std::memory_order_release);
+    }
+
+    index = key = count++;
+  }
+
+  NODE& node = GetNode(chunks, index);
+  node.name.assign(name, len);
+  node.key    = key;
+  node.parent = parent;
+  node.hash   = hash;
+  node.refs.store(1, std::memory_order_relaxed);
+  node.linked = true;
+
+  live.fetch_add(1, std::memory_order_release);
+
+  // keep the table at most half full (including removed slots)
+  if ((used + 1) * 2 > tab->mask + 1)
+  {
+    uint_t size = tab->mask + 1, i;
+
+    // grow if more than a quarter full of names, otherwise just discard the removed slots
+    if (live.load(std::memory_order_relaxed) * 4 > size) size *= 2;
+
+    TABLE *newtab = new TABLE(size);
+
+    used = 0;
+    for (i = 0; i < count; i++)
+    {
+      const NODE& other = GetNode(chunks, i);
+      if (other.linked) used += Insert(newtab, i, other.hash);
+    }
+
+    // readers may still be using the old table so keep it until Reclaim()
+    oldtables.push_back(tab);
+    table.store(newtab, std::memory_order_release);
+  }
+  else used += Insert(tab, index, hash);
+
+  return key;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove all unreferenced names (with the lock held)
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterKeys::RemoveUnreferenced()
+{
+  uint_t i;
+
+  for (i = 0; i < count; i++)
+  {
+    NODE&  node = GetNode(chunks, i);
+    uint_t refs = 0;
+
+    // the name cannot be referenced again once it is dead
+    if (node.linked && node.refs.compare_exchange_strong(refs, Dead, std::memory_order_acquire)) Remove(node);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove dead name from the hash table (with the lock held)
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterKeys::Remove(NODE& node)
+{
+  TABLE  *tab   = table.load(std::memory_order_relaxed);
+  uint_t index  = node.key & IndexMask;
+  uint_t i      = node.hash & tab->mask;
+
+  while (tab->slots[i].load(std::memory_order_relaxed) != (index + 1)) i = (i + 1) & tab->mask;
+
+  // lookups that have already read the slot may still be examining the node so it
+  // cannot be re-used until Reclaim()
+  tab->slots[i].store(Removed, std::memory_order_release);
+  node.linked = false;
+  removed.push_back(index);
+
+  live.fetch_sub(1, std::memory_order_release);
+
+  if (node.parent != Invalid)
+  {
+    NODE&  parent = GetNode(node.parent);
+    uint_t refs   = 1;
+
+    // remove parent as well if this was its last reference (RemoveUnreferenced() may
+    // already have passed it)
+    if (parent.refs.compare_exchange_strong(refs, Dead, std::memory_order_acq_rel)) Remove(parent);
+    else Release(node.parent);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Make removed names and replaced hash tables available for re-use if no lock-free
+ * lookups are in progress (with the lock held)
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterKeys::Reclaim()
+{
+  uint_t i;
+
+  if (removed.empty() && oldtables.empty()) return;
+
+  // pairs with the increment of readers in Find(): either a lookup is counted here or it
+  // started after the removed slots and new table were stored and so cannot see the
+  // removed names or the old tables
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (readers.load(std::memory_order_seq_cst) == 0)
+  {
+    reusable.insert(reusable.end(), removed.begin(), removed.end());
+    removed.clear();
+
+    for (i = 0; i < oldtables.size(); i++) delete oldtables[i];
+    oldtables.clear();
+  }
+}
+
+BBC_AUDIOTOOLBOX_END
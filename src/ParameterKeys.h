@@ -0,0 +1,236 @@
+#ifndef __PARAMETER_KEYS__
+#define __PARAMETER_KEYS__
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+#include "misc.h"
+#include "ThreadLock.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Global table of interned parameter names
+ *
+ * Each distinct name is stored once and identified by a small integer key so that
+ * parameter storage can hash and compare keys instead of strings
+ *
+ * Names are hierarchical using '.' as a separator: interning 'a.b.c' also interns
+ * 'a.b' and 'a' and each key records the key of its parent
+ *
+ * Lookups (Find(), GetName(), GetParent()) and references are lock-free, adding and
+ * removing names is serialised
+ *
+ * Names are reference counted: Intern() and FindRef() add a reference which must be
+ * removed with Release() when the key is no longer needed (each name also references
+ * its parent).  Unreferenced names are kept so that names which are used repeatedly
+ * by short-lived sets are not added again each time but each time the number of names
+ * doubles all unreferenced names are removed and their slots re-used (once no lock-free
+ * lookup can still be examining them) so the table only grows to around twice the peak
+ * number of names in use
+ *
+ * Keys include a generation count for their slot so a key for a removed name never
+ * matches the key of a later name in the same slot.  GetName() and GetParent() must only
+ * be called for keys that are referenced (by the caller or, for example, by a ParameterSet
+ * that holds the name)
+ */
+/*--------------------------------------------------------------------------------*/
+class ParameterKeys
+{
+public:
+  typedef uint_t KEY;
+
+  // key representing no name
+  static const KEY Invalid = ~0U;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return global table
+   */
+  /*--------------------------------------------------------------------------------*/
+  static ParameterKeys& Get();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return key of name or Invalid if name is not in use
+   *
+   * @note no reference is added so the key is only useful for looking up values in sets
+   * that hold the name
+   */
+  /*--------------------------------------------------------------------------------*/
+  KEY Find(const std::string& name) const {return Find(name.c_str(), name.length());}
+  KEY Find(const char *name, size_t len) const {return Find(NULL, name, len, Hash(name, len));}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return key of '<name of parent>.<name>' or Invalid if it is not in use
+   *
+   * @note this does not construct the full name, if parent is Invalid this is the same as Find(name)
+   * @note parent MUST be referenced
+   */
+  /*--------------------------------------------------------------------------------*/
+  KEY Find(KEY parent, const std::string& name) const {return Find(parent, name, false);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return key of name with a reference added or Invalid if name is not in use
+   */
+  /*--------------------------------------------------------------------------------*/
+  KEY FindRef(const std::string& name) {return FindRef(name.c_str(), name.length());}
+  KEY FindRef(const char *name, size_t len) {return Find(NULL, name, len, Hash(name, len), true);}
+  KEY FindRef(KEY parent, const std::string& name) {return Find(parent, name, true);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return key of name with a reference added, adding it (and its parents) if necessary
+   *
+   * @return key or Invalid if the table is full
+   */
+  /*--------------------------------------------------------------------------------*/
+  KEY Intern(const std::string& name) {return Intern(name.c_str(), name.length());}
+  KEY Intern(const char *name, size_t len);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add a reference to a key that is already referenced
+   */
+  /*--------------------------------------------------------------------------------*/
+  void AddRef(KEY key) {GetNode(key).refs.fetch_add(1, std::memory_order_relaxed);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Release a reference to a key
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Release(KEY key) {GetNode(key).refs.fetch_sub(1, std::memory_order_release);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return full name of key
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::string& GetName(KEY key) const {return GetNode(key).name;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return key of parent (name up to the last '.') or Invalid for top-level names
+   */
+  /*--------------------------------------------------------------------------------*/
+  KEY GetParent(KEY key) const {return GetNode(key).parent;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of names (including unreferenced names that have not been removed yet)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetCount() const {return live.load(std::memory_order_acquire);}
+
+protected:
+  ParameterKeys();
+  ~ParameterKeys();
+
+  typedef struct
+  {
+    std::string                 name;
+    KEY                         key;    // including generation
+    KEY                         parent;
+    uint32_t                    hash;
+    mutable std::atomic<uint_t> refs;   // Dead once removed
+    bool                        linked; // in hash table (only accessed with the lock held)
+  } NODE;
+
+  static const uint_t Dead = ~0U;
+
+  // names are stored in fixed size chunks so that they never move
+  enum
+  {
+    ChunkBits = 10,
+    ChunkSize = 1 << ChunkBits,
+    MaxChunks = 4096,
+    IndexBits = ChunkBits + 12,         // enough for MaxChunks * ChunkSize, the rest of the key is the generation
+    IndexMask = (1 << IndexBits) - 1,
+    MinRemoveCount = 1024,              // number of names below which unreferenced names are not removed
+  };
+
+  // open-addressed hash table of node index + 1 (0 = empty, Removed = name removed)
+  static const uint_t Removed = ~0U;
+
+  typedef struct TABLE
+  {
+    TABLE(uint_t size) : mask(size - 1),
+                         slots(size) {}
+    uint_t mask;
+    std::vector<std::atomic<uint_t> > slots;
+  } TABLE;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return node for key
+   */
+  /*--------------------------------------------------------------------------------*/
+  const NODE& GetNode(KEY key) const {return GetNode(chunks, key & IndexMask);}
+  NODE&       GetNode(KEY key)       {return GetNode(chunks, key & IndexMask);}
+  static NODE& GetNode(const std::atomic<NODE *> *chunks, uint_t index) {return chunks[index >> ChunkBits].load(std::memory_order_acquire)[index & (ChunkSize - 1)];}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Find name (prefixed by name of parent and '.' if parent is not NULL) with pre-calculated hash
+   *
+   * @param addref true to add a reference (fails if the name is being removed)
+   */
+  /*--------------------------------------------------------------------------------*/
+  KEY Find(const NODE *parent, const char *name, size_t len, uint32_t hash, bool addref = false) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Find '<name of parent>.<name>', optionally adding a reference
+   */
+  /*--------------------------------------------------------------------------------*/
+  KEY Find(KEY parent, const std::string& name, bool addref) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add new name to the table (with the lock held)
+   *
+   * @return key (with one reference) or Invalid if the table is full
+   */
+  /*--------------------------------------------------------------------------------*/
+  KEY Add(const char *name, size_t len, uint32_t hash, KEY parent);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove all unreferenced names (with the lock held)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void RemoveUnreferenced();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove dead name from the hash table (with the lock held)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Remove(NODE& node);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Make removed names and replaced hash tables available for re-use if no lock-free
+   * lookups are in progress (with the lock held)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Reclaim();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add node index to hash table
+   *
+   * @return true if a previously empty slot was used
+   */
+  /*--------------------------------------------------------------------------------*/
+  static bool Insert(TABLE *table, uint_t index, uint32_t hash);
+
+  /*--------------------------------------------------------------------------------*/
+  /** FNV-1a hash of name (continuing from hash of previous part of name)
+   */
+  /*--------------------------------------------------------------------------------*/
+  static uint32_t Hash(const char *name, size_t len, uint32_t hash = 2166136261U);
+
+protected:
+  std::atomic<NODE *>         chunks[MaxChunks];
+  uint_t                      count;    // number of node indices used
+  std::atomic<uint_t>         live;     // number of names in the hash table
+  uint_t                      removecount; // number of names at which to remove unreferenced names
+  mutable std::atomic<uint_t> readers;  // number of lock-free lookups in progress
+  std::atomic<TABLE *>        table;
+  uint_t                      used;     // number of slots in table that are not empty
+  std::vector<TABLE *>        oldtables; // replaced tables, kept for any readers still using them
+  std::vector<uint_t>         removed;  // indices of removed names, kept for any readers still using them
+  std::vector<uint_t>         reusable; // indices of removed names that can be re-used
+  ThreadLockObject            tlock;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
@@ -9,6 +9,387 @@
 
 BBC_AUDIOTOOLBOX_START
 
+/*--------------------------------------------------------------------------------*/
+/** Append printf style formatted string to str without any temporary allocations
+ */
+/*--------------------------------------------------------------------------------*/
+static void AppendFormatted(std::string& str, const char *fmt, ...)
+{
+  char    buf[256];
+  va_list ap;
+  int     len;
+
+  va_start(ap, fmt);
+  len = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+
+  if (len > 0)
+  {
+    if ((size_t)len < sizeof(buf)) str.append(buf, len);
+    else
+    {
+      // too long for buffer: format directly into the end of the string
+      size_t pos = str.length();
+
+      str.resize(pos + len + 1);
+      va_start(ap, fmt);
+      vsnprintf(&str[pos], len + 1, fmt, ap);
+      va_end(ap);
+      str.resize(pos + len);
+    }
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Comparison operator (values are compared as strings)
+ */
+/*--------------------------------------------------------------------------------*/
+bool ParameterValue::operator == (const ParameterValue& obj) const
+{
+  if (type == obj.type)
+  {
+    switch (type)
+    {
+      case Type_Bool: return (value.b == obj.value.b);
+      case Type_Int:  return (value.i == obj.value.i);
+      case Type_UInt: return (value.u == obj.value.u);
+      case Type_String: return (str == obj.str);
+      // different doubles can generate the same string
+      default: break;
+    }
+  }
+
+  return (ToString() == obj.ToString());
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Get value as string
+ */
+/*--------------------------------------------------------------------------------*/
+bool ParameterValue::Get(std::string& val) const
+{
+  if (type == Type_String) val = str;
+  else
+  {
+    val.clear();
+    Append(val);
+  }
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Append value as a string (as StringFrom() would generate) to str
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterValue::Append(std::string& val) const
+{
+  switch (type)
+  {
+    case Type_String: val += str;                                break;
+    case Type_Bool:   val += value.b ? '1' : '0';                break;
+    case Type_Int:    AppendFormatted(val, "%lld", value.i);     break;
+    case Type_UInt:   AppendFormatted(val, "%llu", value.u);     break;
+    case Type_Double: AppendFormatted(val, "%0.32lf", value.f);  break;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Get value as bool
+ */
+/*--------------------------------------------------------------------------------*/
+bool ParameterValue::Get(bool& val) const
+{
+  switch (type)
+  {
+    case Type_String: return Evaluate(str, val);
+    case Type_Bool:   val = value.b;                       break;
+    case Type_Int:    val = (value.i != 0);                break;
+    case Type_UInt:   val = (value.u != 0);                break;
+    // only the integer part of the formatted string would be parsed
+    case Type_Double: val = ((sllong_t)value.f != 0);      break;
+  }
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Get value as double
+ */
+/*--------------------------------------------------------------------------------*/
+bool ParameterValue::Get(double& val) const
+{
+  switch (type)
+  {
+    case Type_String: return Evaluate(str, val);
+    case Type_Bool:   val = value.b ? 1.0 : 0.0; break;
+    case Type_Int:    val = (double)value.i;     break;
+    case Type_UInt:   val = (double)value.u;     break;
+    case Type_Double: val = value.f;             break;
+  }
+  return true;
+}
+
+const uint_t ParameterTable::Root;
+const uint_t ParameterTable::None;
+
+ParameterTable::ParameterTable()
+{
+  Clear();
+}
+
+ParameterTable::ParameterTable(const ParameterTable& obj) : RefCountedObject(obj),
+                                                            entries(obj.entries),
+                                                            slots(obj.slots),
+                                                            hashbits(obj.hashbits),
+                                                            count(obj.count),
+                                                            deleted(obj.deleted)
+{
+  ParameterKeys& keys = ParameterKeys::Get();
+  uint_t index;
+
+  // the copy holds its own references to names
+  for (index = 1; index < entries.size(); index++) keys.AddRef(entries[index].key);
+}
+
+ParameterTable::~ParameterTable()
+{
+  ReleaseKeys();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Release references to names of all entries
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterTable::ReleaseKeys()
+{
+  ParameterKeys& keys = ParameterKeys::Get();
+  uint_t index;
+
+  for (index = 1; index < entries.size(); index++) keys.Release(entries[index].key);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove all entries
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterTable::Clear()
+{
+  ENTRY root;
+
+  ReleaseKeys();
+
+  root.key        = ParameterKeys::Invalid;
+  root.parent     = None;
+  root.firstchild = None;
+  root.lastchild  = None;
+  root.next       = None;
+  root.hasvalue   = false;
+
+  entries.clear();
+  entries.push_back(root);
+
+  hashbits = 4;
+  slots.assign(1U << hashbits, 0);
+  count   = 0;
+  deleted = 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return index of entry for key (which may not have a value) or None
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t ParameterTable::Find(KEY key) const
+{
+  const uint_t mask = (uint_t)slots.size() - 1;
+  uint_t i = GetSlot(key), index;
+
+  while ((index = slots[i]) != 0)
+  {
+    if (entries[index].key == key) return index;
+    i = (i + 1) & mask;
+  }
+
+  return None;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set value for key, creating an entry if necessary
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterTable::Set(KEY key, const ParameterValue& value, bool referenced)
+{
+  uint_t index;
+
+  if ((index = Find(key)) == None) index = Add(key, referenced);
+  else if (referenced) ParameterKeys::Get().Release(key);
+
+  ENTRY& entry = entries[index];
+  if (!entry.hasvalue)
+  {
+    entry.hasvalue = true;
+    count++;
+  }
+  entry.value = value;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove value for key
+ *
+ * @note the entry is left in the tree (without a value) until enough values have been
+ * deleted to make it worth compacting the table
+ */
+/*--------------------------------------------------------------------------------*/
+bool ParameterTable::Delete(KEY key)
+{
+  uint_t index;
+
+  if (((index = Find(key)) != None) && entries[index].hasvalue)
+  {
+    ENTRY& entry = entries[index];
+
+    entry.hasvalue = false;
+    entry.value    = ParameterValue();
+    count--;
+
+    // compacting is linear in the size of the table so only do it when at least half of it may be dead
+    if ((++deleted > 16) && ((2 * deleted) > entries.size())) Compact();
+    return true;
+  }
+
+  return false;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Rebuild table from the entries with values
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterTable::Compact()
+{
+  ParameterTable table;
+  uint_t index;
+
+  // adding in name order keeps the children lists in order without searching
+  for (index = GetFirst(); index != None; index = GetNext(index))
+  {
+    table.Set(entries[index].key, entries[index].value);
+  }
+
+  // the new entries hold references to the names so the old ones can be released
+  // (by the destructor of table)
+  entries.swap(table.entries);
+  slots.swap(table.slots);
+  hashbits = table.hashbits;
+  count    = table.count;
+  deleted  = 0;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add entry for key (and its parents)
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t ParameterTable::Add(KEY key, bool referenced)
+{
+  ParameterKeys& keys = ParameterKeys::Get();
+  KEY    parentkey = keys.GetParent(key);
+  uint_t parent    = Root;
+  uint_t index     = (uint_t)entries.size();
+
+  if ((parentkey != ParameterKeys::Invalid) && ((parent = Find(parentkey)) == None))
+  {
+    parent = Add(parentkey);
+    index  = (uint_t)entries.size();
+  }
+
+  // the caller holds a reference to key (and each name references its parent)
+  if (!referenced) keys.AddRef(key);
+
+  ENTRY entry;
+  entry.key        = key;
+  entry.parent     = parent;
+  entry.firstchild = None;
+  entry.lastchild  = None;
+  entry.next       = None;
+  entry.hasvalue   = false;
+  entries.push_back(entry);
+
+  // keep the hash table at most half full
+  if (2 * index > slots.size()) Rehash(hashbits + 1);
+  else
+  {
+    const uint_t mask = (uint_t)slots.size() - 1;
+    uint_t i = GetSlot(key);
+
+    while (slots[i]) i = (i + 1) & mask;
+    slots[i] = index;
+  }
+
+  // link into parent's children in name order, names are usually added in order so check the end first
+  const std::string& name = keys.GetName(key);
+  ENTRY& parententry = entries[parent];
+  if (parententry.lastchild == None)
+  {
+    parententry.firstchild = parententry.lastchild = index;
+  }
+  else if (keys.GetName(entries[parententry.lastchild].key) < name)
+  {
+    entries[parententry.lastchild].next = index;
+    parententry.lastchild = index;
+  }
+  else
+  {
+    uint_t *link = &parententry.firstchild;
+
+    while (keys.GetName(entries[*link].key) < name) link = &entries[*link].next;
+
+    entries[index].next = *link;
+    *link = index;
+  }
+
+  return index;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Rebuild hash table with 2^bits slots
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterTable::Rehash(uint_t bits)
+{
+  const uint_t mask = (1U << bits) - 1;
+  uint_t index;
+
+  hashbits = bits;
+  slots.assign(mask + 1, 0);
+
+  for (index = 1; index < entries.size(); index++)
+  {
+    uint_t i = GetSlot(entries[index].key);
+
+    while (slots[i]) i = (i + 1) & mask;
+    slots[i] = index;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return index of next entry with a value below 'root' (in name order) or None
+ */
+/*--------------------------------------------------------------------------------*/
+uint_t ParameterTable::GetNext(uint_t index, uint_t root) const
+{
+  do
+  {
+    // depth first: children, then siblings, then siblings of parents (up to root)
+    if (entries[index].firstchild != None) index = entries[index].firstchild;
+    else
+    {
+      while ((index != root) && (entries[index].next == None)) index = entries[index].parent;
+      if (index == root) return None;
+      index = entries[index].next;
+    }
+  }
+  while (!entries[index].hasvalue);
+
+  return index;
+}
+
 ParameterSet::ParameterSet(const std::string& values)
 {
   operator = (values);
@@ -24,6 +405,16 @@ ParameterSet::ParameterSet(const ParameterSet& obj)
   operator = (obj);
 }
 
+ParameterSet::ParameterSet(const ParameterSetView& view)
+{
+  Iterator it;
+
+  for (it = view.GetBegin(); it != view.GetEnd(); ++it)
+  {
+    Set(it.GetName(), it.GetValue());
+  }
+}
+
 /*--------------------------------------------------------------------------------*/
 /** Assignment operators
  */
@@ -60,19 +451,22 @@ ParameterSet& ParameterSet::operator = (const std::vector<std::string>& values)
 ParameterSet& ParameterSet::operator = (const ParameterSet& obj)
 {
   // do not copy oneself
-  if (&obj != this) values = obj.values;
+  // share table until either set is modified
+  if (&obj != this) table = obj.table;
 
   return *this;
 }
 
 bool ParameterSet::operator == (const ParameterSet& obj) const
 {
-  bool same = map_compare(values, obj.values);
+  const ParameterTable& values = GetTable();
+  bool same = ((&values == &obj.GetTable()) ||
+               ((values.GetCount() == obj.GetTable().GetCount()) && Contains(obj)));
 
 #if BBCDEBUG_LEVEL>=3
   if (!same)
   {
-    BBCDEBUG("ParameterSet sizes %s / %s:", StringFrom(values.size()).c_str(), StringFrom(obj.values.size()).c_str());
+    BBCDEBUG("ParameterSet sizes %s / %s:", StringFrom(values.GetCount()).c_str(), StringFrom(obj.GetTable().GetCount()).c_str());
 
     Iterator it;
     for (it = GetBegin(); it != GetEnd(); ++it)
@@ -96,14 +490,20 @@ bool ParameterSet::operator == (const ParameterSet& obj) const
 /*--------------------------------------------------------------------------------*/
 bool ParameterSet::Contains(const ParameterSet& obj) const
 {
-  std::map<std::string,std::string>::const_iterator it;
+  const ParameterTable& values  = GetTable();
+  const ParameterTable& values2 = obj.GetTable();
+  uint_t index;
 
-  for (it = obj.values.begin(); it != obj.values.end(); ++it)
+  if (&values == &values2) return true;
+
+  // both sets use the same keys so no name lookups are required
+  for (index = values2.GetFirst(); index != ParameterTable::None; index = values2.GetNext(index))
   {
-    std::string val;
+    const ParameterTable::ENTRY& entry = values2.GetEntry(index);
+    const ParameterValue *val;
 
     // if key doesn't exist or the values are different, return false
-    if (!Get(it->first, val) || (val != it->second)) return false;
+    if (!(val = values.GetValue(entry.key)) || (*val != entry.value)) return false;
   }
 
   return true;
@@ -115,11 +515,19 @@ bool ParameterSet::Contains(const ParameterSet& obj) const
 /*--------------------------------------------------------------------------------*/
 ParameterSet& ParameterSet::operator += (const ParameterSet& obj)
 {
-  std::map<std::string,std::string>::const_iterator it;
+  const ParameterTable& values2 = obj.GetTable();
+  uint_t index;
 
-  for (it = obj.values.begin(); it != obj.values.end(); ++it)
+  if (IsEmpty()) table = obj.table;
+  else if (&GetTable() != &values2)
   {
-    values[it->first] = it->second;
+    ParameterTable& values = GetWritableTable();
+
+    for (index = values2.GetFirst(); index != ParameterTable::None; index = values2.GetNext(index))
+    {
+      const ParameterTable::ENTRY& entry = values2.GetEntry(index);
+      values.Set(entry.key, entry.value);
+    }
   }
 
   return *this;
@@ -133,14 +541,18 @@ ParameterSet& ParameterSet::operator += (const ParameterSet& obj)
 /*--------------------------------------------------------------------------------*/
 ParameterSet& ParameterSet::operator -= (const ParameterSet& obj)
 {
-  std::map<std::string,std::string>::const_iterator it;
-  std::map<std::string,std::string>::iterator       it2;
+  const ParameterTable& values2 = obj.GetTable();
+  uint_t index;
 
-  for (it = obj.values.begin(); it != obj.values.end(); ++it)
+  if (&GetTable() == &values2) Clear();
+  else
   {
-    if ((it2 = values.find(it->first)) != values.end())
+    for (index = values2.GetFirst(); index != ParameterTable::None; index = values2.GetNext(index))
     {
-      values.erase(it2);
+      ParameterKeys::KEY key = values2.GetEntry(index).key;
+
+      // only copy a shared table if something is going to be removed
+      if (GetTable().GetValue(key)) GetWritableTable().Delete(key);
     }
   }
 
@@ -153,13 +565,13 @@ ParameterSet& ParameterSet::operator -= (const ParameterSet& obj)
 /*--------------------------------------------------------------------------------*/
 std::string ParameterSet::ToString(bool pretty) const
 {
-  std::map<std::string,std::string>::const_iterator it;
+  Iterator it;
   std::string str;
 
-  for (it = values.begin(); it != values.end(); ++it)
+  for (it = GetBegin(); it != GetEnd(); ++it)
   {
-    if (it != values.begin()) Printf(str, pretty ? "\n" : ", ");
-    Printf(str, "%s %s", it->first.c_str(), it->second.c_str());
+    if (!str.empty()) Printf(str, pretty ? "\n" : ", ");
+    Printf(str, "%s %s", it.GetName().c_str(), it.GetValue().ToString().c_str());
   }
 
   return str;
@@ -172,9 +584,16 @@ std::string ParameterSet::ToString(bool pretty) const
  *
  */
 /*--------------------------------------------------------------------------------*/
-ParameterSet& ParameterSet::Set(const std::string& name, const std::string& val)
+ParameterSet& ParameterSet::Set(const std::string& name, const ParameterValue& val)
 {
-  values[name] = val;
+  ParameterKeys& keys = ParameterKeys::Get();
+  ParameterKeys::KEY key;
+
+  // a name that is already in the set is referenced by it so needs no reference here
+  if (((key = keys.Find(name)) != ParameterKeys::Invalid) && (GetTable().Find(key) != ParameterTable::None)) GetWritableTable().Set(key, val);
+  // otherwise the table takes over the reference added by Intern()
+  else if ((key = keys.Intern(name)) != ParameterKeys::Invalid) GetWritableTable().Set(key, val, true);
+  else BBCERROR("Failed to set parameter '%s' to '%s' (no space for name)", name.c_str(), val.ToString().c_str());
 
   return *this;
 }
@@ -187,26 +606,21 @@ ParameterSet& ParameterSet::Set(const std::string& name, const ParameterSet& val
   // create a set of 'sub-parameters' - parameters with a prefix to indicate a sub object
   for (it = val.GetBegin(); it != val.GetEnd(); ++it)
   {
-    Set(prefix + it->first, it->second);
+    Set(prefix + it.GetName(), it.GetValue());
   }
 
   return *this;
 }
 
 /*--------------------------------------------------------------------------------*/
-/** Get value
- *
- * @param name parameter name
- * @param val reference to value to be set
- *
- * @return true if parameter found and value extracted
+/** Return native value or NULL if the parameter does not exist
  */
 /*--------------------------------------------------------------------------------*/
-bool ParameterSet::Get(const std::string& name, std::string& val) const
+const ParameterValue *ParameterSet::GetValue(const std::string& name) const
 {
-  const std::map<std::string,std::string>::const_iterator it = values.find(name);
-  if (it != values.end()) val = it->second;
-  return (it != values.end());
+  // names that are not in use cannot be in any set
+  ParameterKeys::KEY key = ParameterKeys::Get().Find(name);
+  return (key != ParameterKeys::Invalid) ? GetTable().GetValue(key) : NULL;
 }
 
 /*--------------------------------------------------------------------------------*/
@@ -215,15 +629,30 @@ bool ParameterSet::Get(const std::string& name, std::string& val) const
 /*--------------------------------------------------------------------------------*/
 bool ParameterSet::Delete(const std::string& name)
 {
-  const std::map<std::string,std::string>::iterator it = values.find(name);
+  ParameterKeys::KEY key = ParameterKeys::Get().Find(name);
+  return ((key != ParameterKeys::Invalid) && GetTable().GetValue(key) && GetWritableTable().Delete(key));
+}
 
-  if (it != values.end())
-  {
-    values.erase(it);
-    return true;
-  }
+/*--------------------------------------------------------------------------------*/
+/** Return table for writing, copying it first if it is shared with other sets
+ */
+/*--------------------------------------------------------------------------------*/
+ParameterTable& ParameterSet::GetWritableTable()
+{
+  if (!table) table = new ParameterTable;
+  else if (table.Obj()->IsShared()) table = new ParameterTable(*table.Obj());
 
-  return false;
+  return *table.Obj();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return table used by all empty sets
+ */
+/*--------------------------------------------------------------------------------*/
+const ParameterTable& ParameterSet::GetEmptyTable()
+{
+  static const ParameterTable empty;
+  return empty;
 }
 
 /*--------------------------------------------------------------------------------*/
@@ -232,8 +661,8 @@ bool ParameterSet::Delete(const std::string& name)
 /*--------------------------------------------------------------------------------*/
 std::string ParameterSet::Raw(const std::string& name, const std::string& defval) const
 {
-  const std::map<std::string,std::string>::const_iterator it = values.find(name);
-  return (it != values.end()) ? it->second : defval; 
+  const ParameterValue *val = GetValue(name);
+  return val ? val->ToString() : defval;
 }
 
 /*--------------------------------------------------------------------------------*/
@@ -260,18 +689,15 @@ bool ParameterSet::SplitSubParameter(const std::string& name, std::string& prefi
 /*--------------------------------------------------------------------------------*/
 bool ParameterSet::GetSubParameters(ParameterSet& parameters, const std::string& prefix) const
 {
-  std::string _prefix = prefix + ".";
+  ParameterSetView view(*this, prefix);
   Iterator it;
   bool found = false;
 
-  for (it = GetBegin(); it != GetEnd(); ++it)
+  for (it = view.GetBegin(); it != view.GetEnd(); ++it)
   {
     // e.g. if the name starts with 'vbap.' create a corresponding parameters in parameters
-    if (it->first.find(_prefix) == 0)
-    {
-      parameters.Set(it->first.substr(_prefix.length()), it->second);
-      found = true;
-    }
+    parameters.Set(it.GetName(), it.GetValue());
+    found = true;
   }
 
   return found;
@@ -326,103 +752,8 @@ bool ParameterSet::Get(const std::string& name, ParameterSet& val) const
 /*--------------------------------------------------------------------------------*/
 std::string ParameterSet::GenerateMessage(const std::string& format, bool allowempty) const
 {
-  std::string msg = format;
-  size_t pos1 = 0, pos2;
-
-  while (((pos1 = msg.find("{", pos1)) < std::string::npos) &&
-         ((pos2 = msg.find("}", pos1)) < std::string::npos))
-  {
-    std::string str1 = msg.substr(0, pos1);                     // text before {
-    std::string str2 = msg.substr(pos2 + 1);                    // text after }
-    std::string arg  = msg.substr(pos1 + 1, pos2 - pos1 - 1);   // text between { and }
-    size_t      pos3 = arg.find(":");                           // key:fmt split
-    size_t      pos4 = arg.find("?");                           // key?a:b split
-    std::string key  = arg.substr(0, std::min(pos3, pos4));     // key
-    std::string val;                                            // string that will end up with printable value in it
-
-    if (allowempty || Exists(key))                              // make sure key exists
-    {
-      if (pos3 < std::string::npos)                             // format string has been specified
-      {
-        if (pos4 < pos3)
-        {
-          // tertiary operator found
-          bool bval;
-
-          // get boolean value
-          if (Get(key, bval))
-          {
-            // choose a or b
-            val = bval ? arg.substr(pos4 + 1, pos3 - pos4 - 1) : arg.substr(pos3 + 1);
-          }
-          else Get(key, val);
-        }
-        else
-        {
-          std::string fmt = arg.substr(pos3 + 1);               // format string
-          std::string str;
-          double  offset = 0.0;
-          double  fval;
-          ulong_t luval;
-          slong_t lsval;
-          uint_t  uval;
-          sint_t  sval;
-
-          // assume this is an offset
-          if ((fmt[0] == '+') || (fmt[0] == '-'))
-          {
-            size_t pos;
-
-            Evaluate(fmt, offset);
-
-            if ((pos = fmt.find(":")) < std::string::npos)
-            {
-              fmt = fmt.substr(pos + 1);                        // find actual format string
-            }
-            else fmt = "";
-          }
-
-          // attempt to extract the value in the correct format for the format string
-          if ((fmt.find("lu") < std::string::npos) || (fmt.find("lx") < std::string::npos))
-          {
-            if (Get(key, luval)) Printf(val, fmt.c_str(), luval + (slong_t)offset);
-          }
-          else if ((fmt.find("u") < std::string::npos) || (fmt.find("x") < std::string::npos))
-          {
-            if (Get(key, uval)) Printf(val, fmt.c_str(), uval + (sint_t)offset);
-          }
-          else if (fmt.find("ld") < std::string::npos)
-          {
-            if (Get(key, lsval)) Printf(val, fmt.c_str(), lsval + (slong_t)offset);
-          }
-          else if (fmt.find("d") < std::string::npos)
-          {
-            if (Get(key, sval)) Printf(val, fmt.c_str(), sval + (sint_t)offset);
-          }
-          else if (fmt.find("f") < std::string::npos)
-          {
-            if (Get(key, fval)) Printf(val, fmt.c_str(), fval + offset);
-          }
-          else if (fmt.find("s") < std::string::npos)
-          {
-            if (Get(key, str)) Printf(val, fmt.c_str(), str.c_str());
-          }
-          else Get(key, val);
-        }
-      }
-      else Get(key, val);
-    }
-    // if key does not exist, leave it as it is (including braces)
-    else val = msg.substr(pos1, pos2 + 1 - pos1);
-
-    // re-construct new string
-    msg  = str1 + val + str2;
-    
-    // generate new starting point for search
-    pos1 = str1.length() + val.length();
-  }
-  
-  return msg;
+  // names that are not in use cannot exist in any parameter set so do not intern them
+  return MessageTemplate(format, false).Generate(*this, allowempty);
 }
 
 /*--------------------------------------------------------------------------------*/
@@ -487,6 +818,265 @@ bool ParameterSet::FindCombination(const std::vector<std::string>& strings, std:
   return found;
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Return iterator to first sub-parameter
+ */
+/*--------------------------------------------------------------------------------*/
+ParameterSetView::Iterator ParameterSetView::GetBegin() const
+{
+  const ParameterTable& table = parameters.GetTable();
+  uint_t root;
+
+  // sub-parameters are the entries below the prefix in the tree
+  if ((prefixkey != ParameterKeys::Invalid) && ((root = table.Find(prefixkey)) != ParameterTable::None))
+  {
+    return Iterator(&table, table.GetFirst(root), root, ParameterKeys::Get().GetName(prefixkey).length() + 1);
+  }
+
+  return GetEnd();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return a string with each parameter and value (as string)
+ */
+/*--------------------------------------------------------------------------------*/
+std::string ParameterSetView::ToString(bool pretty) const
+{
+  Iterator it;
+  std::string str;
+
+  for (it = GetBegin(); it != GetEnd(); ++it)
+  {
+    if (!str.empty()) Printf(str, pretty ? "\n" : ", ");
+    Printf(str, "%s %s", it.GetName().c_str(), it.GetValue().ToString().c_str());
+  }
+
+  return str;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set and parse format
+ *
+ * See ParameterSet::GenerateMessage() for a description of the format
+ */
+/*--------------------------------------------------------------------------------*/
+void MessageTemplate::SetFormat(const std::string& _format, bool intern)
+{
+  ParameterKeys& keys = ParameterKeys::Get();
+  size_t pos = 0, pos1, pos2;
+
+  ReleaseKeys();
+
+  format = _format;
+  segments.clear();
+
+  while (pos < format.length())
+  {
+    SEGMENT segment;
+
+    segment.type       = Segment_Literal;
+    segment.key        = ParameterKeys::Invalid;
+    segment.truestart  = segment.truelength  = 0;
+    segment.falsestart = segment.falselength = 0;
+    segment.offset     = 0.0;
+
+    if (((pos1 = format.find("{", pos)) < std::string::npos) &&
+        ((pos2 = format.find("}", pos1)) < std::string::npos))
+    {
+      // literal text before {
+      if (pos1 > pos)
+      {
+        segment.start  = pos;
+        segment.length = pos1 - pos;
+        segments.push_back(segment);
+      }
+
+      std::string arg  = format.substr(pos1 + 1, pos2 - pos1 - 1);   // text between { and }
+      size_t      pos3 = arg.find(":");                              // key:fmt split
+      size_t      pos4 = arg.find("?");                              // key?a:b split
+
+      segment.type   = Segment_Value;
+      segment.key    = intern ? keys.Intern(arg.substr(0, std::min(pos3, pos4))) : keys.FindRef(arg.substr(0, std::min(pos3, pos4)));
+      segment.start  = pos1;
+      segment.length = pos2 + 1 - pos1;
+
+      if (pos3 < std::string::npos)                                  // format string has been specified
+      {
+        if (pos4 < pos3)
+        {
+          // tertiary operator
+          segment.type        = Segment_Choice;
+          segment.truestart   = pos1 + 1 + pos4 + 1;
+          segment.truelength  = pos3 - pos4 - 1;
+          segment.falsestart  = pos1 + 1 + pos3 + 1;
+          segment.falselength = arg.length() - pos3 - 1;
+        }
+        else
+        {
+          std::string fmt = arg.substr(pos3 + 1);                    // format string
+
+          // assume this is an offset
+          if ((fmt[0] == '+') || (fmt[0] == '-'))
+          {
+            size_t p;
+
+            Evaluate(fmt, segment.offset);
+
+            if ((p = fmt.find(":")) < std::string::npos)
+            {
+              fmt = fmt.substr(p + 1);                               // find actual format string
+            }
+            else fmt = "";
+          }
+
+          // resolve the type of value required by the format string
+          if      ((fmt.find("lu") < std::string::npos) || (fmt.find("lx") < std::string::npos)) segment.type = Segment_ULong;
+          else if ((fmt.find("u")  < std::string::npos) || (fmt.find("x")  < std::string::npos)) segment.type = Segment_UInt;
+          else if (fmt.find("ld") < std::string::npos) segment.type = Segment_SLong;
+          else if (fmt.find("d")  < std::string::npos) segment.type = Segment_SInt;
+          else if (fmt.find("f")  < std::string::npos) segment.type = Segment_Double;
+          else if (fmt.find("s")  < std::string::npos) segment.type = Segment_String;
+
+          if (segment.type != Segment_Value) segment.fmt = fmt;
+        }
+      }
+
+      segments.push_back(segment);
+      pos = pos2 + 1;
+    }
+    else
+    {
+      // remaining text
+      segment.start  = pos;
+      segment.length = format.length() - pos;
+      segments.push_back(segment);
+      pos = format.length();
+    }
+  }
+}
+
+MessageTemplate& MessageTemplate::operator = (const MessageTemplate& obj)
+{
+  if (&obj != this)
+  {
+    ReleaseKeys();
+    format   = obj.format;
+    segments = obj.segments;
+    AddRefs();
+  }
+
+  return *this;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add or release references to placeholder names
+ */
+/*--------------------------------------------------------------------------------*/
+void MessageTemplate::AddRefs()
+{
+  ParameterKeys& keys = ParameterKeys::Get();
+  uint_t i;
+
+  for (i = 0; i < segments.size(); i++)
+  {
+    if (segments[i].key != ParameterKeys::Invalid) keys.AddRef(segments[i].key);
+  }
+}
+
+void MessageTemplate::ReleaseKeys()
+{
+  ParameterKeys& keys = ParameterKeys::Get();
+  uint_t i;
+
+  for (i = 0; i < segments.size(); i++)
+  {
+    if (segments[i].key != ParameterKeys::Invalid) keys.Release(segments[i].key);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Generate message
+ */
+/*--------------------------------------------------------------------------------*/
+void MessageTemplate::Generate(const ParameterSet& parameters, std::string& msg, bool allowempty) const
+{
+  uint_t i;
+
+  msg.clear();
+
+  for (i = 0; i < segments.size(); i++)
+  {
+    const SEGMENT&        segment = segments[i];
+    const ParameterValue *value = NULL;
+
+    if (segment.type == Segment_Literal) AppendText(msg, segment.start, segment.length);
+    // if key does not exist, leave it as it is (including braces) unless allowempty is set
+    else if (((segment.key == ParameterKeys::Invalid) || ((value = parameters.GetValue(segment.key)) == NULL)) && !allowempty) AppendText(msg, segment.start, segment.length);
+    // values that do not exist or cannot be converted generate nothing
+    else if (value)
+    {
+      switch (segment.type)
+      {
+        case Segment_Choice:
+        {
+          bool bval;
+          if (value->Get(bval))
+          {
+            if (bval) AppendText(msg, segment.truestart,  segment.truelength);
+            else      AppendText(msg, segment.falsestart, segment.falselength);
+          }
+          else value->Append(msg);
+          break;
+        }
+
+        case Segment_ULong:
+        {
+          ulong_t val;
+          if (value->Get(val)) AppendFormatted(msg, segment.fmt.c_str(), val + (slong_t)segment.offset);
+          break;
+        }
+
+        case Segment_UInt:
+        {
+          uint_t val;
+          if (value->Get(val)) AppendFormatted(msg, segment.fmt.c_str(), val + (sint_t)segment.offset);
+          break;
+        }
+
+        case Segment_SLong:
+        {
+          slong_t val;
+          if (value->Get(val)) AppendFormatted(msg, segment.fmt.c_str(), val + (slong_t)segment.offset);
+          break;
+        }
+
+        case Segment_SInt:
+        {
+          sint_t val;
+          if (value->Get(val)) AppendFormatted(msg, segment.fmt.c_str(), val + (sint_t)segment.offset);
+          break;
+        }
+
+        case Segment_Double:
+        {
+          double val;
+          if (value->Get(val)) AppendFormatted(msg, segment.fmt.c_str(), val + segment.offset);
+          break;
+        }
+
+        case Segment_String:
+          if (value->GetType() == ParameterValue::Type_String) AppendFormatted(msg, segment.fmt.c_str(), value->GetString().c_str());
+          else AppendFormatted(msg, segment.fmt.c_str(), value->ToString().c_str());
+          break;
+
+        default:
+          value->Append(msg);
+          break;
+      }
+    }
+  }
+}
+
 #if ENABLE_JSON
 /*--------------------------------------------------------------------------------*/
 /** Return object as JSON object
@@ -517,6 +1107,146 @@ void ParameterSet::ToJSON(JSONValue& obj) const
   }
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Write value to streaming JSON writer
+ *
+ * @param str buffer for converting values to strings
+ *
+ * @note as ToJSON(JSONValue&) above, all values are written as strings
+ */
+/*--------------------------------------------------------------------------------*/
+static void WriteJSONValue(JSONWriter& writer, const ParameterValue& value, std::string& str)
+{
+  if (value.GetType() == ParameterValue::Type_String) writer.String(value.GetString());
+  else
+  {
+    str.clear();
+    value.Append(str);
+    writer.String(str);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write value to streaming CBOR writer
+ *
+ * @note values are written natively so that no precision is lost, FromJSON(CBORReader&)
+ * restores them with the same types (except that positive Type_Int values become
+ * Type_UInt, which compare equal)
+ */
+/*--------------------------------------------------------------------------------*/
+static void WriteJSONValue(CBORWriter& writer, const ParameterValue& value, std::string& str)
+{
+  UNUSED_PARAMETER(str);
+
+  switch (value.GetType())
+  {
+    case ParameterValue::Type_String:
+      writer.String(value.GetString());
+      break;
+
+    case ParameterValue::Type_Bool:
+    {
+      bool val = false;
+      value.Get(val);
+      writer.Bool(val);
+      break;
+    }
+
+    case ParameterValue::Type_Int:
+    {
+      sllong_t val = 0;
+      value.Get(val);
+      writer.Int(val);
+      break;
+    }
+
+    case ParameterValue::Type_UInt:
+    {
+      ullong_t val = 0;
+      value.Get(val);
+      writer.UInt(val);
+      break;
+    }
+
+    case ParameterValue::Type_Double:
+    {
+      double val = 0.0;
+      value.Get(val);
+      writer.Double(val);
+      break;
+    }
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write children of table entry parent as members of an object
+ *
+ * @param str buffer for converting values to strings
+ *
+ * @note as ToJSON(JSONValue&) above, an entry with a value hides any entries below it
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename WRITER>
+static void WriteJSONMembers(WRITER& writer, const ParameterTable& table, uint_t parent, std::string& str)
+{
+  const ParameterKeys& keys = ParameterKeys::Get();
+  uint_t index;
+
+  writer.StartObject();
+  for (index = table.GetEntry(parent).firstchild; index != ParameterTable::None; index = table.GetEntry(index).next)
+  {
+    const ParameterTable::ENTRY& entry = table.GetEntry(index);
+
+    // ignore branches without any values
+    if (entry.hasvalue || (table.GetFirst(index) != ParameterTable::None))
+    {
+      const std::string& name = keys.GetName(entry.key);
+      size_t pos = name.rfind('.');
+
+      // write only the last part of the name
+      pos = (pos != std::string::npos) ? pos + 1 : 0;
+      writer.Key(name.c_str() + pos, name.length() - pos);
+
+      if (entry.hasvalue) WriteJSONValue(writer, entry.value, str);
+      else WriteJSONMembers(writer, table, index, str);
+    }
+  }
+  writer.EndObject();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write object to streaming JSON writer
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterSet::ToJSON(JSONWriter& writer) const
+{
+  const ParameterTable& table = GetTable();
+
+  // an empty set leaves a JSONValue null so do the same here
+  if (table.GetCount())
+  {
+    std::string str;
+    WriteJSONMembers(writer, table, ParameterTable::Root, str);
+  }
+  else writer.Null();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Write object to streaming CBOR writer
+ */
+/*--------------------------------------------------------------------------------*/
+void ParameterSet::ToJSON(CBORWriter& writer) const
+{
+  const ParameterTable& table = GetTable();
+
+  if (table.GetCount())
+  {
+    std::string str;
+    WriteJSONMembers(writer, table, ParameterTable::Root, str);
+  }
+  else writer.Null();
+}
+
 /*--------------------------------------------------------------------------------*/
 /** Set object from JSON
  */
@@ -546,6 +1276,9 @@ bool ParameterSet::FromJSON(const JSONValue& obj)
         success = true;
       }
       else if (json::FromJSON(obj2, str))  {Set(name, str); success = true;}
+      else if (obj2.isBool())              {Set(name, obj2.asBool()); success = true;}
+      // reals that are not integral (or too big for 64-bit integers) are stored as doubles
+      else if ((obj2.type() == Json::realValue) && !obj2.isIntegral()) {Set(name, obj2.asDouble()); success = true;}
       else if (json::FromJSON(obj2, uval)) {Set(name, uval); success = true;}
       else if (json::FromJSON(obj2, sval)) {Set(name, sval); success = true;}
       else if (json::FromJSON(obj2, fval)) {Set(name, fval); success = true;}
@@ -556,6 +1289,101 @@ bool ParameterSet::FromJSON(const JSONValue& obj)
   return success;
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Set object from the next value of a streaming JSON reader
+ */
+/*--------------------------------------------------------------------------------*/
+bool ParameterSet::FromJSON(JSONReader& reader)
+{
+  std::string prefix;
+  bool success = false;
+
+  if (reader.Next() == JSONReader::Token_ObjectStart) success = ReadJSONMembers(reader, prefix);
+  else reader.Skip();
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set object from the next value of a streaming CBOR reader
+ */
+/*--------------------------------------------------------------------------------*/
+bool ParameterSet::FromJSON(CBORReader& reader)
+{
+  std::string prefix;
+  bool success = false;
+
+  if (reader.Next() == CBORReader::Token_ObjectStart) success = ReadJSONMembers(reader, prefix);
+  else reader.Skip();
+
+  return success;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Read members of an object whose start has been read, prefixing names with prefix
+ *
+ * Values are converted as FromJSON(const JSONValue&) does, sub-objects become
+ * sub-parameters
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename READER>
+bool ParameterSet::ReadJSONMembers(READER& reader, std::string& prefix)
+{
+  size_t len = prefix.length();
+  bool success = false;
+
+  while (reader.Next() == READER::Token_Key)
+  {
+    ullong_t uval;
+    sllong_t sval;
+
+    prefix += reader.GetKey();
+
+    switch (reader.Next())
+    {
+      case READER::Token_ObjectStart:
+        prefix += ".";
+        success |= ReadJSONMembers(reader, prefix);
+        break;
+
+      case READER::Token_String:
+        Set(prefix, ParameterValue(reader.GetString()));
+        success = true;
+        break;
+
+      case READER::Token_Bool:
+        Set(prefix, reader.GetBool());
+        success = true;
+        break;
+
+      case READER::Token_Null:
+        // as jsoncpp, null converts to 0
+        Set(prefix, (ullong_t)0);
+        success = true;
+        break;
+
+      case READER::Token_Number:
+        if      (reader.GetInteger(uval)) Set(prefix, uval);
+        else if (reader.GetInteger(sval)) Set(prefix, sval);
+        else Set(prefix, reader.GetDouble());
+        success = true;
+        break;
+
+      case READER::Token_ArrayStart:
+        BBCERROR("Unknown type 'array' (member '%s')", prefix.c_str());
+        reader.Skip();
+        break;
+
+      default:
+        break;
+    }
+
+    prefix.resize(len);
+  }
+
+  return (success && (reader.GetToken() == READER::Token_ObjectEnd));
+}
+
 /*--------------------------------------------------------------------------------*/
 /** Take a subset of parameters and store them in a JSON object
  *
@@ -7,12 +7,271 @@
 
 #include "misc.h"
 #include "json.h"
+#include "ParameterKeys.h"
+#include "RefCount.h"
 
 BBC_AUDIOTOOLBOX_START
 
+/*--------------------------------------------------------------------------------*/
+/** Single parameter value, held natively as a bool, integer, double or string
+ *
+ * Values are only formatted as strings when requested and conversions between types
+ * give the same results as formatting with StringFrom() and parsing with Evaluate()
+ */
+/*--------------------------------------------------------------------------------*/
+class ParameterValue
+{
+public:
+  typedef enum
+  {
+    Type_String = 0,
+    Type_Bool,
+    Type_Int,
+    Type_UInt,
+    Type_Double,
+  } TYPE;
+
+  ParameterValue() : type(Type_String) {value.i = 0;}
+  ParameterValue(const std::string& val) : type(Type_String), str(val) {value.i = 0;}
+  ParameterValue(bool val)     : type(Type_Bool)   {value.b = val;}
+  ParameterValue(sllong_t val) : type(Type_Int)    {value.i = val;}
+  ParameterValue(ullong_t val) : type(Type_UInt)   {value.u = val;}
+  ParameterValue(double val)   : type(Type_Double) {value.f = val;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return native type of value
+   */
+  /*--------------------------------------------------------------------------------*/
+  TYPE GetType() const {return type;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Comparison operators (values are compared as strings)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool operator == (const ParameterValue& obj) const;
+  bool operator != (const ParameterValue& obj) const {return !operator == (obj);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value as a string (as StringFrom() would generate)
+   */
+  /*--------------------------------------------------------------------------------*/
+  std::string ToString() const {std::string val; Get(val); return val;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append value as a string (as StringFrom() would generate) to str
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Append(std::string& str) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return string value (empty unless type is Type_String)
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::string& GetString() const {return str;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Get value as specified type
+   *
+   * @return true if value could be converted
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Get(std::string& val) const;
+  bool Get(bool& val) const;
+  bool Get(sint_t& val)   const {return GetInteger(val);}
+  bool Get(uint_t& val)   const {return GetInteger(val);}
+  bool Get(slong_t& val)  const {return GetInteger(val);}
+  bool Get(ulong_t& val)  const {return GetInteger(val);}
+  bool Get(sllong_t& val) const {return GetInteger(val);}
+  bool Get(ullong_t& val) const {return GetInteger(val);}
+  bool Get(double& val) const;
+  bool Get(float& val) const {double dval; bool success = Get(dval); if (success) val = (float)dval; return success;}
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Get value as an integer type
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename T>
+  bool GetInteger(T& val) const
+  {
+    switch (type)
+    {
+      case Type_String: return Evaluate(str, val);
+      case Type_Bool:   val = value.b ? 1 : 0;      break;
+      case Type_Int:    val = (T)value.i;           break;
+      case Type_UInt:   val = (T)value.u;           break;
+      // truncate towards zero as parsing the formatted string would
+      case Type_Double: val = (T)(sllong_t)value.f; break;
+    }
+    return true;
+  }
+
+protected:
+  TYPE type;
+  union
+  {
+    bool     b;
+    sllong_t i;
+    ullong_t u;
+    double   f;
+  } value;
+  std::string str;
+};
+
+/*--------------------------------------------------------------------------------*/
+/** Storage for parameter values indexed by interned name (see ParameterKeys)
+ *
+ * Entries are found using an open-addressed hash of the key and are also linked into
+ * a prefix tree (each name is a child of the name up to its last '.') so that all the
+ * values below a prefix can be visited without scanning the whole table
+ *
+ * Entries for prefixes are created as necessary and may or may not hold values, children
+ * are kept in name order
+ *
+ * Each entry holds a reference to its name in ParameterKeys, entries left without values by
+ * Delete() are discarded once they make up over half of the table
+ *
+ * Tables are reference counted so that they can be shared between ParameterSets
+ */
+/*--------------------------------------------------------------------------------*/
+class ParameterTable : public RefCountedObject
+{
+public:
+  typedef ParameterKeys::KEY KEY;
+
+  // index of the root of the tree (which has no name or value)
+  static const uint_t Root = 0;
+  // no entry
+  static const uint_t None = ~0U;
+
+  ParameterTable();
+  ParameterTable(const ParameterTable& obj);
+  virtual ~ParameterTable();
+
+  typedef struct
+  {
+    KEY            key;
+    uint_t         parent;
+    uint_t         firstchild;
+    uint_t         lastchild;
+    uint_t         next;                // next sibling
+    bool           hasvalue;
+    ParameterValue value;
+  } ENTRY;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of values
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetCount() const {return count;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove all entries
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Clear();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return index of entry for key (which may not have a value) or None
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Find(KEY key) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return value for key or NULL
+   */
+  /*--------------------------------------------------------------------------------*/
+  const ParameterValue *GetValue(KEY key) const {uint_t index = Find(key); return ((index != None) && entries[index].hasvalue) ? &entries[index].value : NULL;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set value for key, creating an entry if necessary
+   *
+   * @param referenced true if the table is to take over the caller's reference to key
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Set(KEY key, const ParameterValue& value, bool referenced = false);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Remove value for key
+   *
+   * @return true if there was a value
+   *
+   * @note this may re-order entries, invalidating any indices
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Delete(KEY key);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return entry by index
+   */
+  /*--------------------------------------------------------------------------------*/
+  const ENTRY& GetEntry(uint_t index) const {return entries[index];}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return index of first/next entry with a value below 'root' (in name order) or None
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetFirst(uint_t root = Root) const {return GetNext(root, root);}
+  uint_t GetNext(uint_t index, uint_t root = Root) const;
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Add entry for key (and its parents)
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Add(KEY key, bool referenced = false);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Rebuild hash table with 2^bits slots
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Rehash(uint_t bits);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Rebuild table from the entries with values
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Compact();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Release references to names of all entries
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ReleaseKeys();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return first slot for key
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetSlot(KEY key) const {return (uint_t)((uint32_t)(key * 2654435769U) >> (32 - hashbits));}
+
+protected:
+  std::vector<ENTRY>  entries;
+  std::vector<uint_t> slots;            // entry index (0 = empty, the root is never hashed)
+  uint_t              hashbits;
+  uint_t              count;
+  uint_t              deleted;          // values deleted since the table was last compacted
+
+private:
+  // tables are copied (see ParameterSet::GetWritableTable()) but never assigned
+  ParameterTable& operator = (const ParameterTable& obj);
+};
+
+class ParameterSetView;
+
 /*--------------------------------------------------------------------------------*/
 /** Collection of parameters, each with name/value pair with type conversion
  *
+ * Values are stored natively (see ParameterValue) so that setting and getting
+ * numeric values does not involve any string formatting or parsing
+ *
+ * Names are interned (see ParameterKeys) and values held in a hash table which is
+ * also a prefix tree (see ParameterTable) so sub-parameters are found without
+ * scanning the whole set
+ *
+ * The table is shared between copies of a set and only copied when a shared
+ * set is modified (copy-on-write) so copying, passing and returning sets by value
+ * is cheap
  */
 /*--------------------------------------------------------------------------------*/
 class ParameterSet : public JSONSerializable
@@ -22,6 +281,7 @@ public:
   ParameterSet(const std::string& values);                      // lines of key=value strings
   ParameterSet(const std::vector<std::string>& values);         // array of key=value strings
   ParameterSet(const ParameterSet& obj);
+  ParameterSet(const ParameterSetView& view);                   // copy of sub-parameters
 #if ENABLE_JSON
   ParameterSet(const JSONValue& obj) {FromJSON(obj);}
 #endif
@@ -64,17 +324,25 @@ public:
   ParameterSet& operator -= (const ParameterSet& obj);
   friend ParameterSet operator - (const ParameterSet& obj1, const ParameterSet& obj2) {ParameterSet res = obj1; res -= obj2; return res;}
 
+  friend class ParameterSetView;
+
   /*--------------------------------------------------------------------------------*/
   /** Return whether parameter set is empty
    */
   /*--------------------------------------------------------------------------------*/
-  bool IsEmpty() const {return values.empty();}
+  bool IsEmpty() const {return (GetTable().GetCount() == 0);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of parameters
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t GetCount() const {return GetTable().GetCount();}
 
   /*--------------------------------------------------------------------------------*/
   /** Clear parameter set
    */
   /*--------------------------------------------------------------------------------*/
-  void Clear() {values.clear();}
+  void Clear() {table = NULL;}
 
   /*--------------------------------------------------------------------------------*/
   /** Return a string with each parameter and value (as string)
@@ -89,28 +357,125 @@ public:
    * @note they return a reference to the object to allow chaining
    */
   /*--------------------------------------------------------------------------------*/
-  ParameterSet& Set(const std::string& name, const std::string&  val);
-  ParameterSet& Set(const std::string& name, const char         *val) {return Set(name, std::string(val));}
+  ParameterSet& Set(const std::string& name, const std::string&    val) {return Set(name, ParameterValue(val));}
+  ParameterSet& Set(const std::string& name, const char           *val) {return Set(name, ParameterValue(std::string(val)));}
+  ParameterSet& Set(const std::string& name, bool                  val) {return Set(name, ParameterValue(val));}
+  ParameterSet& Set(const std::string& name, sint_t                val) {return Set(name, ParameterValue((sllong_t)val));}
+  ParameterSet& Set(const std::string& name, uint_t                val) {return Set(name, ParameterValue((ullong_t)val));}
+  ParameterSet& Set(const std::string& name, slong_t               val) {return Set(name, ParameterValue((sllong_t)val));}
+  ParameterSet& Set(const std::string& name, ulong_t               val) {return Set(name, ParameterValue((ullong_t)val));}
+  ParameterSet& Set(const std::string& name, sllong_t              val) {return Set(name, ParameterValue(val));}
+  ParameterSet& Set(const std::string& name, ullong_t              val) {return Set(name, ParameterValue(val));}
+  ParameterSet& Set(const std::string& name, float                 val) {return Set(name, ParameterValue((double)val));}
+  ParameterSet& Set(const std::string& name, double                val) {return Set(name, ParameterValue(val));}
+  ParameterSet& Set(const std::string& name, const ParameterValue& val);
 
   template<typename T>
-  ParameterSet& Set(const std::string& name, const T&            val) {return Set(name, StringFrom(val));}
+  ParameterSet& Set(const std::string& name, const T&              val) {return Set(name, StringFrom(val));}
 
-  ParameterSet& Set(const std::string& name, const ParameterSet& val);
+  ParameterSet& Set(const std::string& name, const ParameterSet&   val);
 
   /*--------------------------------------------------------------------------------*/
   /** Return whether a parameter exists
    */
   /*--------------------------------------------------------------------------------*/
-  bool Exists(const std::string& name) const {return (values.find(name) != values.end());}
+  bool Exists(const std::string& name) const {return (GetValue(name) != NULL);}
 
   /*--------------------------------------------------------------------------------*/
-  /** Get start and iterators to allow iteration through all values
+  /** Iterator through all values in name order (with sub-parameters following their prefix)
+   *
+   * it->first is the name and it->second the value as a string (as with a std::map<std::string,std::string>)
+   * and it.GetValue() returns the native value
+   *
+   * @note it->first and it->second remain valid until the iterator is changed
    */
   /*--------------------------------------------------------------------------------*/
-  typedef std::map<std::string,std::string>::const_iterator Iterator;
+  class Iterator
+  {
+  public:
+    Iterator() : table(NULL),
+                 index(ParameterTable::None),
+                 root(ParameterTable::Root),
+                 offset(0),
+                 namevalid(false),
+                 valid(false) {}
+    Iterator(const ParameterTable *_table, uint_t _index, uint_t _root = ParameterTable::Root, size_t _offset = 0) : table(_table),
+                                                                                                                       index(_index),
+                                                                                                                       root(_root),
+                                                                                                                       offset(_offset),
+                                                                                                                       namevalid(false),
+                                                                                                                       valid(false) {}
+    Iterator(const Iterator& obj) : table(obj.table),
+                                    index(obj.index),
+                                    root(obj.root),
+                                    offset(obj.offset),
+                                    namevalid(false),
+                                    valid(false) {}
+
+    Iterator& operator = (const Iterator& obj) {table = obj.table; index = obj.index; root = obj.root; offset = obj.offset; namevalid = valid = false; return *this;}
+
+    bool operator == (const Iterator& obj) const {return (index == obj.index);}
+    bool operator != (const Iterator& obj) const {return (index != obj.index);}
+
+    Iterator& operator ++ ()    {index = table->GetNext(index, root); namevalid = valid = false; return *this;}
+    Iterator  operator ++ (int) {Iterator res = *this; ++(*this); return res;}
+
+    typedef struct
+    {
+      std::string first;        // name
+      std::string second;       // value as string
+    } ENTRY;
+
+    const ENTRY& operator * ()  const {return GetEntry();}
+    const ENTRY *operator -> () const {return &GetEntry();}
+
+    // name (relative to the prefix when iterating through a ParameterSetView)
+    const std::string& GetName() const
+    {
+      const std::string& name = ParameterKeys::Get().GetName(table->GetEntry(index).key);
+
+      if (!offset) return name;
+      if (!namevalid)
+      {
+        entry.first.assign(name, offset, std::string::npos);
+        namevalid = true;
+      }
+      return entry.first;
+    }
+    const ParameterValue& GetValue() const {return table->GetEntry(index).value;}
+
+  protected:
+    const ENTRY& GetEntry() const
+    {
+      if (!valid)
+      {
+        if (!offset) entry.first = GetName();
+        else         GetName();
+        entry.second = GetValue().ToString();
+        valid        = true;
+      }
+      return entry;
+    }
+
+  protected:
+    const ParameterTable *table;
+    uint_t                index;
+    uint_t                root;
+    size_t                offset;       // length of prefix to remove from names
+    mutable ENTRY         entry;
+    mutable bool          namevalid;
+    mutable bool          valid;
+  };
     
-  Iterator GetBegin() const {return values.begin();}
-  Iterator GetEnd()   const {return values.end();}
+  Iterator GetBegin() const {return Iterator(&GetTable(), GetTable().GetFirst());}
+  Iterator GetEnd()   const {return Iterator(&GetTable(), ParameterTable::None);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return native value or NULL if the parameter does not exist
+   */
+  /*--------------------------------------------------------------------------------*/
+  const ParameterValue *GetValue(const std::string& name) const;
+  const ParameterValue *GetValue(ParameterKeys::KEY key) const {return GetTable().GetValue(key);}
 
   /*--------------------------------------------------------------------------------*/
   /** Get value
@@ -121,7 +486,16 @@ public:
    * @return true if parameter found and value extracted
    */
   /*--------------------------------------------------------------------------------*/
-  bool Get(const std::string& name, std::string& val) const;
+  bool Get(const std::string& name, std::string& val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, bool&        val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, sint_t&      val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, uint_t&      val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, slong_t&     val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, ulong_t&     val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, sllong_t&    val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, ullong_t&    val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, float&       val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, double&      val) const {return GetNative(name, val);}
 
   template<typename T>
   bool Get(const std::string& name, T& val) const {
@@ -132,6 +506,8 @@ public:
 
   /*--------------------------------------------------------------------------------*/
   /** Delete a parameter
+   *
+   * @note this invalidates any iterators
    */
   /*--------------------------------------------------------------------------------*/
   bool Delete(const std::string& name);
@@ -187,6 +563,9 @@ public:
    *   {name:%-30s}
    *   {id:%016lx}
    *   {objectindex:+1:%u}
+   *
+   * @note this parses format every time, use MessageTemplate for messages that are generated repeatedly
+   * @note placeholder names are not added to ParameterKeys so arbitrary formats do not use up memory
    */
   /*--------------------------------------------------------------------------------*/
   std::string GenerateMessage(const std::string& format, bool allowempty = true) const;
@@ -237,12 +616,42 @@ public:
   /*--------------------------------------------------------------------------------*/
   virtual void ToJSON(JSONValue& obj) const;
 
+  /*--------------------------------------------------------------------------------*/
+  /** Write object to streaming JSON writer
+   *
+   * Values are written directly from storage, with no intermediate JSONValue
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void ToJSON(JSONWriter& writer) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write object to streaming CBOR writer
+   *
+   * Unlike JSON, values are written natively (not as strings)
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void ToJSON(CBORWriter& writer) const;
+
   /*--------------------------------------------------------------------------------*/
   /** Set object from JSON
    */
   /*--------------------------------------------------------------------------------*/
   virtual bool FromJSON(const JSONValue& value);
 
+  /*--------------------------------------------------------------------------------*/
+  /** Set object from the next value of a streaming JSON reader
+   *
+   * Values are stored as they are read, with no intermediate JSONValue
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(JSONReader& reader);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set object from the next value of a streaming CBOR reader
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(CBORReader& reader);
+
   ParameterSet& operator = (const JSONValue& obj) {FromJSON(obj); return *this;}
 
   /*--------------------------------------------------------------------------------*/
@@ -267,7 +676,238 @@ public:
 #endif
 
 protected:
-  std::map<std::string,std::string> values;
+  /*--------------------------------------------------------------------------------*/
+  /** Get value using native conversion
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename T>
+  bool GetNative(const std::string& name, T& val) const {
+    const ParameterValue *value = GetValue(name);
+    return (value && value->Get(val));
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return table for reading
+   */
+  /*--------------------------------------------------------------------------------*/
+  const ParameterTable& GetTable() const {return table ? *table.Obj() : GetEmptyTable();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return table for writing, copying it first if it is shared with other sets
+   */
+  /*--------------------------------------------------------------------------------*/
+  ParameterTable& GetWritableTable();
+
+#if ENABLE_JSON
+  /*--------------------------------------------------------------------------------*/
+  /** Read members of an object whose start has been read from a streaming JSON or CBOR
+   * reader, prefixing names with prefix
+   *
+   * @return true if any values were set
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename READER>
+  bool ReadJSONMembers(READER& reader, std::string& prefix);
+#endif
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return table used by all empty sets
+   */
+  /*--------------------------------------------------------------------------------*/
+  static const ParameterTable& GetEmptyTable();
+
+protected:
+  RefCount<ParameterTable> table;       // NULL when empty
+};
+
+/*--------------------------------------------------------------------------------*/
+/** Read-only view of the sub-parameters of a ParameterSet with a given prefix
+ *
+ * Equivalent to the result of GetSubParameters() but without copying anything: names
+ * are looked up relative to the prefix in the original set
+ *
+ * @note the ParameterSet must not be destroyed whilst the view is in use, changes to
+ * the set are visible through the view
+ */
+/*--------------------------------------------------------------------------------*/
+class ParameterSetView
+{
+public:
+  ParameterSetView(const ParameterSet& _parameters, const std::string& prefix) : parameters(_parameters),
+                                                                                 prefixkey(ParameterKeys::Get().FindRef(prefix)) {}
+  ParameterSetView(const ParameterSetView& view, const std::string& prefix) : parameters(view.parameters),
+                                                                              prefixkey((view.prefixkey != ParameterKeys::Invalid) ? ParameterKeys::Get().FindRef(view.prefixkey, prefix) : ParameterKeys::Invalid) {}
+  ParameterSetView(const ParameterSetView& obj) : parameters(obj.parameters),
+                                                  prefixkey(obj.prefixkey)
+  {
+    if (prefixkey != ParameterKeys::Invalid) ParameterKeys::Get().AddRef(prefixkey);
+  }
+  ~ParameterSetView()
+  {
+    if (prefixkey != ParameterKeys::Invalid) ParameterKeys::Get().Release(prefixkey);
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether there are no sub-parameters
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsEmpty() const {return (GetBegin() == GetEnd());}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether a parameter exists
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Exists(const std::string& name) const {return (GetValue(name) != NULL);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return native value or NULL if the parameter does not exist
+   */
+  /*--------------------------------------------------------------------------------*/
+  const ParameterValue *GetValue(const std::string& name) const {ParameterKeys::KEY key = Find(name); return (key != ParameterKeys::Invalid) ? parameters.GetTable().GetValue(key) : NULL;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Get value (see ParameterSet)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Get(const std::string& name, std::string& val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, bool&        val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, sint_t&      val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, uint_t&      val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, slong_t&     val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, ulong_t&     val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, sllong_t&    val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, ullong_t&    val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, float&       val) const {return GetNative(name, val);}
+  bool Get(const std::string& name, double&      val) const {return GetNative(name, val);}
+
+  template<typename T>
+  bool Get(const std::string& name, T& val) const {
+    std::string str;
+    return (Get(name, str) && Evaluate(str, val));
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Iteration through sub-parameters in name order (names are relative to the prefix)
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef ParameterSet::Iterator Iterator;
+
+  Iterator GetBegin() const;
+  Iterator GetEnd()   const {return Iterator(&parameters.GetTable(), ParameterTable::None);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return a string with each parameter and value (as string)
+   */
+  /*--------------------------------------------------------------------------------*/
+  std::string ToString(bool pretty = false) const;
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Return key of full name of parameter
+   */
+  /*--------------------------------------------------------------------------------*/
+  ParameterKeys::KEY Find(const std::string& name) const {return (prefixkey != ParameterKeys::Invalid) ? ParameterKeys::Get().Find(prefixkey, name) : ParameterKeys::Invalid;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Get value using native conversion
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename T>
+  bool GetNative(const std::string& name, T& val) const {
+    const ParameterValue *value = GetValue(name);
+    return (value && value->Get(val));
+  }
+
+protected:
+  const ParameterSet& parameters;
+  ParameterKeys::KEY  prefixkey;        // Invalid if no parameter had the prefix when the view was created
+};
+
+/*--------------------------------------------------------------------------------*/
+/** Pre-parsed format for ParameterSet::GenerateMessage()
+ *
+ * The format is parsed once into literal text and placeholders (with their keys interned
+ * and format types resolved) so that generating a message only involves looking up
+ * values and appending them to a buffer
+ *
+ * Messages are identical to those generated by ParameterSet::GenerateMessage() (which
+ * describes the format)
+ */
+/*--------------------------------------------------------------------------------*/
+class MessageTemplate
+{
+public:
+  MessageTemplate(const std::string& _format = "", bool intern = true) {SetFormat(_format, intern);}
+  MessageTemplate(const MessageTemplate& obj) : format(obj.format),
+                                                segments(obj.segments) {AddRefs();}
+  ~MessageTemplate() {ReleaseKeys();}
+
+  MessageTemplate& operator = (const MessageTemplate& obj);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set and parse format
+   *
+   * @param intern true to add placeholder names to the global ParameterKeys table so that
+   * the template picks up parameters that do not exist yet, false to only look up existing
+   * names (for one-off messages, to avoid adding names to the table)
+   *
+   * @note the template holds a reference to each placeholder name it finds
+   */
+  /*--------------------------------------------------------------------------------*/
+  void SetFormat(const std::string& _format, bool intern = true);
+  const std::string& GetFormat() const {return format;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Generate message
+   *
+   * @param parameters values to use
+   * @param msg buffer to receive message (cleared first, re-using the buffer avoids allocations)
+   * @param allowempty true to replace non-existent keys with nothing (otherwise non-existing keys are left as is)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void        Generate(const ParameterSet& parameters, std::string& msg, bool allowempty = true) const;
+  std::string Generate(const ParameterSet& parameters, bool allowempty = true) const {std::string msg; Generate(parameters, msg, allowempty); return msg;}
+
+protected:
+  typedef enum
+  {
+    Segment_Literal = 0,                // text
+    Segment_Value,                      // value as string
+    Segment_Choice,                     // one of two strings depending on value as bool
+    Segment_ULong,                      // formatted values
+    Segment_UInt,
+    Segment_SLong,
+    Segment_SInt,
+    Segment_Double,
+    Segment_String,
+  } SEGMENTTYPE;
+
+  typedef struct
+  {
+    SEGMENTTYPE        type;
+    ParameterKeys::KEY key;
+    size_t             start, length;   // text in format (the whole placeholder for placeholders)
+    size_t             truestart, truelength, falsestart, falselength; // choice strings in format
+    std::string        fmt;             // printf format
+    double             offset;
+  } SEGMENT;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Append text from format
+   */
+  /*--------------------------------------------------------------------------------*/
+  void AppendText(std::string& msg, size_t start, size_t length) const {msg.append(format, start, length);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add or release references to placeholder names
+   */
+  /*--------------------------------------------------------------------------------*/
+  void AddRefs();
+  void ReleaseKeys();
+
+protected:
+  std::string          format;
+  std::vector<SEGMENT> segments;
 };
 
 BBC_AUDIOTOOLBOX_END
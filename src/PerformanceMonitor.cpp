@@ -29,6 +29,7 @@
 BBC_AUDIOTOOLBOX_START
 
 PerformanceMonitor::PerformanceMonitor(uint_t _avglen) :
+  tlock("PerformanceMonitor"),
   t0(0),
   avglen(_avglen),
   fp(NULL),
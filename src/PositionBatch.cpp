@@ -0,0 +1,700 @@
+
+#include <math.h>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define BBCDEBUG_LEVEL 1
+#include "PositionBatch.h"
+#include "FastTrig.h"
+
+BBC_AUDIOTOOLBOX_START
+
+// number of positions processed at a time when using fast trig functions
+static const uint_t FastBlockSize = 64;
+
+/*--------------------------------------------------------------------------------*/
+/** Multiply arrays of x, y, z co-ordinates by 3x3 matrix, in place
+ *
+ * Uses AVX, SSE2 or NEON where available; each lane performs exactly the same
+ * operations as the scalar code so the results are identical
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename MATRIX>
+static void MatrixMultiply(const MATRIX& m, double *x, double *y, double *z, uint_t n)
+{
+  uint_t i = 0;
+
+#if defined(__AVX__)
+  {
+    __m256d m00 = _mm256_set1_pd(m[0][0]), m01 = _mm256_set1_pd(m[0][1]), m02 = _mm256_set1_pd(m[0][2]);
+    __m256d m10 = _mm256_set1_pd(m[1][0]), m11 = _mm256_set1_pd(m[1][1]), m12 = _mm256_set1_pd(m[1][2]);
+    __m256d m20 = _mm256_set1_pd(m[2][0]), m21 = _mm256_set1_pd(m[2][1]), m22 = _mm256_set1_pd(m[2][2]);
+
+    for (; (i + 4) <= n; i += 4)
+    {
+      __m256d vx = _mm256_loadu_pd(x + i), vy = _mm256_loadu_pd(y + i), vz = _mm256_loadu_pd(z + i);
+
+      _mm256_storeu_pd(x + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vx, m00), _mm256_mul_pd(vy, m01)), _mm256_mul_pd(vz, m02)));
+      _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vx, m10), _mm256_mul_pd(vy, m11)), _mm256_mul_pd(vz, m12)));
+      _mm256_storeu_pd(z + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(vx, m20), _mm256_mul_pd(vy, m21)), _mm256_mul_pd(vz, m22)));
+    }
+  }
+#elif defined(__SSE2__)
+  {
+    __m128d m00 = _mm_set1_pd(m[0][0]), m01 = _mm_set1_pd(m[0][1]), m02 = _mm_set1_pd(m[0][2]);
+    __m128d m10 = _mm_set1_pd(m[1][0]), m11 = _mm_set1_pd(m[1][1]), m12 = _mm_set1_pd(m[1][2]);
+    __m128d m20 = _mm_set1_pd(m[2][0]), m21 = _mm_set1_pd(m[2][1]), m22 = _mm_set1_pd(m[2][2]);
+
+    for (; (i + 2) <= n; i += 2)
+    {
+      __m128d vx = _mm_loadu_pd(x + i), vy = _mm_loadu_pd(y + i), vz = _mm_loadu_pd(z + i);
+
+      _mm_storeu_pd(x + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(vx, m00), _mm_mul_pd(vy, m01)), _mm_mul_pd(vz, m02)));
+      _mm_storeu_pd(y + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(vx, m10), _mm_mul_pd(vy, m11)), _mm_mul_pd(vz, m12)));
+      _mm_storeu_pd(z + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(vx, m20), _mm_mul_pd(vy, m21)), _mm_mul_pd(vz, m22)));
+    }
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  {
+    float64x2_t m00 = vdupq_n_f64(m[0][0]), m01 = vdupq_n_f64(m[0][1]), m02 = vdupq_n_f64(m[0][2]);
+    float64x2_t m10 = vdupq_n_f64(m[1][0]), m11 = vdupq_n_f64(m[1][1]), m12 = vdupq_n_f64(m[1][2]);
+    float64x2_t m20 = vdupq_n_f64(m[2][0]), m21 = vdupq_n_f64(m[2][1]), m22 = vdupq_n_f64(m[2][2]);
+
+    for (; (i + 2) <= n; i += 2)
+    {
+      float64x2_t vx = vld1q_f64(x + i), vy = vld1q_f64(y + i), vz = vld1q_f64(z + i);
+
+      vst1q_f64(x + i, vaddq_f64(vaddq_f64(vmulq_f64(vx, m00), vmulq_f64(vy, m01)), vmulq_f64(vz, m02)));
+      vst1q_f64(y + i, vaddq_f64(vaddq_f64(vmulq_f64(vx, m10), vmulq_f64(vy, m11)), vmulq_f64(vz, m12)));
+      vst1q_f64(z + i, vaddq_f64(vaddq_f64(vmulq_f64(vx, m20), vmulq_f64(vy, m21)), vmulq_f64(vz, m22)));
+    }
+  }
+#endif
+
+  // remainder (or everything if no SIMD available)
+  for (; i < n; i++)
+  {
+    double vx = x[i], vy = y[i], vz = z[i];
+
+    x[i] = vx * m[0][0] + vy * m[0][1] + vz * m[0][2];
+    y[i] = vx * m[1][0] + vy * m[1][1] + vz * m[1][2];
+    z[i] = vx * m[2][0] + vy * m[2][1] + vz * m[2][2];
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Multiply arrays of x, y, z co-ordinates by 3x4 affine matrix, in place
+ */
+/*--------------------------------------------------------------------------------*/
+static void AffineMultiply(const double m[3][4], double *x, double *y, double *z, uint_t n)
+{
+  double tx = m[0][3], ty = m[1][3], tz = m[2][3];
+  uint_t i;
+
+  MatrixMultiply(m, x, y, z, n);
+
+  // translation pass is trivially vectorised by the compiler
+  for (i = 0; i < n; i++)
+  {
+    x[i] += tx;
+    y[i] += ty;
+    z[i] += tz;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Apply screen transform to arrays of x, y, z co-ordinates, in place
+ *
+ * x' = cx + sx * m * x, y' = cy + sy * m * y where m = dist / (dist - z) (or 1 if z == dist)
+ *
+ * sx * m and sy * m are calculated as (sx * dist) * (1 / (dist - z)) and (sy * dist) * (1 / (dist - z))
+ * so only one division is required per position
+ */
+/*--------------------------------------------------------------------------------*/
+static void ScreenApply(const ScreenTransform& trans, double *x, double *y, const double *z, uint_t n)
+{
+  const double cx = trans.cx, cy = trans.cy, sx = trans.sx, sy = trans.sy, dist = trans.dist;
+  const double sxd = sx * dist, syd = sy * dist;
+  uint_t i = 0;
+
+#if defined(__AVX__)
+  {
+    __m256d vcx = _mm256_set1_pd(cx), vcy = _mm256_set1_pd(cy), vsx = _mm256_set1_pd(sx), vsy = _mm256_set1_pd(sy);
+    __m256d vsxd = _mm256_set1_pd(sxd), vsyd = _mm256_set1_pd(syd), vdist = _mm256_set1_pd(dist), one = _mm256_set1_pd(1.0);
+
+    for (; (i + 4) <= n; i += 4)
+    {
+      __m256d vz   = _mm256_loadu_pd(z + i);
+      __m256d mask = _mm256_cmp_pd(vz, vdist, _CMP_EQ_OQ);
+      // use 1 as denominator for z == dist so that no infinities are generated
+      __m256d r    = _mm256_div_pd(one, _mm256_blendv_pd(_mm256_sub_pd(vdist, vz), one, mask));
+      __m256d fx   = _mm256_blendv_pd(_mm256_mul_pd(vsxd, r), vsx, mask);
+      __m256d fy   = _mm256_blendv_pd(_mm256_mul_pd(vsyd, r), vsy, mask);
+
+      _mm256_storeu_pd(x + i, _mm256_add_pd(vcx, _mm256_mul_pd(fx, _mm256_loadu_pd(x + i))));
+      _mm256_storeu_pd(y + i, _mm256_add_pd(vcy, _mm256_mul_pd(fy, _mm256_loadu_pd(y + i))));
+    }
+  }
+#elif defined(__SSE2__)
+  {
+    __m128d vcx = _mm_set1_pd(cx), vcy = _mm_set1_pd(cy), vsx = _mm_set1_pd(sx), vsy = _mm_set1_pd(sy);
+    __m128d vsxd = _mm_set1_pd(sxd), vsyd = _mm_set1_pd(syd), vdist = _mm_set1_pd(dist), one = _mm_set1_pd(1.0);
+
+    for (; (i + 2) <= n; i += 2)
+    {
+      __m128d vz   = _mm_loadu_pd(z + i);
+      __m128d mask = _mm_cmpeq_pd(vz, vdist);
+      // use 1 as denominator for z == dist so that no infinities are generated
+      __m128d r    = _mm_div_pd(one, _mm_or_pd(_mm_andnot_pd(mask, _mm_sub_pd(vdist, vz)), _mm_and_pd(mask, one)));
+      __m128d fx   = _mm_or_pd(_mm_andnot_pd(mask, _mm_mul_pd(vsxd, r)), _mm_and_pd(mask, vsx));
+      __m128d fy   = _mm_or_pd(_mm_andnot_pd(mask, _mm_mul_pd(vsyd, r)), _mm_and_pd(mask, vsy));
+
+      _mm_storeu_pd(x + i, _mm_add_pd(vcx, _mm_mul_pd(fx, _mm_loadu_pd(x + i))));
+      _mm_storeu_pd(y + i, _mm_add_pd(vcy, _mm_mul_pd(fy, _mm_loadu_pd(y + i))));
+    }
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  {
+    float64x2_t vcx = vdupq_n_f64(cx), vcy = vdupq_n_f64(cy), vsx = vdupq_n_f64(sx), vsy = vdupq_n_f64(sy);
+    float64x2_t vsxd = vdupq_n_f64(sxd), vsyd = vdupq_n_f64(syd), vdist = vdupq_n_f64(dist), one = vdupq_n_f64(1.0);
+
+    for (; (i + 2) <= n; i += 2)
+    {
+      float64x2_t vz   = vld1q_f64(z + i);
+      uint64x2_t  mask = vceqq_f64(vz, vdist);
+      // use 1 as denominator for z == dist so that no infinities are generated
+      float64x2_t r    = vdivq_f64(one, vbslq_f64(mask, one, vsubq_f64(vdist, vz)));
+      float64x2_t fx   = vbslq_f64(mask, vsx, vmulq_f64(vsxd, r));
+      float64x2_t fy   = vbslq_f64(mask, vsy, vmulq_f64(vsyd, r));
+
+      vst1q_f64(x + i, vaddq_f64(vcx, vmulq_f64(fx, vld1q_f64(x + i))));
+      vst1q_f64(y + i, vaddq_f64(vcy, vmulq_f64(fy, vld1q_f64(y + i))));
+    }
+  }
+#endif
+
+  // remainder (or everything if no SIMD available)
+  for (; i < n; i++)
+  {
+    double fx = sx, fy = sy;
+
+    if (z[i] != dist)
+    {
+      double r = 1.0 / (dist - z[i]);
+      fx = sxd * r;
+      fy = syd * r;
+    }
+
+    x[i] = cx + fx * x[i];
+    y[i] = cy + fy * y[i];
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove screen transform from arrays of x, y, z co-ordinates, in place
+ *
+ * x = (x' - cx) / (sx * m) = (x' - cx) * (dist - z) / (sx * dist) (or (x' - cx) / sx if z == dist)
+ *
+ * so no division is required per position
+ */
+/*--------------------------------------------------------------------------------*/
+static void ScreenRemove(const ScreenTransform& trans, double *x, double *y, const double *z, uint_t n)
+{
+  const double cx = trans.cx, cy = trans.cy, dist = trans.dist;
+  const double rsx = 1.0 / trans.sx, rsy = 1.0 / trans.sy;
+  const double rsxd = rsx / dist, rsyd = rsy / dist;
+  uint_t i = 0;
+
+#if defined(__AVX__)
+  {
+    __m256d vcx = _mm256_set1_pd(cx), vcy = _mm256_set1_pd(cy), vrsx = _mm256_set1_pd(rsx), vrsy = _mm256_set1_pd(rsy);
+    __m256d vrsxd = _mm256_set1_pd(rsxd), vrsyd = _mm256_set1_pd(rsyd), vdist = _mm256_set1_pd(dist);
+
+    for (; (i + 4) <= n; i += 4)
+    {
+      __m256d vz   = _mm256_loadu_pd(z + i);
+      __m256d mask = _mm256_cmp_pd(vz, vdist, _CMP_EQ_OQ);
+      __m256d d    = _mm256_sub_pd(vdist, vz);
+      __m256d fx   = _mm256_blendv_pd(_mm256_mul_pd(d, vrsxd), vrsx, mask);
+      __m256d fy   = _mm256_blendv_pd(_mm256_mul_pd(d, vrsyd), vrsy, mask);
+
+      _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(x + i), vcx), fx));
+      _mm256_storeu_pd(y + i, _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(y + i), vcy), fy));
+    }
+  }
+#elif defined(__SSE2__)
+  {
+    __m128d vcx = _mm_set1_pd(cx), vcy = _mm_set1_pd(cy), vrsx = _mm_set1_pd(rsx), vrsy = _mm_set1_pd(rsy);
+    __m128d vrsxd = _mm_set1_pd(rsxd), vrsyd = _mm_set1_pd(rsyd), vdist = _mm_set1_pd(dist);
+
+    for (; (i + 2) <= n; i += 2)
+    {
+      __m128d vz   = _mm_loadu_pd(z + i);
+      __m128d mask = _mm_cmpeq_pd(vz, vdist);
+      __m128d d    = _mm_sub_pd(vdist, vz);
+      __m128d fx   = _mm_or_pd(_mm_andnot_pd(mask, _mm_mul_pd(d, vrsxd)), _mm_and_pd(mask, vrsx));
+      __m128d fy   = _mm_or_pd(_mm_andnot_pd(mask, _mm_mul_pd(d, vrsyd)), _mm_and_pd(mask, vrsy));
+
+      _mm_storeu_pd(x + i, _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(x + i), vcx), fx));
+      _mm_storeu_pd(y + i, _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(y + i), vcy), fy));
+    }
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  {
+    float64x2_t vcx = vdupq_n_f64(cx), vcy = vdupq_n_f64(cy), vrsx = vdupq_n_f64(rsx), vrsy = vdupq_n_f64(rsy);
+    float64x2_t vrsxd = vdupq_n_f64(rsxd), vrsyd = vdupq_n_f64(rsyd), vdist = vdupq_n_f64(dist);
+
+    for (; (i + 2) <= n; i += 2)
+    {
+      float64x2_t vz   = vld1q_f64(z + i);
+      uint64x2_t  mask = vceqq_f64(vz, vdist);
+      float64x2_t d    = vsubq_f64(vdist, vz);
+      float64x2_t fx   = vbslq_f64(mask, vrsx, vmulq_f64(d, vrsxd));
+      float64x2_t fy   = vbslq_f64(mask, vrsy, vmulq_f64(d, vrsyd));
+
+      vst1q_f64(x + i, vmulq_f64(vsubq_f64(vld1q_f64(x + i), vcx), fx));
+      vst1q_f64(y + i, vmulq_f64(vsubq_f64(vld1q_f64(y + i), vcy), fy));
+    }
+  }
+#endif
+
+  // remainder (or everything if no SIMD available)
+  for (; i < n; i++)
+  {
+    double fx = rsx, fy = rsy;
+
+    if (z[i] != dist)
+    {
+      double d = dist - z[i];
+      fx = d * rsxd;
+      fy = d * rsyd;
+    }
+
+    x[i] = (x[i] - cx) * fx;
+    y[i] = (y[i] - cy) * fy;
+  }
+}
+
+PositionBatch::PositionBatch(uint_t n, bool _polar) : polar(_polar)
+{
+  Resize(n);
+}
+
+PositionBatch::PositionBatch(const std::vector<Position>& positions, bool _polar) : polar(_polar)
+{
+  Set(positions);
+}
+
+PositionBatch::PositionBatch(const PositionBatch& obj) : polar(obj.polar)
+{
+  uint_t i;
+
+  for (i = 0; i < NUMBEROF(coords); i++) coords[i] = obj.coords[i];
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Assignment operator
+ */
+/*--------------------------------------------------------------------------------*/
+PositionBatch& PositionBatch::operator = (const PositionBatch& obj)
+{
+  uint_t i;
+
+  polar = obj.polar;
+  for (i = 0; i < NUMBEROF(coords); i++) coords[i] = obj.coords[i];
+
+  return *this;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set number of positions in batch (new positions are set to the origin)
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionBatch::Resize(uint_t n)
+{
+  uint_t i;
+
+  for (i = 0; i < NUMBEROF(coords); i++) coords[i].resize(n, 0.0);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set position at index (converted to the co-ordinate system of the batch)
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionBatch::Set(uint_t i, const Position& pos)
+{
+  if (i < Size())
+  {
+    Position pos1 = polar ? pos.Polar() : pos.Cart();
+    uint_t j;
+
+    for (j = 0; j < NUMBEROF(coords); j++) coords[j][i] = pos1.pos.elements[j];
+  }
+  else BBCERROR("Position index %u out of range (%u positions)", i, Size());
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set all positions from a list (batch size is set to the size of the list)
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionBatch::Set(const std::vector<Position>& positions)
+{
+  uint_t i;
+
+  Resize((uint_t)positions.size());
+  for (i = 0; i < positions.size(); i++) Set(i, positions[i]);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return position at index
+ */
+/*--------------------------------------------------------------------------------*/
+Position PositionBatch::Get(uint_t i) const
+{
+  Position pos;
+
+  if (i < Size())
+  {
+    uint_t j;
+
+    pos.polar = polar;
+    for (j = 0; j < NUMBEROF(coords); j++) pos.pos.elements[j] = coords[j][i];
+  }
+  else BBCERROR("Position index %u out of range (%u positions)", i, Size());
+
+  return pos;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Get all positions as a list
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionBatch::Get(std::vector<Position>& positions) const
+{
+  uint_t i;
+
+  positions.resize(Size());
+  for (i = 0; i < positions.size(); i++) positions[i] = Get(i);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Convert all positions to cartesian co-ordinates
+ *
+ * @param fast true to use approximate trig functions (see FastTrig.h)
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionBatch::ToCart(bool fast)
+{
+  if (polar)
+  {
+    double *a = GetArray(0), *b = GetArray(1), *c = GetArray(2);
+    uint_t i, n = Size();
+
+    // x = -sin(az) * cos(el) * d
+    // y =  cos(az) * cos(el) * d
+    // z =  sin(el) * d
+    if (fast)
+    {
+      // process in blocks using the batch trig functions
+      double angles[FastBlockSize], sinaz[FastBlockSize], cosaz[FastBlockSize], sinel[FastBlockSize], cosel[FastBlockSize];
+      uint_t j, m;
+
+      for (i = 0; i < n; i += m)
+      {
+        m = std::min(n - i, (uint_t)FastBlockSize);
+
+        for (j = 0; j < m; j++) angles[j] = a[i + j] * M_PI / 180.0;
+        FastSinCos(angles, sinaz, cosaz, m);
+        for (j = 0; j < m; j++) angles[j] = b[i + j] * M_PI / 180.0;
+        FastSinCos(angles, sinel, cosel, m);
+
+        for (j = 0; j < m; j++)
+        {
+          double d = c[i + j];
+
+          a[i + j] = d * -sinaz[j] * cosel[j];
+          b[i + j] = d *  cosaz[j] * cosel[j];
+          c[i + j] = d *  sinel[j];
+        }
+      }
+    }
+    else
+    {
+      for (i = 0; i < n; i++)
+      {
+        double az = a[i] * M_PI / 180.0, el = b[i] * M_PI / 180.0, d = c[i];
+        double cosel = cos(el);
+
+        a[i] = d * -sin(az) * cosel;
+        b[i] = d *  cos(az) * cosel;
+        c[i] = d *  sin(el);
+      }
+    }
+
+    polar = false;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Convert all positions to polar co-ordinates
+ *
+ * @param fast true to use approximate trig functions (see FastTrig.h)
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionBatch::ToPolar(bool fast)
+{
+  if (!polar)
+  {
+    double *a = GetArray(0), *b = GetArray(1), *c = GetArray(2);
+    uint_t i, n = Size();
+
+    if (fast)
+    {
+      // process in blocks using the batch trig functions
+      double nx[FastBlockSize], ny[FastBlockSize], nz[FastBlockSize], az[FastBlockSize], el[FastBlockSize];
+      uint_t j, m;
+
+      for (i = 0; i < n; i += m)
+      {
+        m = std::min(n - i, (uint_t)FastBlockSize);
+
+        for (j = 0; j < m; j++)
+        {
+          double x = a[i + j], y = b[i + j], z = c[i + j];
+          double d = sqrt(x * x + y * y + z * z);
+          double s = (d > 0.0) ? 1.0 / d : 0.0;
+
+          nx[j]    = -x * s;
+          ny[j]    =  y * s;
+          nz[j]    = limited::limit(z * s, -1.0, 1.0);
+          c[i + j] = d;
+        }
+
+        // FastAtan2(0, 0) == 0 and FastAsin(0) == 0 so no special cases are required
+        FastAtan2(nx, ny, az, m);
+        FastAsin(nz, el, m);
+
+        for (j = 0; j < m; j++)
+        {
+          a[i + j] = az[j] * 180.0 / M_PI;
+          b[i + j] = el[j] * 180.0 / M_PI;
+        }
+      }
+    }
+    else
+    {
+      for (i = 0; i < n; i++)
+      {
+        double x = a[i], y = b[i], z = c[i];
+        double d = sqrt(x * x + y * y + z * z);
+        double az = 0.0, el = 0.0;
+
+        if (d > 0.0)
+        {
+          x /= d; y /= d; z /= d;
+
+          // el = asin(z), az = atan2(-x, y) (see Position::Polar())
+          el = asin(z) * 180.0 / M_PI;
+          if ((x != 0.0) || (y != 0.0)) az = atan2(-x, y) * 180.0 / M_PI;
+        }
+
+        a[i] = az;
+        b[i] = el;
+        c[i] = d;
+      }
+    }
+
+    polar = true;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Scale all positions to unit length (positions at the origin are unchanged)
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionBatch::Normalise()
+{
+  uint_t i, n = Size();
+
+  if (polar)
+  {
+    double *d = GetArray(2);
+
+    for (i = 0; i < n; i++) d[i] = (d[i] > 0.0) ? 1.0 : d[i];
+  }
+  else
+  {
+    double *x = GetArray(0), *y = GetArray(1), *z = GetArray(2);
+
+    for (i = 0; i < n; i++)
+    {
+      double d = sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+      double m = (d > 0.0) ? 1.0 / d : 1.0;
+
+      x[i] *= m;
+      y[i] *= m;
+      z[i] *= m;
+    }
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Calculate distance of each position from the origin
+ *
+ * @param dist array of Size() entries to receive distances
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionBatch::GetDistances(double *dist) const
+{
+  uint_t i, n = Size();
+
+  if (polar)
+  {
+    const double *d = GetArray(2);
+
+    for (i = 0; i < n; i++) dist[i] = d[i];
+  }
+  else
+  {
+    const double *x = GetArray(0), *y = GetArray(1), *z = GetArray(2);
+
+    for (i = 0; i < n; i++) dist[i] = sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Calculate distance of each position from the specified position
+ *
+ * @param dist array of Size() entries to receive distances
+ */
+/*--------------------------------------------------------------------------------*/
+void PositionBatch::GetDistances(const Position& pos, double *dist) const
+{
+  if (polar)
+  {
+    // distance must be calculated in cartesian space
+    PositionBatch cart = *this;
+    cart.ToCart();
+    cart.GetDistances(pos, dist);
+  }
+  else
+  {
+    const double *x = GetArray(0), *y = GetArray(1), *z = GetArray(2);
+    Position pos1 = pos.Cart();
+    double   px = pos1.pos.x, py = pos1.pos.y, pz = pos1.pos.z;
+    uint_t   i, n = Size();
+
+    for (i = 0; i < n; i++)
+    {
+      double dx = x[i] - px, dy = y[i] - py, dz = z[i] - pz;
+
+      dist[i] = sqrt(dx * dx + dy * dy + dz * dz);
+    }
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Apply 3x3 matrix to all positions (see Position::operator *= (const double vals[3][3]))
+ *
+ * @note polar batches are converted to cartesian, transformed and converted back
+ */
+/*--------------------------------------------------------------------------------*/
+PositionBatch& PositionBatch::operator *= (const double vals[3][3])
+{
+  bool waspolar = polar;
+
+  ToCart();
+  MatrixMultiply(vals, GetArray(0), GetArray(1), GetArray(2), Size());
+  if (waspolar) ToPolar();
+
+  return *this;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Rotate all positions by Quaternion
+ */
+/*--------------------------------------------------------------------------------*/
+PositionBatch& PositionBatch::operator *= (const Quaternion& rotation)
+{
+  double matrix[3][3];
+
+  rotation.ToRotationMatrix(matrix);
+
+  return operator *= (matrix);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Reverse rotate all positions by Quaternion
+ */
+/*--------------------------------------------------------------------------------*/
+PositionBatch& PositionBatch::operator /= (const Quaternion& rotation)
+{
+  double matrix[3][3];
+
+  rotation.ToInverseRotationMatrix(matrix);
+
+  return operator *= (matrix);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Apply 3x4 affine matrix to all positions (pos' = vals[0..2][0..2] * pos + vals[0..2][3])
+ */
+/*--------------------------------------------------------------------------------*/
+PositionBatch& PositionBatch::operator *= (const double vals[3][4])
+{
+  bool waspolar = polar;
+
+  ToCart();
+  AffineMultiply(vals, GetArray(0), GetArray(1), GetArray(2), Size());
+  if (waspolar) ToPolar();
+
+  return *this;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Apply/remove position transform
+ */
+/*--------------------------------------------------------------------------------*/
+PositionBatch& PositionBatch::operator *= (const PositionTransform& trans)
+{
+  trans.ApplyTransform(*this);
+  return *this;
+}
+
+PositionBatch& PositionBatch::operator /= (const PositionTransform& trans)
+{
+  trans.RemoveTransform(*this);
+  return *this;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Apply/remove screen transform
+ */
+/*--------------------------------------------------------------------------------*/
+PositionBatch& PositionBatch::operator *= (const ScreenTransform& trans)
+{
+  bool waspolar = polar;
+
+  ToCart();
+  ScreenApply(trans, GetArray(0), GetArray(1), GetArray(2), Size());
+  if (waspolar) ToPolar();
+
+  return *this;
+}
+
+PositionBatch& PositionBatch::operator /= (const ScreenTransform& trans)
+{
+  bool waspolar = polar;
+
+  ToCart();
+  ScreenRemove(trans, GetArray(0), GetArray(1), GetArray(2), Size());
+  if (waspolar) ToPolar();
+
+  return *this;
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,177 @@
+#ifndef __POSITION_BATCH__
+#define __POSITION_BATCH__
+
+#include <vector>
+
+#include "3DPosition.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Structure-of-arrays collection of positions for bulk processing
+ *
+ * All positions in a batch are either polar or cartesian and each co-ordinate is
+ * held in its own contiguous array (az/el/d or x/y/z) so that bulk operations can
+ * be vectorised by the compiler
+ *
+ * The results of conversions are identical to those of Position::Polar() and
+ * Position::Cart()
+ */
+/*--------------------------------------------------------------------------------*/
+class PositionBatch
+{
+public:
+  PositionBatch(uint_t n = 0, bool _polar = false);
+  PositionBatch(const std::vector<Position>& positions, bool _polar = false);
+  PositionBatch(const PositionBatch& obj);
+  ~PositionBatch() {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Assignment operator
+   */
+  /*--------------------------------------------------------------------------------*/
+  PositionBatch& operator = (const PositionBatch& obj);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set number of positions in batch (new positions are set to the origin)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Resize(uint_t n);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return number of positions in batch
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t Size() const {return (uint_t)coords[0].size();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether positions are polar
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IsPolar() const {return polar;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set position at index (converted to the co-ordinate system of the batch)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Set(uint_t i, const Position& pos);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set all positions from a list (batch size is set to the size of the list)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Set(const std::vector<Position>& positions);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return position at index
+   */
+  /*--------------------------------------------------------------------------------*/
+  Position Get(uint_t i) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Get all positions as a list
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Get(std::vector<Position>& positions) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return array of co-ordinates
+   *
+   * @param index 0 = az or x, 1 = el or y, 2 = d or z (as in Position::pos.elements[])
+   */
+  /*--------------------------------------------------------------------------------*/
+  double       *GetArray(uint_t index)       {return coords[index].empty() ? NULL : &coords[index][0];}
+  const double *GetArray(uint_t index) const {return coords[index].empty() ? NULL : &coords[index][0];}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Convert all positions to cartesian co-ordinates
+   *
+   * @param fast true to use approximate trig functions (see FastTrig.h)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ToCart(bool fast = false);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Convert all positions to polar co-ordinates
+   *
+   * @param fast true to use approximate trig functions (see FastTrig.h)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void ToPolar(bool fast = false);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Scale all positions to unit length (positions at the origin are unchanged)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Normalise();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Calculate distance of each position from the origin
+   *
+   * @param dist array of Size() entries to receive distances
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetDistances(double *dist) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Calculate distance of each position from the specified position
+   *
+   * @param dist array of Size() entries to receive distances
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetDistances(const Position& pos, double *dist) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply 3x3 matrix to all positions (see Position::operator *= (const double vals[3][3]))
+   *
+   * @note polar batches are converted to cartesian, transformed and converted back
+   */
+  /*--------------------------------------------------------------------------------*/
+  PositionBatch& operator *= (const double vals[3][3]);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Rotate all positions by Quaternion
+   *
+   * @note the Quaternion is converted to a rotation matrix once for the whole batch
+   */
+  /*--------------------------------------------------------------------------------*/
+  PositionBatch& operator *= (const Quaternion& rotation);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Reverse rotate all positions by Quaternion
+   */
+  /*--------------------------------------------------------------------------------*/
+  PositionBatch& operator /= (const Quaternion& rotation);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply 3x4 affine matrix to all positions (pos' = vals[0..2][0..2] * pos + vals[0..2][3])
+   */
+  /*--------------------------------------------------------------------------------*/
+  PositionBatch& operator *= (const double vals[3][4]);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply/remove position transform
+   */
+  /*--------------------------------------------------------------------------------*/
+  PositionBatch& operator *= (const PositionTransform& trans);
+  PositionBatch& operator /= (const PositionTransform& trans);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Apply/remove screen transform
+   *
+   * @note the perspective scale is calculated with one reciprocal per position (shared by x and y)
+   * for applying and without any division for removing, positions with z == dist are unscaled as
+   * in ScreenTransform::GetDistanceScale()
+   */
+  /*--------------------------------------------------------------------------------*/
+  PositionBatch& operator *= (const ScreenTransform& trans);
+  PositionBatch& operator /= (const ScreenTransform& trans);
+
+protected:
+  bool                polar;
+  std::vector<double> coords[3];
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
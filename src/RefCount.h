@@ -1,10 +1,14 @@
 #ifndef __REF_COUNT__
 #define __REF_COUNT__
 
+#include <atomic>
+
 #include "misc.h"
 
 BBC_AUDIOTOOLBOX_START
 
+template<typename T> class WeakRefCount;
+
 /*--------------------------------------------------------------------------------*/
 /** Simple reference count management template
  *
@@ -20,6 +24,8 @@ BBC_AUDIOTOOLBOX_START
  * For example, EnhancedFile has IncRef() and DecRef() member functions so:
  *
  * RefCount<> fileref(file = new EnhancedFile(...));
+ *
+ * Moving a RefCount transfers ownership without touching the object's reference count
  * 
  */
 /*--------------------------------------------------------------------------------*/
@@ -34,6 +40,11 @@ public:
   RefCount(T *_obj = NULL) : obj(NULL) {Attach(_obj);}
   RefCount(const RefCount& ref) : obj(NULL) {Attach(ref.Obj());}
   /*--------------------------------------------------------------------------------*/
+  /** Move constructor - takes ownership without changing the reference count
+   */
+  /*--------------------------------------------------------------------------------*/
+  RefCount(RefCount&& ref) : obj(ref.obj) {ref.obj = NULL;}
+  /*--------------------------------------------------------------------------------*/
   /** Destructor
    */
   /*--------------------------------------------------------------------------------*/
@@ -45,6 +56,21 @@ public:
   /*--------------------------------------------------------------------------------*/
   RefCount& operator = (const RefCount& ref) {Attach(ref.Obj()); return *this;}
 
+  /*--------------------------------------------------------------------------------*/
+  /** Move the target object - takes ownership without changing the reference count
+   */
+  /*--------------------------------------------------------------------------------*/
+  RefCount& operator = (RefCount&& ref)
+  {
+    if (&ref != this)
+    {
+      Release();
+      obj     = ref.obj;
+      ref.obj = NULL;
+    }
+    return *this;
+  }
+
   /*--------------------------------------------------------------------------------*/
   /** Set the target object
    */
@@ -60,6 +86,14 @@ public:
   T *Obj() const {return obj;}
 
 protected:
+  friend class WeakRefCount<T>;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Take ownership of an object whose reference count has *already* been incremented
+   */
+  /*--------------------------------------------------------------------------------*/
+  static RefCount Adopt(T *_obj) {RefCount res; res.obj = _obj; return res;}
+
   /*--------------------------------------------------------------------------------*/
   /** Set the target object for this object and increment its refcount
    */
@@ -92,19 +126,41 @@ protected:
 
 /*--------------------------------------------------------------------------------*/
 /** Base class (optional) for ref-counting objects
+ *
+ * The reference count is atomic so objects can be shared between threads (as long
+ * as each thread uses its own RefCount object)
+ *
+ * Weak references (see WeakRefCount below) are supported via a small control block
+ * which is only allocated when the first weak reference is created
+ *
+ * @note a weak reference can only be locked whilst the object has at least one strong
+ * reference, even if deletion is prevented, because the control block is only detached
+ * once the derived destructors have run
  */
 /*--------------------------------------------------------------------------------*/
 class RefCountedObject
 {
 public:
   RefCountedObject(bool _preventdeletion = false) : refcount(0),
-                                                    preventdeletion(_preventdeletion) {}
-  virtual ~RefCountedObject() {}
+                                                    preventdeletion(_preventdeletion),
+                                                    weakcontrol(NULL) {}
+  /*--------------------------------------------------------------------------------*/
+  /** Copying an object does NOT copy its references or weak references
+   */
+  /*--------------------------------------------------------------------------------*/
+  RefCountedObject(const RefCountedObject& obj) : refcount(0),
+                                                  preventdeletion(obj.preventdeletion.load()),
+                                                  weakcontrol(NULL) {}
+  virtual ~RefCountedObject()
+  {
+    WeakControl *control;
+    if ((control = weakcontrol.load(std::memory_order_acquire)) != NULL) control->Detach();
+  }
+
+  RefCountedObject& operator = (const RefCountedObject& obj) {UNUSED_PARAMETER(obj); return *this;}
 
   /*--------------------------------------------------------------------------------*/
   /** Prevent deletion of this object
-   *
-   * @note NOT thread safe!
    */
   /*--------------------------------------------------------------------------------*/
   virtual void PreventDeletion(bool prevent = true) {preventdeletion = prevent;}
@@ -112,18 +168,18 @@ public:
   /*--------------------------------------------------------------------------------*/
   /** Increment reference count for this object
    *
-   * @note NOT thread safe!
+   * @note a new reference can only be created from an existing one so no ordering is required
    */
   /*--------------------------------------------------------------------------------*/
-  virtual void IncRef() {refcount++;}
+  virtual void IncRef() {refcount.fetch_add(1, std::memory_order_relaxed);}
 
   /*--------------------------------------------------------------------------------*/
   /** Decrement reference count for this object and return whether the result is zero (i.e. the object can be deleted)
    *
-   * @note NOT thread safe!
+   * @note acquire-release ordering ensures all writes by other owners are visible before deletion
    */
   /*--------------------------------------------------------------------------------*/
-  virtual bool DecRef() {return (((--refcount) == 0) && !preventdeletion);}
+  virtual bool DecRef() {return ((refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) && !preventdeletion);}
 
   /*--------------------------------------------------------------------------------*/
   /** Return whether this object is shared by more than one owner
@@ -131,11 +187,198 @@ public:
    * @note this can be used for copy-on-write behaviour
    */
   /*--------------------------------------------------------------------------------*/
-  bool IsShared() const {return (refcount > 1);}
+  bool IsShared() const {return (refcount.load(std::memory_order_acquire) > 1);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Weak reference control block, shared between an object and its weak references
+   *
+   * @note not to be used directly, use WeakRefCount<> instead
+   */
+  /*--------------------------------------------------------------------------------*/
+  class WeakControl
+  {
+  public:
+    WeakControl(RefCountedObject *_obj) : refcount(1),      // reference held by object itself
+                                          obj(_obj) {spin.clear();}
+
+    /*--------------------------------------------------------------------------------*/
+    /** Increment/decrement number of references to this control block
+     */
+    /*--------------------------------------------------------------------------------*/
+    void IncRef() {refcount.fetch_add(1, std::memory_order_relaxed);}
+    void DecRef() {if (refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;}
+
+    /*--------------------------------------------------------------------------------*/
+    /** Return object with its reference count incremented or NULL if it has been (or is being) deleted
+     */
+    /*--------------------------------------------------------------------------------*/
+    RefCountedObject *Lock()
+    {
+      RefCountedObject *res = NULL;
+
+      Acquire();
+      // object cannot finish destruction whilst spin lock is held
+      if (obj && obj->IncRefIfAlive()) res = obj;
+      Release();
+
+      return res;
+    }
+
+    /*--------------------------------------------------------------------------------*/
+    /** Return whether object has gone
+     */
+    /*--------------------------------------------------------------------------------*/
+    bool Expired()
+    {
+      bool expired;
+      Acquire();
+      expired = (!obj || (obj->refcount.load(std::memory_order_acquire) == 0));
+      Release();
+      return expired;
+    }
+
+  protected:
+    friend class RefCountedObject;
+
+    /*--------------------------------------------------------------------------------*/
+    /** Called by object when it is destroyed
+     */
+    /*--------------------------------------------------------------------------------*/
+    void Detach()
+    {
+      Acquire();
+      obj = NULL;
+      Release();
+      DecRef();
+    }
+
+    void Acquire() {while (spin.test_and_set(std::memory_order_acquire)) ;}
+    void Release() {spin.clear(std::memory_order_release);}
+
+  protected:
+    std::atomic<uint_t> refcount;
+    std::atomic_flag    spin;
+    RefCountedObject    *obj;
+  };
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return weak reference control block, creating it if necessary
+   *
+   * @note the returned control block has had its reference count incremented
+   */
+  /*--------------------------------------------------------------------------------*/
+  WeakControl *GetWeakControl()
+  {
+    WeakControl *control = weakcontrol.load(std::memory_order_acquire);
+
+    if (!control)
+    {
+      WeakControl *newcontrol = new WeakControl(this);
+
+      // another thread may have beaten us to it
+      if (weakcontrol.compare_exchange_strong(control, newcontrol, std::memory_order_acq_rel)) control = newcontrol;
+      else delete newcontrol;
+    }
+
+    control->IncRef();
+    return control;
+  }
+
+protected:
+  /*--------------------------------------------------------------------------------*/
+  /** Increment reference count *unless* it is zero
+   *
+   * @note objects with deletion prevented are included: at zero such an object may be
+   * being destroyed (e.g. a member or stack object) and cannot be detected otherwise
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool IncRefIfAlive()
+  {
+    uint_t count = refcount.load(std::memory_order_relaxed);
+
+    do
+    {
+      if (!count) return false;
+    }
+    while (!refcount.compare_exchange_weak(count, count + 1, std::memory_order_relaxed));
+
+    return true;
+  }
+
+protected:
+  std::atomic<uint_t>        refcount;
+  std::atomic<bool>          preventdeletion;
+  std::atomic<WeakControl *> weakcontrol;
+};
+
+/*--------------------------------------------------------------------------------*/
+/** Weak reference to an object derived from RefCountedObject
+ *
+ * A weak reference does not keep the object alive; use Lock() to obtain a (strong)
+ * RefCount which is empty if the object has been deleted:
+ *
+ * WeakRefCount<EnhancedFile> weak(file);
+ * ...
+ * RefCount<EnhancedFile> ref = weak.Lock();
+ * if (ref) ...
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename T>
+class WeakRefCount
+{
+public:
+  WeakRefCount(T *_obj = NULL) : control(NULL) {Attach(_obj);}
+  WeakRefCount(const RefCount<T>& ref) : control(NULL) {Attach(ref.Obj());}
+  WeakRefCount(const WeakRefCount& ref) : control(ref.control) {if (control) control->IncRef();}
+  WeakRefCount(WeakRefCount&& ref) : control(ref.control) {ref.control = NULL;}
+  ~WeakRefCount() {Release();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Assignment
+   */
+  /*--------------------------------------------------------------------------------*/
+  WeakRefCount& operator = (const WeakRefCount& ref)
+  {
+    if (ref.control) ref.control->IncRef();
+    Release();
+    control = ref.control;
+    return *this;
+  }
+  WeakRefCount& operator = (WeakRefCount&& ref)
+  {
+    if (&ref != this)
+    {
+      Release();
+      control     = ref.control;
+      ref.control = NULL;
+    }
+    return *this;
+  }
+  WeakRefCount& operator = (T *_obj)               {Release(); Attach(_obj);      return *this;}
+  WeakRefCount& operator = (const RefCount<T>& ref) {Release(); Attach(ref.Obj()); return *this;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return strong reference to object (empty if the object has been deleted)
+   */
+  /*--------------------------------------------------------------------------------*/
+  RefCount<T> Lock() const
+  {
+    RefCountedObject *obj = control ? control->Lock() : NULL;
+    return RefCount<T>::Adopt(static_cast<T *>(obj));
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return whether object has been deleted (or never set)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Expired() const {return (!control || control->Expired());}
+
+protected:
+  void Attach(T *_obj) {control = _obj ? _obj->GetWeakControl() : NULL;}
+  void Release() {if (control) control->DecRef(); control = NULL;}
 
 protected:
-  uint_t refcount;
-  bool   preventdeletion;
+  RefCountedObject::WeakControl *control;
 };
 
 BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,103 @@
+#ifndef __SEQUENCE_LOCK__
+#define __SEQUENCE_LOCK__
+
+#include <atomic>
+
+#include "misc.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Sequence lock for lock-free reading of a set of values that are written rarely
+ *
+ * The protected values MUST be std::atomic<> and be accessed with std::memory_order_relaxed
+ * between the calls below
+ *
+ * To write:
+ *   lock.WriteStart();                  // or if (lock.TryWriteStart(seq)) to give up if another writer is active
+ *   <store values>
+ *   lock.WriteEnd();
+ *
+ * To read:
+ *   uint_t seq;
+ *   do
+ *   {
+ *     seq = lock.ReadStart();
+ *     <load values>
+ *   }
+ *   while (lock.ReadRetry(seq));
+ *
+ * Notes:
+ *  1. the sequence number is odd whilst an update is in progress
+ *  2. readers never block writers, writers block each other
+ */
+/*--------------------------------------------------------------------------------*/
+class SequenceLock
+{
+public:
+  SequenceLock() : sequence(0) {}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start update of values, waiting for any other writer to finish
+   */
+  /*--------------------------------------------------------------------------------*/
+  void WriteStart()
+  {
+    uint_t seq = sequence.load(std::memory_order_relaxed);
+
+    while ((seq & 1) || !sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire))
+    {
+      seq = sequence.load(std::memory_order_relaxed);
+    }
+
+    // ensure the odd sequence number is visible before any of the values change
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start update of values only if no update has happened since ReadStart() returned seq
+   *
+   * @return true if update started (WriteEnd() MUST then be called)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool TryWriteStart(uint_t seq)
+  {
+    if ((seq & 1) || !sequence.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) return false;
+
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** End update of values
+   */
+  /*--------------------------------------------------------------------------------*/
+  void WriteEnd() {sequence.fetch_add(1, std::memory_order_release);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Start reading values
+   *
+   * @return sequence number to pass to ReadRetry()
+   */
+  /*--------------------------------------------------------------------------------*/
+  uint_t ReadStart() const {return sequence.load(std::memory_order_acquire);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** End reading values
+   *
+   * @return true if values read since ReadStart() may be inconsistent and must be read again
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool ReadRetry(uint_t seq) const
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return ((seq & 1) || (sequence.load(std::memory_order_relaxed) != seq));
+  }
+
+protected:
+  std::atomic<uint_t> sequence;
+};
+
+BBC_AUDIOTOOLBOX_END
+
+#endif
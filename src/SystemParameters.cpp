@@ -13,7 +13,7 @@ const std::string SystemParameters::installdirkey = "installdir";
 const std::string SystemParameters::sharedirkey   = "sharedir";
 const std::string SystemParameters::homedirkey    = "homedir";
 
-SystemParameters::SystemParameters()
+SystemParameters::SystemParameters() : tlock("SystemParameters")
 {
   ThreadLock lock(tlock);
   static bool init = false;
@@ -3,16 +3,66 @@
 
 #include <errno.h>
 
+#include <map>
+#include <algorithm>
+
 #define BBCDEBUG_LEVEL 1
 #include "misc.h"
 #include "ThreadLock.h"
 
 BBC_AUDIOTOOLBOX_START
 
-ThreadLockObject::ThreadLockObject()
-#ifndef USE_PTHREADS
-  : lock(mutex, std::defer_lock)
-#endif
+// global enable for instrumentation of named locks
+static std::atomic<bool> instrumentationenabled(false);
+
+/*--------------------------------------------------------------------------------*/
+/** Registry of named locks
+ *
+ * Statistics of named locks that have been destroyed are retained (by name) so
+ * that short-lived locks still appear in the report
+ */
+/*--------------------------------------------------------------------------------*/
+typedef struct
+{
+  ThreadLockObject                             tlock;       // anonymous so never instrumented
+  std::vector<const ThreadLockObject *>        locks;
+  std::map<std::string,ThreadLockObject::STATS> retired;
+} LOCK_REGISTRY;
+
+static LOCK_REGISTRY& GetLockRegistry()
+{
+  static LOCK_REGISTRY registry;
+  return registry;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Combine statistics into the first set
+ */
+/*--------------------------------------------------------------------------------*/
+static void CombineStats(ThreadLockObject::STATS& dst, const ThreadLockObject::STATS& src)
+{
+  dst.acquisitions += src.acquisitions;
+  dst.contentions  += src.contentions;
+  dst.totalwait    += src.totalwait;
+  dst.maxwait       = std::max(dst.maxwait, src.maxwait);
+  dst.totalhold    += src.totalhold;
+  dst.maxhold       = std::max(dst.maxhold, src.maxhold);
+}
+
+static bool CompareTotalWait(const ThreadLockObject::STATS& a, const ThreadLockObject::STATS& b)
+{
+  return (a.totalwait > b.totalwait);
+}
+
+static void UpdateMax(std::atomic<uint64_t>& val, uint64_t newval)
+{
+  // only called by the lock owner so no need for compare-and-swap
+  if (newval > val.load(std::memory_order_relaxed)) val.store(newval, std::memory_order_relaxed);
+}
+
+ThreadLockObject::ThreadLockObject(const char *_name) : name(_name ? _name : ""),
+                                                        holdstart(0),
+                                                        depth(0)
 {
 #ifdef USE_PTHREADS
   pthread_mutexattr_t mta;
@@ -26,16 +76,121 @@ ThreadLockObject::ThreadLockObject()
     BBCERROR("Failed to initialise mutex<%s>: %s", StringFrom(&mutex).c_str(), strerror(errno));
   }
 #endif
+
+  stats.acquisitions = 0;
+  stats.contentions  = 0;
+  stats.totalwait    = 0;
+  stats.maxwait      = 0;
+  stats.totalhold    = 0;
+  stats.maxhold      = 0;
+
+  if (!name.empty())
+  {
+    LOCK_REGISTRY& registry = GetLockRegistry();
+    ThreadLock lock(registry.tlock);
+    registry.locks.push_back(this);
+  }
 }
 
 ThreadLockObject::~ThreadLockObject()
 {
+  if (!name.empty())
+  {
+    LOCK_REGISTRY& registry = GetLockRegistry();
+    ThreadLock lock(registry.tlock);
+    std::vector<const ThreadLockObject *>::iterator it;
+    std::map<std::string,STATS>::iterator it2;
+    STATS res;
+
+    if ((it = std::find(registry.locks.begin(), registry.locks.end(), this)) != registry.locks.end()) registry.locks.erase(it);
+
+    // retain statistics
+    GetStats(res);
+    if ((it2 = registry.retired.find(name)) != registry.retired.end()) CombineStats(it2->second, res);
+    else registry.retired[name] = res;
+  }
+
 #ifdef USE_PTHREADS
   pthread_mutex_destroy(&mutex);
 #endif
 }
 
 bool ThreadLockObject::Lock()
+{
+  return Acquire();
+}
+
+bool ThreadLockObject::Unlock()
+{
+  return Release();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Lock mutex, collecting statistics if enabled
+ */
+/*--------------------------------------------------------------------------------*/
+bool ThreadLockObject::Acquire()
+{
+  // anonymous locks are never instrumented
+  if (name.empty()) return RawLock();
+
+  bool     measure   = instrumentationenabled.load(std::memory_order_relaxed);
+  bool     contended = false;
+  uint64_t t0        = 0;
+
+  if (!measure)
+  {
+    if (!RawLock()) return false;
+  }
+  else if (!RawTryLock())
+  {
+    // lock held by another thread, time how long it takes to get it
+    contended = true;
+    t0 = GetNanosecondTicks();
+    if (!RawLock()) return false;
+  }
+
+  // lock now held, only outermost acquisitions are counted
+  if ((depth++ == 0) && measure)
+  {
+    uint64_t t = GetNanosecondTicks();
+
+    stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+    if (contended)
+    {
+      uint64_t wait = t - t0;
+
+      stats.contentions.fetch_add(1, std::memory_order_relaxed);
+      stats.totalwait.fetch_add(wait, std::memory_order_relaxed);
+      UpdateMax(stats.maxwait, wait);
+    }
+
+    holdstart = t;
+  }
+
+  return true;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Unlock mutex, collecting statistics if enabled
+ */
+/*--------------------------------------------------------------------------------*/
+bool ThreadLockObject::Release()
+{
+  if (!name.empty() && depth && (--depth == 0) && holdstart)
+  {
+    uint64_t hold = GetNanosecondTicks() - holdstart;
+
+    stats.totalhold.fetch_add(hold, std::memory_order_relaxed);
+    UpdateMax(stats.maxhold, hold);
+    holdstart = 0;
+  }
+
+  return RawUnlock();
+}
+
+bool ThreadLockObject::RawLock()
 {
 #ifdef USE_PTHREADS
   bool success = (pthread_mutex_lock(&mutex) == 0);
@@ -44,12 +199,21 @@ bool ThreadLockObject::Lock()
 
   return success;
 #else
-  lock.lock();
+  mutex.lock();
   return true;
 #endif
 }
 
-bool ThreadLockObject::Unlock()
+bool ThreadLockObject::RawTryLock()
+{
+#ifdef USE_PTHREADS
+  return (pthread_mutex_trylock(&mutex) == 0);
+#else
+  return mutex.try_lock();
+#endif
+}
+
+bool ThreadLockObject::RawUnlock()
 {
 #ifdef USE_PTHREADS
   bool success = (pthread_mutex_unlock(&mutex) == 0);
@@ -58,43 +222,142 @@ bool ThreadLockObject::Unlock()
 
   return success;
 #else
-  lock.unlock();
+  mutex.unlock();
   return true;
 #endif
 }
 
+/*--------------------------------------------------------------------------------*/
+/** Return current statistics for this lock
+ */
+/*--------------------------------------------------------------------------------*/
+void ThreadLockObject::GetStats(STATS& res) const
+{
+  res.name         = name;
+  res.acquisitions = stats.acquisitions.load(std::memory_order_relaxed);
+  res.contentions  = stats.contentions.load(std::memory_order_relaxed);
+  res.totalwait    = stats.totalwait.load(std::memory_order_relaxed);
+  res.maxwait      = stats.maxwait.load(std::memory_order_relaxed);
+  res.totalhold    = stats.totalhold.load(std::memory_order_relaxed);
+  res.maxhold      = stats.maxhold.load(std::memory_order_relaxed);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Enable/disable instrumentation of all named locks
+ */
+/*--------------------------------------------------------------------------------*/
+void ThreadLockObject::EnableInstrumentation(bool enable)
+{
+  instrumentationenabled = enable;
+}
+
+bool ThreadLockObject::IsInstrumentationEnabled()
+{
+  return instrumentationenabled;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return statistics for every named lock (locks with the same name are combined)
+ */
+/*--------------------------------------------------------------------------------*/
+void ThreadLockObject::GetInstrumentationStats(std::vector<STATS>& list)
+{
+  LOCK_REGISTRY& registry = GetLockRegistry();
+  ThreadLock lock(registry.tlock);
+  std::map<std::string,STATS> combined = registry.retired;
+  std::map<std::string,STATS>::iterator it;
+  uint_t i;
+
+  for (i = 0; i < registry.locks.size(); i++)
+  {
+    STATS res;
+
+    registry.locks[i]->GetStats(res);
+    if ((it = combined.find(res.name)) != combined.end()) CombineStats(it->second, res);
+    else combined[res.name] = res;
+  }
+
+  list.clear();
+  for (it = combined.begin(); it != combined.end(); ++it) list.push_back(it->second);
+
+  // worst offenders first
+  std::stable_sort(list.begin(), list.end(), &CompareTotalWait);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return textual lock contention report
+ */
+/*--------------------------------------------------------------------------------*/
+std::string ThreadLockObject::GetInstrumentationReport()
+{
+  std::vector<STATS> list;
+  std::string res;
+  uint_t i;
+
+  GetInstrumentationStats(list);
+
+  Printf(res, "%-32s %12s %12s %8s %14s %12s %14s %12s\n", "Lock", "Acquired", "Contended", "%", "Total wait(s)", "Max wait(s)", "Total hold(s)", "Max hold(s)");
+  for (i = 0; i < list.size(); i++)
+  {
+    const STATS& stats = list[i];
+
+    Printf(res, "%-32s %12s %12s %8.3lf %14.6lf %12.6lf %14.6lf %12.6lf\n",
+           stats.name.c_str(),
+           StringFrom(stats.acquisitions).c_str(),
+           StringFrom(stats.contentions).c_str(),
+           stats.acquisitions ? 100.0 * (double)stats.contentions / (double)stats.acquisitions : 0.0,
+           1.0e-9 * (double)stats.totalwait,
+           1.0e-9 * (double)stats.maxwait,
+           1.0e-9 * (double)stats.totalhold,
+           1.0e-9 * (double)stats.maxhold);
+  }
+
+  return res;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Reset statistics for all named locks
+ */
+/*--------------------------------------------------------------------------------*/
+void ThreadLockObject::ResetInstrumentationStats()
+{
+  LOCK_REGISTRY& registry = GetLockRegistry();
+  ThreadLock lock(registry.tlock);
+  uint_t i;
+
+  registry.retired.clear();
+
+  for (i = 0; i < registry.locks.size(); i++)
+  {
+    ThreadLockObject *obj = const_cast<ThreadLockObject *>(registry.locks[i]);
+
+    obj->stats.acquisitions = 0;
+    obj->stats.contentions  = 0;
+    obj->stats.totalwait    = 0;
+    obj->stats.maxwait      = 0;
+    obj->stats.totalhold    = 0;
+    obj->stats.maxhold      = 0;
+  }
+}
+
 /*----------------------------------------------------------------------------------------------------*/
 
 /*--------------------------------------------------------------------------------*/
 /** Constructor locks ThreadLockObject
  */
 /*--------------------------------------------------------------------------------*/
-ThreadLock::ThreadLock(ThreadLockObject& lockobj) :
-#ifdef USE_PTHREADS
-  obj(lockobj)
-#else
-  guard(lockobj.mutex)
-#endif
+ThreadLock::ThreadLock(ThreadLockObject& lockobj) : obj(lockobj)
 {
-#ifdef USE_PTHREADS
-  obj.Lock();
-#endif
+  obj.Acquire();
 }
 
 /*--------------------------------------------------------------------------------*/
 /** Const constructor to allow use in const methods
  */
 /*--------------------------------------------------------------------------------*/
-ThreadLock::ThreadLock(const ThreadLockObject& lockobj) :
-#ifdef USE_PTHREADS
-  obj(const_cast<ThreadLockObject&>(lockobj))
-#else
-  guard(const_cast<ThreadLockObject&>(lockobj).mutex)
-#endif
+ThreadLock::ThreadLock(const ThreadLockObject& lockobj) : obj(const_cast<ThreadLockObject&>(lockobj))
 {
-#ifdef USE_PTHREADS
-  obj.Lock();
-#endif
+  obj.Acquire();
 }
 
 /*--------------------------------------------------------------------------------*/
@@ -103,9 +366,7 @@ ThreadLock::ThreadLock(const ThreadLockObject& lockobj) :
 /*--------------------------------------------------------------------------------*/
 ThreadLock::~ThreadLock()
 {
-#ifdef USE_PTHREADS
-  obj.Unlock();
-#endif
+  obj.Release();
 }
 
 /*----------------------------------------------------------------------------------------------------*/
@@ -3,6 +3,10 @@
 
 #include "Thread.h"
 
+#include <string>
+#include <vector>
+#include <atomic>
+
 #ifndef USE_PTHREADS
 #include <mutex>
 #include <condition_variable>
@@ -22,7 +26,7 @@ BBC_AUDIOTOOLBOX_START
 class ThreadLockObject
 {
 public:
-  ThreadLockObject();
+  ThreadLockObject(const char *_name = NULL);
   virtual ~ThreadLockObject();
 
   /*--------------------------------------------------------------------------------*/
@@ -37,18 +41,101 @@ public:
   /*--------------------------------------------------------------------------------*/
   virtual bool Unlock();
 
-#ifndef USE_PTHREADS
+  /*--------------------------------------------------------------------------------*/
+  /** Return name of lock (empty if the lock is anonymous)
+   *
+   * @note only named locks are instrumented (see EnableInstrumentation())
+   */
+  /*--------------------------------------------------------------------------------*/
+  const std::string& GetName() const {return name;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Contention statistics for a named lock (all times in ns)
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef struct
+  {
+    std::string name;
+    uint64_t    acquisitions;     // number of (outermost) acquisitions
+    uint64_t    contentions;      // number of acquisitions that had to wait for another thread
+    uint64_t    totalwait;        // total time spent waiting for the lock
+    uint64_t    maxwait;          // longest single wait for the lock
+    uint64_t    totalhold;        // total time the lock was held
+    uint64_t    maxhold;          // longest single hold of the lock
+  } STATS;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Enable/disable instrumentation of all named locks
+   *
+   * @note when disabled (the default) the only overhead is a single flag test per lock
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void EnableInstrumentation(bool enable = true);
+  static bool IsInstrumentationEnabled();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return statistics for every named lock (locks with the same name are combined)
+   *
+   * @note list is sorted by total wait time, worst first
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void GetInstrumentationStats(std::vector<STATS>& list);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return textual lock contention report
+   */
+  /*--------------------------------------------------------------------------------*/
+  static std::string GetInstrumentationReport();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Reset statistics for all named locks
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void ResetInstrumentationStats();
+
 protected:
   friend class ThreadLock;
-#endif
+
+  /*--------------------------------------------------------------------------------*/
+  /** Lock/unlock mutex, collecting statistics if enabled
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool Acquire();
+  bool Release();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Raw lock/unlock of mutex (no statistics)
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool RawLock();
+  bool RawTryLock();
+  bool RawUnlock();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return current statistics for this lock
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetStats(STATS& res) const;
   
 protected:
 #ifdef USE_PTHREADS
   pthread_mutex_t mutex;
 #else
   std::recursive_mutex mutex;
-  std::unique_lock<std::recursive_mutex> lock;
 #endif
+  std::string name;
+  // statistics are only written by the owning thread but are atomic so that
+  // they can be read for reporting *without* taking the lock being measured
+  struct {
+    std::atomic<uint64_t> acquisitions;
+    std::atomic<uint64_t> contentions;
+    std::atomic<uint64_t> totalwait;
+    std::atomic<uint64_t> maxwait;
+    std::atomic<uint64_t> totalhold;
+    std::atomic<uint64_t> maxhold;
+  } stats;
+  uint64_t holdstart;         // time of outermost acquisition (0 if not being measured)
+  uint_t   depth;             // recursion depth of owning thread
 };
 
 /*--------------------------------------------------------------------------------*/
@@ -75,11 +162,7 @@ public:
   ~ThreadLock();
 
 protected:
-#ifdef USE_PTHREADS
   ThreadLockObject& obj;
-#else
-  std::lock_guard<std::recursive_mutex> guard;
-#endif
 };
 
 /*--------------------------------------------------------------------------------*/
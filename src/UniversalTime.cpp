@@ -0,0 +1,390 @@
+
+#define BBCDEBUG_LEVEL 1
+#include "UniversalTime.h"
+
+BBC_AUDIOTOOLBOX_START
+
+UniversalTime::UniversalTime(uint64_t den) : time_current(0),
+                                             time_offset(0),
+                                             time_numerator(0),
+                                             time_denominator(den),
+                                             receiverlock("UniversalTime")
+{
+  StoreDenominator(den);
+}
+
+UniversalTime::UniversalTime(const UniversalTime& obj) : receiverlock("UniversalTime")
+{
+  SNAPSHOT snapshot;
+
+  obj.GetSnapshot(snapshot);
+
+  time_current     = snapshot.current;
+  time_offset      = snapshot.offset;
+  time_numerator   = snapshot.numerator;
+  StoreDenominator(snapshot.denominator);
+}
+
+UniversalTime::~UniversalTime()
+{
+  ThreadLock lock(receiverlock);
+  uint_t i;
+
+  updatehooks.Clear();
+  for (i = 0; i < receivers.size(); i++) delete receivers[i];
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add update receiver
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::AddUpdateReceiver(UniversalTimeUpdateReceiver *receiver)
+{
+  ThreadLock lock(receiverlock);
+  uint_t i;
+
+  for (i = 0; i < receivers.size(); i++)
+  {
+    if (receivers[i]->receiver == receiver) return;
+  }
+
+  RECEIVER *rec = new RECEIVER;
+  rec->timebase = this;
+  rec->receiver = receiver;
+  receivers.push_back(rec);
+
+  updatehooks.Add(&Notify, rec);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Remove update receiver
+ *
+ * @note once this returns, the receiver will not be called again
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::RemoveUpdateReceiver(UniversalTimeUpdateReceiver *receiver)
+{
+  ThreadLock lock(receiverlock);
+  uint_t i;
+
+  for (i = 0; i < receivers.size(); i++)
+  {
+    if (receivers[i]->receiver == receiver)
+    {
+      // Remove() waits for any in-progress notifications so the record can then be deleted
+      updatehooks.Remove(&Notify, receivers[i]);
+      delete receivers[i];
+      receivers.erase(receivers.begin() + i);
+      break;
+    }
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Callback used to call TimebaseUpdated() of a receiver
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::Notify(void *arg)
+{
+  const RECEIVER *rec = (const RECEIVER *)arg;
+  rec->receiver->TimebaseUpdated(rec->timebase);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Assignment operator
+ */
+/*--------------------------------------------------------------------------------*/
+UniversalTime& UniversalTime::operator = (const UniversalTime& obj)
+{
+  if (&obj != this)
+  {
+    SNAPSHOT snapshot;
+
+    obj.GetSnapshot(snapshot);
+
+    seqlock.WriteStart();
+    time_current.store(snapshot.current, std::memory_order_relaxed);
+    time_offset.store(snapshot.offset, std::memory_order_relaxed);
+    time_numerator.store(snapshot.numerator, std::memory_order_relaxed);
+    StoreDenominator(snapshot.denominator);
+    seqlock.WriteEnd();
+  }
+  return *this;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Change denominator -> use offset to save current ns time and reset numerator to 0
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::SetDenominator(uint64_t den)
+{
+  bool changed;
+
+  seqlock.WriteStart();
+  if ((changed = (den != time_denominator.load(std::memory_order_relaxed))))
+  {
+    time_offset.store(time_current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    time_numerator.store(0, std::memory_order_relaxed);
+    StoreDenominator(den);
+    CalcTime();
+  }
+  seqlock.WriteEnd();
+
+  if (changed) NotifyReceivers();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Reset time to zero
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::Reset()
+{
+  seqlock.WriteStart();
+  time_offset.store(0, std::memory_order_relaxed);
+  time_numerator.store(0, std::memory_order_relaxed);
+  CalcTime();
+  seqlock.WriteEnd();
+
+  NotifyReceivers();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Add to offset and set/add numerator, recalculate time and notify receivers
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::Update(uint64_t offset, uint64_t num, bool add)
+{
+  seqlock.WriteStart();
+  if (offset) time_offset.store(time_offset.load(std::memory_order_relaxed) + offset, std::memory_order_relaxed);
+  if (add) num += time_numerator.load(std::memory_order_relaxed);
+  time_numerator.store(num, std::memory_order_relaxed);
+  CalcTime();
+  seqlock.WriteEnd();
+
+  NotifyReceivers();
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Recalculate time (must be called between seqlock.WriteStart() and seqlock.WriteEnd())
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::CalcTime()
+{
+  RECIPROCAL reciprocal;
+
+  GetReciprocal(reciprocal);
+
+  time_current.store(time_offset.load(std::memory_order_relaxed) + Calc(time_numerator.load(std::memory_order_relaxed), reciprocal),
+                     std::memory_order_release);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return reciprocal of current denominator (must be called between seqlock.WriteStart() and seqlock.WriteEnd())
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::GetReciprocal(RECIPROCAL& reciprocal) const
+{
+  reciprocal.divisor    = time_denominator.load(std::memory_order_relaxed);
+  reciprocal.multiplier = time_multiplier.load(std::memory_order_relaxed);
+  reciprocal.shift      = time_shift.load(std::memory_order_relaxed);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Set denominator and its reciprocal (must be called between seqlock.WriteStart() and seqlock.WriteEnd())
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::StoreDenominator(uint64_t den)
+{
+  RECIPROCAL reciprocal;
+
+  CalcReciprocal(den, reciprocal);
+
+  time_denominator.store(reciprocal.divisor, std::memory_order_relaxed);
+  time_multiplier.store(reciprocal.multiplier, std::memory_order_relaxed);
+  time_shift.store(reciprocal.shift, std::memory_order_relaxed);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Perform explicit calculation using denominator
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t UniversalTime::Calc(uint64_t num) const
+{
+  RECIPROCAL reciprocal;
+  uint_t seq;
+
+  do
+  {
+    seq = seqlock.ReadStart();
+    GetReciprocal(reciprocal);
+  }
+  while (seqlock.ReadRetry(seq));
+
+  return Calc(num, reciprocal);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Calculate 128-bit product of two 64-bit values
+ */
+/*--------------------------------------------------------------------------------*/
+static inline void Multiply128(uint64_t a, uint64_t b, uint64_t& hi, uint64_t& lo)
+{
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 res = (unsigned __int128)a * b;
+  hi = (uint64_t)(res >> 64);
+  lo = (uint64_t)res;
+#else
+  uint64_t al = a & 0xffffffff, ah = a >> 32;
+  uint64_t bl = b & 0xffffffff, bh = b >> 32;
+  uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+  uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+
+  lo = (mid << 32) | (ll & 0xffffffff);
+  hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Divide 128-bit value by 64-bit value
+ *
+ * @note hi MUST be less than div (i.e. the result must fit in 64 bits)
+ */
+/*--------------------------------------------------------------------------------*/
+static inline uint64_t Divide128(uint64_t hi, uint64_t lo, uint64_t div)
+{
+#ifdef __SIZEOF_INT128__
+  return (uint64_t)((((unsigned __int128)hi << 64) | lo) / div);
+#else
+  uint64_t res = 0;
+  int i;
+
+  // simple long division, only used when calculating reciprocals or for very large denominators
+  for (i = 63; i >= 0; i--)
+  {
+    bool carry = ((hi >> 63) != 0);
+
+    hi  = (hi << 1) | ((lo >> i) & 1);
+    res = res << 1;
+    if (carry || (hi >= div))
+    {
+      hi -= div;
+      res |= 1;
+    }
+  }
+
+  return res;
+#endif
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Calculate reciprocal for divisor
+ *
+ * With l = ceil(log2(d)) and m = floor(2^64 * (2^l - d) / d) + 1,
+ * floor(x / d) = (t + ((x - t) >> 1)) >> (l - 1) where t = (m * x) >> 64
+ * for *every* 64-bit x
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::CalcReciprocal(uint64_t divisor, RECIPROCAL& reciprocal)
+{
+  // a zero denominator is meaningless, treat as 1
+  reciprocal.divisor    = divisor ? divisor : 1;
+  reciprocal.multiplier = 0;
+  reciprocal.shift      = 0;
+
+  if (reciprocal.divisor > 1)
+  {
+    uint64_t d = reciprocal.divisor;
+    uint_t   l = 1;
+
+    while ((l < 64) && ((1ULL << l) < d)) l++;
+
+    // 2^l - d (modulo 2^64 handles l == 64)
+    reciprocal.multiplier = Divide128((l < 64) ? ((1ULL << l) - d) : (0 - d), 0, d) + 1;
+    reciprocal.shift      = l;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return floor(val / reciprocal.divisor) without dividing
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t UniversalTime::Divide(uint64_t val, const RECIPROCAL& reciprocal)
+{
+  uint64_t hi, lo;
+
+  if (!reciprocal.shift) return val;
+
+  Multiply128(reciprocal.multiplier, val, hi, lo);
+
+  return (hi + ((val - hi) >> 1)) >> (reciprocal.shift - 1);
+}
+
+// largest denominator for which remainder * 1e9 fits in 64 bits
+static const uint64_t MaxFastDenominator = ~(uint64_t)0 / 1000000000ULL;
+
+/*--------------------------------------------------------------------------------*/
+/** Exact conversion floor(1e9 * num / den)
+ *
+ * num is split into whole seconds and a remainder so that no intermediate overflows
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t UniversalTime::Calc(uint64_t num, const RECIPROCAL& reciprocal)
+{
+  uint64_t secs = Divide(num, reciprocal);
+  uint64_t rem  = num - secs * reciprocal.divisor;
+  uint64_t frac;
+
+  if (reciprocal.divisor <= MaxFastDenominator) frac = Divide(rem * 1000000000ULL, reciprocal);
+  else
+  {
+    uint64_t hi, lo;
+    Multiply128(rem, 1000000000ULL, hi, lo);
+    frac = Divide128(hi, lo, reciprocal.divisor);
+  }
+
+  return secs * 1000000000ULL + frac;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Exact conversion floor(val * den / 1e9)
+ */
+/*--------------------------------------------------------------------------------*/
+uint64_t UniversalTime::Invert(uint64_t val, uint64_t den)
+{
+  // division by a constant is converted to a multiply by the compiler
+  uint64_t secs = val / 1000000000ULL;
+  uint64_t rem  = val - secs * 1000000000ULL;
+  uint64_t frac;
+
+  if (den <= MaxFastDenominator) frac = (rem * den) / 1000000000ULL;
+  else
+  {
+    uint64_t hi, lo;
+    Multiply128(rem, den, hi, lo);
+    frac = Divide128(hi, lo, 1000000000ULL);
+  }
+
+  return secs * den + frac;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return consistent set of timebase values (lock-free)
+ */
+/*--------------------------------------------------------------------------------*/
+void UniversalTime::GetSnapshot(SNAPSHOT& snapshot) const
+{
+  uint_t seq;
+
+  do
+  {
+    seq = seqlock.ReadStart();
+
+    snapshot.current     = time_current.load(std::memory_order_relaxed);
+    snapshot.offset      = time_offset.load(std::memory_order_relaxed);
+    snapshot.numerator   = time_numerator.load(std::memory_order_relaxed);
+    snapshot.denominator = time_denominator.load(std::memory_order_relaxed);
+  }
+  while (seqlock.ReadRetry(seq));
+}
+
+BBC_AUDIOTOOLBOX_END
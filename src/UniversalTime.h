@@ -2,9 +2,12 @@
 #define __UNIVERSAL_TIME__
 
 #include <vector>
-#include <algorithm>
+#include <atomic>
 
 #include "misc.h"
+#include "ThreadLock.h"
+#include "CallbackList.h"
+#include "SequenceLock.h"
 
 BBC_AUDIOTOOLBOX_START
 
@@ -35,133 +38,137 @@ public:
  *
  * For sample base times, the denominator should be set at the sample rate and
  * then the numerator can simply count samples
+ *
+ * Conversions are exact (the result is always floor(1e9 * numerator / denominator))
+ * and cannot overflow for any numerator whose result fits in 64 bits.  A reciprocal
+ * multiplier is calculated whenever the denominator changes so that updates do not
+ * require any divides
+ *
+ * The timebase may be read from any number of threads without locking: the values
+ * are protected by a sequence lock so GetSnapshot() always returns a consistent set
+ * of values.  Updates from multiple threads are serialised.
+ *
+ * Update receivers can be added and removed from any thread (but NOT from within
+ * TimebaseUpdated())
  */
 /*--------------------------------------------------------------------------------*/
 class UniversalTime
 {
 public:
-  UniversalTime(uint64_t den = 1) : time_current(0),
-                                    time_offset(0),
-                                    time_numerator(0),
-                                    time_denominator(den) {}
-  UniversalTime(const UniversalTime& obj) : time_current(obj.time_current),
-                                            time_offset(obj.time_offset),
-                                            time_numerator(obj.time_numerator),
-                                            time_denominator(obj.time_denominator) {}
-  virtual ~UniversalTime() {}
+  UniversalTime(uint64_t den = 1);
+  UniversalTime(const UniversalTime& obj);
+  virtual ~UniversalTime();
 
   /*--------------------------------------------------------------------------------*/
-  /** Add update receiver
+  /** Consistent set of timebase values
    */
   /*--------------------------------------------------------------------------------*/
-  virtual void AddUpdateReceiver(UniversalTimeUpdateReceiver *receiver)
+  typedef struct
   {
-    if (std::find(updatelist.begin(), updatelist.end(), receiver) == updatelist.end()) updatelist.push_back(receiver);
-  }
+    uint64_t current;       // calculated time in ns
+    uint64_t offset;        // offset in ns
+    uint64_t numerator;
+    uint64_t denominator;
+  } SNAPSHOT;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add update receiver
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void AddUpdateReceiver(UniversalTimeUpdateReceiver *receiver);
 
   /*--------------------------------------------------------------------------------*/
   /** Remove update receiver
+   *
+   * @note once this returns, the receiver will not be called again
    */
   /*--------------------------------------------------------------------------------*/
-  virtual void RemoveUpdateReceiver(UniversalTimeUpdateReceiver *receiver)
-  {
-    std::vector<UniversalTimeUpdateReceiver *>::iterator it;
-    if ((it = std::find(updatelist.begin(), updatelist.end(), receiver)) != updatelist.end()) updatelist.erase(it);
-  }
+  virtual void RemoveUpdateReceiver(UniversalTimeUpdateReceiver *receiver);
 
   /*--------------------------------------------------------------------------------*/
   /** Assignment operator
    */
   /*--------------------------------------------------------------------------------*/
-  UniversalTime& operator = (const UniversalTime& obj)
-  {
-    time_current     = obj.time_current;
-    time_offset      = obj.time_offset;
-    time_numerator   = obj.time_numerator;
-    time_denominator = obj.time_denominator;
-    return *this;
-  }
+  UniversalTime& operator = (const UniversalTime& obj);
 
   /*--------------------------------------------------------------------------------*/
   /** Change denominator -> use offset to save current ns time and reset numerator to 0
    */
   /*--------------------------------------------------------------------------------*/
-  virtual void SetDenominator(uint64_t den) {
-    if (den != time_denominator)
-    {
-      time_offset      = GetTime();
-      time_numerator   = 0;
-      time_denominator = den;
-      UpdateTime();
-    }
-  }
+  virtual void SetDenominator(uint64_t den);
 
   /*--------------------------------------------------------------------------------*/
   /** Reset time to zero
    */
   /*--------------------------------------------------------------------------------*/
-  virtual void Reset() {time_offset = 0; time_numerator = 0;}
+  virtual void Reset();
 
   /*--------------------------------------------------------------------------------*/
   /** Set numerator
    */
   /*--------------------------------------------------------------------------------*/
-  virtual void Set(uint64_t num)                                {time_numerator = num; UpdateTime();}
+  virtual void Set(uint64_t num)                                {Update(0, num, false);}
 
   /*--------------------------------------------------------------------------------*/
   /** Add to numerator
    */
   /*--------------------------------------------------------------------------------*/
-  virtual void Add(uint64_t inc)                                {time_numerator += inc; UpdateTime();}
+  virtual void Add(uint64_t inc)                                {Update(0, inc, true);}
 
   /*--------------------------------------------------------------------------------*/
   /** Add nano seconds to offset
    */
   /*--------------------------------------------------------------------------------*/
-  virtual void AddNanoSeconds(uint64_t ns)                      {time_offset    += ns;  UpdateTime();}
+  virtual void AddNanoSeconds(uint64_t ns)                      {Update(ns, 0, true);}
 
   /*--------------------------------------------------------------------------------*/
   /** Set numerator
    */
   /*--------------------------------------------------------------------------------*/
-  virtual UniversalTime& operator = (uint64_t num)              {time_numerator  = num; UpdateTime(); return *this;}
+  virtual UniversalTime& operator = (uint64_t num)              {Set(num); return *this;}
 
   /*--------------------------------------------------------------------------------*/
   /** Add to numerator
    */
   /*--------------------------------------------------------------------------------*/
-  virtual UniversalTime& operator += (uint64_t inc)             {time_numerator += inc; UpdateTime(); return *this;}
+  virtual UniversalTime& operator += (uint64_t inc)             {Add(inc); return *this;}
 
   /*--------------------------------------------------------------------------------*/
   /** Add one object to another using offset
    */
   /*--------------------------------------------------------------------------------*/
-  virtual UniversalTime& operator += (const UniversalTime& obj) {time_offset    += obj.GetTime(); UpdateTime(); return *this;}
+  virtual UniversalTime& operator += (const UniversalTime& obj) {AddNanoSeconds(obj.GetTime()); return *this;}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return consistent set of timebase values (lock-free)
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetSnapshot(SNAPSHOT& snapshot) const;
 
   /*--------------------------------------------------------------------------------*/
   /** Return calculated time in raw values 
    */
   /*--------------------------------------------------------------------------------*/
-  uint64_t GetRawTime() const {return time_numerator;}
+  uint64_t GetRawTime() const {return time_numerator.load(std::memory_order_acquire);}
   
   /*--------------------------------------------------------------------------------*/
   /** Return calculated time in ns
    */
   /*--------------------------------------------------------------------------------*/
-  uint64_t GetTime()    const {return time_current;}
-  operator uint64_t()   const {return time_current;}
+  uint64_t GetTime()    const {return time_current.load(std::memory_order_acquire);}
+  operator uint64_t()   const {return GetTime();}
 
   /*--------------------------------------------------------------------------------*/
   /** Return calculated time in s
    */
   /*--------------------------------------------------------------------------------*/
-  double GetTimeSeconds() const {return 1.0e-9 * (double)time_current;}
+  double GetTimeSeconds() const {return 1.0e-9 * (double)GetTime();}
 
   /*--------------------------------------------------------------------------------*/
   /** Perform explicit calculation using denominator
    */
   /*--------------------------------------------------------------------------------*/
-  uint64_t Calc(uint64_t num)        const {return (uint64_t)((1000000000ULL * (ullong_t)num) / time_denominator);}
+  uint64_t Calc(uint64_t num)        const;
   double   CalcSeconds(uint64_t num) const {return 1.0e-9 * (double)Calc(num);}
 
   friend uint64_t operator * (const UniversalTime& timebase, uint64_t num)  {return timebase.Calc(num);}
@@ -171,24 +178,98 @@ public:
   /** Perform inverse conversion from time in ns
    */
   /*--------------------------------------------------------------------------------*/
-  uint64_t Invert(uint64_t val)      const {return (uint64_t)(((ullong_t)val * (ullong_t)time_denominator) / 1000000000ULL);}
+  uint64_t Invert(uint64_t val)      const {return Invert(val, time_denominator.load(std::memory_order_acquire));}
 
   friend uint64_t operator / (uint64_t time, const UniversalTime& timebase) {return timebase.Invert(time);}
 
 protected:
-  void UpdateTime()
+  /*--------------------------------------------------------------------------------*/
+  /** Precomputed reciprocal allowing exact division by a fixed 64-bit divisor using
+   * multiplies and shifts (Granlund-Montgomery)
+   */
+  /*--------------------------------------------------------------------------------*/
+  typedef struct
+  {
+    uint64_t divisor;
+    uint64_t multiplier;
+    uint_t   shift;
+  } RECIPROCAL;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Calculate reciprocal for divisor
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void CalcReciprocal(uint64_t divisor, RECIPROCAL& reciprocal);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return floor(val / reciprocal.divisor) without dividing
+   */
+  /*--------------------------------------------------------------------------------*/
+  static uint64_t Divide(uint64_t val, const RECIPROCAL& reciprocal);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Exact conversions using 128-bit intermediates
+   *
+   * Calc():   floor(1e9 * num / den)
+   * Invert(): floor(val * den / 1e9)
+   */
+  /*--------------------------------------------------------------------------------*/
+  static uint64_t Calc(uint64_t num, const RECIPROCAL& reciprocal);
+  static uint64_t Invert(uint64_t val, uint64_t den);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Return reciprocal of current denominator (must be called between seqlock.WriteStart() and seqlock.WriteEnd())
+   */
+  /*--------------------------------------------------------------------------------*/
+  void GetReciprocal(RECIPROCAL& reciprocal) const;
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set denominator and its reciprocal (must be called between seqlock.WriteStart() and seqlock.WriteEnd())
+   */
+  /*--------------------------------------------------------------------------------*/
+  void StoreDenominator(uint64_t den);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Add to offset and set/add numerator, recalculate time and notify receivers
+   */
+  /*--------------------------------------------------------------------------------*/
+  void Update(uint64_t offset, uint64_t num, bool add);
+
+  /*--------------------------------------------------------------------------------*/
+  /** Recalculate time (must be called between seqlock.WriteStart() and seqlock.WriteEnd())
+   */
+  /*--------------------------------------------------------------------------------*/
+  void CalcTime();
+
+  /*--------------------------------------------------------------------------------*/
+  /** Notify receivers of update
+   */
+  /*--------------------------------------------------------------------------------*/
+  void NotifyReceivers() {updatehooks.Call();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Callback used to call TimebaseUpdated() of a receiver
+   */
+  /*--------------------------------------------------------------------------------*/
+  static void Notify(void *arg);
+
+  typedef struct
   {
-    uint_t i;
-    time_current = time_offset + (uint64_t)((1000000000ULL * (ullong_t)time_numerator) / time_denominator);
-    for (i = 0; i < updatelist.size(); i++) updatelist[i]->TimebaseUpdated(this);
-  }
+    UniversalTime               *timebase;
+    UniversalTimeUpdateReceiver *receiver;
+  } RECEIVER;
 
 protected:
-  uint64_t time_current;
-  uint64_t time_offset;
-  uint64_t time_numerator;
-  uint64_t time_denominator;
-  std::vector<UniversalTimeUpdateReceiver *> updatelist;
+  SequenceLock          seqlock;
+  std::atomic<uint64_t> time_current;
+  std::atomic<uint64_t> time_offset;
+  std::atomic<uint64_t> time_numerator;
+  std::atomic<uint64_t> time_denominator;
+  std::atomic<uint64_t> time_multiplier;  // reciprocal of denominator (see RECIPROCAL)
+  std::atomic<uint_t>   time_shift;
+  ThreadLockObject      receiverlock;
+  std::vector<RECEIVER *> receivers;
+  CallbackList          updatehooks;
 };
 
 BBC_AUDIOTOOLBOX_END
@@ -118,6 +118,208 @@ namespace json
     return true;
   }
 
+  /*--------------------------------------------------------------------------------*/
+  /** Read next value from reader, skipping it and returning false if it is not a scalar
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename READER>
+  static bool ReadScalar(READER& reader)
+  {
+    reader.Next();
+    if (reader.IsScalar()) return true;
+    reader.Skip();
+    return false;
+  }
+
+  /*--------------------------------------------------------------------------------*/
+  /** Conversions from streaming reader
+   *
+   * As with jsoncpp, null converts to 0/false, bools to 0/1 and reals are truncated
+   * when converted to integers
+   *
+   * These are shared by JSONReader and CBORReader which have the same API
+   */
+  /*--------------------------------------------------------------------------------*/
+  template<typename READER>
+  static bool ReadValue(READER& reader, bool& val)
+  {
+    bool success = ReadScalar(reader);
+    if (success)
+    {
+      switch (reader.GetToken())
+      {
+        case READER::Token_Null:   val = false;                        break;
+        case READER::Token_Bool:   val = reader.GetBool();             break;
+        case READER::Token_Number: val = (reader.GetDouble() != 0.0);  break;
+        default: success = false; break;
+      }
+    }
+    return success;
+  }
+
+  template<typename READER>
+  static bool ReadValue(READER& reader, sint_t& val)
+  {
+    bool success = ReadScalar(reader);
+    if (success)
+    {
+      switch (reader.GetToken())
+      {
+        case READER::Token_Null: val = 0;                              break;
+        case READER::Token_Bool: val = reader.GetBool() ? 1 : 0;       break;
+        case READER::Token_Number:
+        {
+          // 32-bit integers are exact in a double
+          double dval = reader.GetDouble();
+          if ((dval >= -2147483648.0) && (dval <= 2147483647.0)) val = (sint_t)dval;
+          else success = false;
+          break;
+        }
+        default: success = false; break;
+      }
+    }
+    return success;
+  }
+
+  template<typename READER>
+  static bool ReadValue(READER& reader, uint_t& val)
+  {
+    bool success = ReadScalar(reader);
+    if (success)
+    {
+      switch (reader.GetToken())
+      {
+        case READER::Token_Null: val = 0;                              break;
+        case READER::Token_Bool: val = reader.GetBool() ? 1 : 0;       break;
+        case READER::Token_Number:
+        {
+          double dval = reader.GetDouble();
+          if ((dval >= 0.0) && (dval <= 4294967295.0)) val = (uint_t)dval;
+          else success = false;
+          break;
+        }
+        default: success = false; break;
+      }
+    }
+    return success;
+  }
+
+  template<typename READER>
+  static bool ReadValue(READER& reader, sint64_t& val)
+  {
+    bool success = ReadScalar(reader);
+    if (success)
+    {
+      switch (reader.GetToken())
+      {
+        case READER::Token_Null: val = 0;                              break;
+        case READER::Token_Bool: val = reader.GetBool() ? 1 : 0;       break;
+        case READER::Token_Number:
+        {
+          sllong_t ival;
+          double   dval = reader.GetDouble();
+          if (reader.IsInteger())
+          {
+            if ((success = reader.GetInteger(ival)) == true) val = (sint64_t)ival;
+          }
+          else if ((dval >= -9223372036854775808.0) && (dval < 9223372036854775808.0)) val = (sint64_t)dval;
+          else success = false;
+          break;
+        }
+        default: success = false; break;
+      }
+    }
+    return success;
+  }
+
+  template<typename READER>
+  static bool ReadValue(READER& reader, uint64_t& val)
+  {
+    bool success = ReadScalar(reader);
+    if (success)
+    {
+      switch (reader.GetToken())
+      {
+        case READER::Token_Null: val = 0;                              break;
+        case READER::Token_Bool: val = reader.GetBool() ? 1 : 0;       break;
+        case READER::Token_Number:
+        {
+          ullong_t uval;
+          double   dval = reader.GetDouble();
+          if (reader.IsInteger())
+          {
+            if ((success = reader.GetInteger(uval)) == true) val = (uint64_t)uval;
+          }
+          else if ((dval >= 0.0) && (dval < 18446744073709551616.0)) val = (uint64_t)dval;
+          else success = false;
+          break;
+        }
+        default: success = false; break;
+      }
+    }
+    return success;
+  }
+
+  template<typename READER>
+  static bool ReadValue(READER& reader, double& val)
+  {
+    bool success = ReadScalar(reader);
+    if (success)
+    {
+      switch (reader.GetToken())
+      {
+        case READER::Token_Null:   val = 0.0;                          break;
+        case READER::Token_Bool:   val = reader.GetBool() ? 1.0 : 0.0; break;
+        case READER::Token_Number: val = reader.GetDouble();           break;
+        default: success = false; break;
+      }
+    }
+    return success;
+  }
+
+  template<typename READER>
+  static bool ReadValue(READER& reader, float& val)
+  {
+    double dval;
+    bool success = ReadValue(reader, dval);
+    if (success) val = (float)dval;
+    return success;
+  }
+
+  template<typename READER>
+  static bool ReadValue(READER& reader, std::string& val)
+  {
+    bool success = (ReadScalar(reader) && (reader.GetToken() == READER::Token_String));
+    if (success) val = reader.GetString();
+    return success;
+  }
+
+  template<typename READER>
+  static bool ReadValue(READER& reader, JSONValue& val)
+  {
+    return reader.ReadValue(val);
+  }
+
+  bool FromJSON(JSONReader& reader, bool& val)        {return ReadValue(reader, val);}
+  bool FromJSON(JSONReader& reader, sint_t& val)      {return ReadValue(reader, val);}
+  bool FromJSON(JSONReader& reader, uint_t& val)      {return ReadValue(reader, val);}
+  bool FromJSON(JSONReader& reader, sint64_t& val)    {return ReadValue(reader, val);}
+  bool FromJSON(JSONReader& reader, uint64_t& val)    {return ReadValue(reader, val);}
+  bool FromJSON(JSONReader& reader, float& val)       {return ReadValue(reader, val);}
+  bool FromJSON(JSONReader& reader, double& val)      {return ReadValue(reader, val);}
+  bool FromJSON(JSONReader& reader, std::string& val) {return ReadValue(reader, val);}
+  bool FromJSON(JSONReader& reader, JSONValue& val)   {return ReadValue(reader, val);}
+
+  bool FromJSON(CBORReader& reader, bool& val)        {return ReadValue(reader, val);}
+  bool FromJSON(CBORReader& reader, sint_t& val)      {return ReadValue(reader, val);}
+  bool FromJSON(CBORReader& reader, uint_t& val)      {return ReadValue(reader, val);}
+  bool FromJSON(CBORReader& reader, sint64_t& val)    {return ReadValue(reader, val);}
+  bool FromJSON(CBORReader& reader, uint64_t& val)    {return ReadValue(reader, val);}
+  bool FromJSON(CBORReader& reader, float& val)       {return ReadValue(reader, val);}
+  bool FromJSON(CBORReader& reader, double& val)      {return ReadValue(reader, val);}
+  bool FromJSON(CBORReader& reader, std::string& val) {return ReadValue(reader, val);}
+  bool FromJSON(CBORReader& reader, JSONValue& val)   {return ReadValue(reader, val);}
+
   void ToJSON(bool val, JSONValue& obj)
   {
     obj = val;
@@ -163,6 +365,96 @@ namespace json
     obj = val;
   }
 
+  void ToJSON(bool val, JSONWriter& writer)
+  {
+    writer.Bool(val);
+  }
+
+  void ToJSON(uint_t val, JSONWriter& writer)
+  {
+    writer.UInt(val);
+  }
+
+  void ToJSON(sint_t val, JSONWriter& writer)
+  {
+    writer.Int(val);
+  }
+
+  void ToJSON(uint64_t val, JSONWriter& writer)
+  {
+    writer.UInt(val);
+  }
+
+  void ToJSON(sint64_t val, JSONWriter& writer)
+  {
+    writer.Int(val);
+  }
+
+  void ToJSON(float val, JSONWriter& writer)
+  {
+    writer.Double(val);
+  }
+
+  void ToJSON(double val, JSONWriter& writer)
+  {
+    writer.Double(val);
+  }
+
+  void ToJSON(const std::string& val, JSONWriter& writer)
+  {
+    writer.String(val);
+  }
+
+  void ToJSON(const JSONValue& val, JSONWriter& writer)
+  {
+    writer.Write(val);
+  }
+
+  void ToJSON(bool val, CBORWriter& writer)
+  {
+    writer.Bool(val);
+  }
+
+  void ToJSON(uint_t val, CBORWriter& writer)
+  {
+    writer.UInt(val);
+  }
+
+  void ToJSON(sint_t val, CBORWriter& writer)
+  {
+    writer.Int(val);
+  }
+
+  void ToJSON(uint64_t val, CBORWriter& writer)
+  {
+    writer.UInt(val);
+  }
+
+  void ToJSON(sint64_t val, CBORWriter& writer)
+  {
+    writer.Int(val);
+  }
+
+  void ToJSON(float val, CBORWriter& writer)
+  {
+    writer.Double(val);
+  }
+
+  void ToJSON(double val, CBORWriter& writer)
+  {
+    writer.Double(val);
+  }
+
+  void ToJSON(const std::string& val, CBORWriter& writer)
+  {
+    writer.String(val);
+  }
+
+  void ToJSON(const JSONValue& val, CBORWriter& writer)
+  {
+    writer.Write(val);
+  }
+
   /*--------------------------------------------------------------------------------*/
   /** Convert from JSON text to JSON data
    */
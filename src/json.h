@@ -2,6 +2,10 @@
 #define __BBCAT_JSON__
 
 #include "misc.h"
+#include "JSONReader.h"
+#include "JSONWriter.h"
+#include "CBORReader.h"
+#include "CBORWriter.h"
 
 #if ENABLE_JSON
 #include <json/json.h>
@@ -46,6 +50,12 @@ BBC_AUDIOTOOLBOX_START
  * json::FromJSON(<jsonobj>, <member>, <obj>) - Convert from member <member> of a JSON object (JSONValue) to any supported object
  * json::FromJSON(<jsonobj>, <index>, <obj>)  - Convert from index  <index> of a JSON array (JSONValue) to any supported object
  *
+ * json::FromJSON(<reader>, <obj>)    - Read the next value from a streaming JSON reader (JSONReader) into any supported object
+ * json::ToJSON(<obj>, <writer>)      - Write any supported object to a streaming JSON writer (JSONWriter)
+ *
+ * The streaming reader and writer can be replaced by CBORReader and CBORWriter to read
+ * and write the same data (with the same member names) in binary CBOR form
+ *
  * json::FromJSONString(<str>, <obj>)  - Convert from a JSON string to any supported object
  * json::ToJSONString(<obj>, <pretty>) - Returns a [pretty] JSON string from any supported object
  *
@@ -97,6 +107,33 @@ namespace json
   // for completeness
   extern bool FromJSON(const JSONValue& obj, JSONValue& val);
 
+  /*--------------------------------------------------------------------------------*/
+  /** Conversions from the next value of a streaming JSON or CBOR reader to basic types
+   *
+   * Conversions are the same as from JSONValue above, values that cannot be converted
+   * are skipped
+   */
+  /*--------------------------------------------------------------------------------*/
+  extern bool FromJSON(JSONReader& reader, bool& val);
+  extern bool FromJSON(JSONReader& reader, sint_t& val);
+  extern bool FromJSON(JSONReader& reader, uint_t& val);
+  extern bool FromJSON(JSONReader& reader, sint64_t& val);
+  extern bool FromJSON(JSONReader& reader, uint64_t& val);
+  extern bool FromJSON(JSONReader& reader, float& val);
+  extern bool FromJSON(JSONReader& reader, double& val);
+  extern bool FromJSON(JSONReader& reader, std::string& val);
+  extern bool FromJSON(JSONReader& reader, JSONValue& val);
+
+  extern bool FromJSON(CBORReader& reader, bool& val);
+  extern bool FromJSON(CBORReader& reader, sint_t& val);
+  extern bool FromJSON(CBORReader& reader, uint_t& val);
+  extern bool FromJSON(CBORReader& reader, sint64_t& val);
+  extern bool FromJSON(CBORReader& reader, uint64_t& val);
+  extern bool FromJSON(CBORReader& reader, float& val);
+  extern bool FromJSON(CBORReader& reader, double& val);
+  extern bool FromJSON(CBORReader& reader, std::string& val);
+  extern bool FromJSON(CBORReader& reader, JSONValue& val);
+
   /*--------------------------------------------------------------------------------*/
   /** Templated access to member of JSON object
    */
@@ -132,6 +169,32 @@ namespace json
   // for completeness
   extern void ToJSON(const JSONValue& val, JSONValue& obj);
 
+  /*--------------------------------------------------------------------------------*/
+  /** Conversion from [possibly complex] types to streaming JSON or CBOR writer
+   *
+   * Output is the same as converting to JSONValue above
+   */
+  /*--------------------------------------------------------------------------------*/
+  extern void ToJSON(bool val, JSONWriter& writer);
+  extern void ToJSON(uint_t val, JSONWriter& writer);
+  extern void ToJSON(sint_t val, JSONWriter& writer);
+  extern void ToJSON(uint64_t val, JSONWriter& writer);
+  extern void ToJSON(sint64_t val, JSONWriter& writer);
+  extern void ToJSON(float val, JSONWriter& writer);
+  extern void ToJSON(double val, JSONWriter& writer);
+  extern void ToJSON(const std::string& val, JSONWriter& writer);
+  extern void ToJSON(const JSONValue& val, JSONWriter& writer);
+
+  extern void ToJSON(bool val, CBORWriter& writer);
+  extern void ToJSON(uint_t val, CBORWriter& writer);
+  extern void ToJSON(sint_t val, CBORWriter& writer);
+  extern void ToJSON(uint64_t val, CBORWriter& writer);
+  extern void ToJSON(sint64_t val, CBORWriter& writer);
+  extern void ToJSON(float val, CBORWriter& writer);
+  extern void ToJSON(double val, CBORWriter& writer);
+  extern void ToJSON(const std::string& val, CBORWriter& writer);
+  extern void ToJSON(const JSONValue& val, CBORWriter& writer);
+
   /*--------------------------------------------------------------------------------*/
   /** Convert from JSON text to JSON data
    */
@@ -164,12 +227,48 @@ public:
   /*--------------------------------------------------------------------------------*/
   virtual JSONValue ToJSON() const {JSONValue obj; ToJSON(obj); return obj;}
 
+  /*--------------------------------------------------------------------------------*/
+  /** Write object to streaming JSON writer
+   *
+   * The default implementation converts the object to a JSONValue first, override this
+   * to write directly to the writer
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void ToJSON(JSONWriter& writer) const {JSONValue obj; ToJSON(obj); writer.Write(obj);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Write object to streaming CBOR writer
+   *
+   * The default implementation converts the object to a JSONValue first, override this
+   * to write directly to the writer
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual void ToJSON(CBORWriter& writer) const {JSONValue obj; ToJSON(obj); writer.Write(obj);}
+
   /*--------------------------------------------------------------------------------*/
   /** Set object from JSON
    */
   /*--------------------------------------------------------------------------------*/
   virtual bool FromJSON(const JSONValue& obj) = 0;
 
+  /*--------------------------------------------------------------------------------*/
+  /** Set object from the next value of a streaming JSON reader
+   *
+   * The default implementation reads the value into a JSONValue first, override this
+   * to read directly from the reader
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(JSONReader& reader) {JSONValue obj; return (reader.ReadValue(obj) && FromJSON(obj));}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set object from the next value of a streaming CBOR reader
+   *
+   * The default implementation reads the value into a JSONValue first, override this
+   * to read directly from the reader
+   */
+  /*--------------------------------------------------------------------------------*/
+  virtual bool FromJSON(CBORReader& reader) {JSONValue obj; return (reader.ReadValue(obj) && FromJSON(obj));}
+
   /*--------------------------------------------------------------------------------*/
   /** Assignment operator
    */
@@ -186,13 +285,25 @@ public:
   /** Parse JSON string
    */
   /*--------------------------------------------------------------------------------*/
-  virtual bool FromJSONString(const std::string& str) {JSONValue obj; json::FromJSONString(str, obj); return FromJSON(obj);}
+  virtual bool FromJSONString(const std::string& str) {JSONReader reader(str); return FromJSON(reader);}
   
   /*--------------------------------------------------------------------------------*/
   /** Produce JSON string
    */
   /*--------------------------------------------------------------------------------*/
-  virtual std::string ToJSONString(bool pretty = true) const {JSONValue obj; ToJSON(obj); return json::ToJSONString(obj, pretty);}
+  virtual std::string ToJSONString(bool pretty = true) const {JSONWriter writer(pretty); ToJSON(writer); return writer.GetString();}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Set object from CBOR data
+   */
+  /*--------------------------------------------------------------------------------*/
+  bool FromCBOR(const std::vector<uint8_t>& data) {CBORReader reader(data); return FromJSON(reader);}
+
+  /*--------------------------------------------------------------------------------*/
+  /** Produce CBOR data
+   */
+  /*--------------------------------------------------------------------------------*/
+  std::vector<uint8_t> ToCBOR() const {CBORWriter writer; ToJSON(writer); return writer.GetData();}
 };
 
 namespace json
@@ -203,12 +314,26 @@ namespace json
   /*--------------------------------------------------------------------------------*/
   inline void ToJSON(const JSONSerializable& val, JSONValue& obj) {val.ToJSON(obj);}
 
+  /*--------------------------------------------------------------------------------*/
+  /** Conversion from JSONSerializable based class to streaming JSON or CBOR writer
+   */
+  /*--------------------------------------------------------------------------------*/
+  inline void ToJSON(const JSONSerializable& val, JSONWriter& writer) {val.ToJSON(writer);}
+  inline void ToJSON(const JSONSerializable& val, CBORWriter& writer) {val.ToJSON(writer);}
+
   /*--------------------------------------------------------------------------------*/
   /** Conversion from JSON to JSONSerializable based class
    */
   /*--------------------------------------------------------------------------------*/
   inline bool FromJSON(const JSONValue& obj, JSONSerializable& val) {return val.FromJSON(obj);}
 
+  /*--------------------------------------------------------------------------------*/
+  /** Conversion from streaming JSON or CBOR reader to JSONSerializable based class
+   */
+  /*--------------------------------------------------------------------------------*/
+  inline bool FromJSON(JSONReader& reader, JSONSerializable& val) {return val.FromJSON(reader);}
+  inline bool FromJSON(CBORReader& reader, JSONSerializable& val) {return val.FromJSON(reader);}
+
   /*--------------------------------------------------------------------------------*/
   /** Conversion from [possibly complex] types to JSON value with JSON return (*may* be inefficient)
    */
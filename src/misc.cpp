@@ -57,7 +57,7 @@ const char *DoubleFormatExact = "x";
 
 static ThreadLockObject& GetDebugLock()
 {
-  static ThreadLockObject _lock;
+  static ThreadLockObject _lock("DebugOutput");
   return _lock;
 }
 
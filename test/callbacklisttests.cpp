@@ -0,0 +1,138 @@
+#include <thread>
+#include <chrono>
+
+#include <catch/catch.hpp>
+
+#include "CallbackList.h"
+
+BBC_AUDIOTOOLBOX_START
+
+static void IncrementHook(void *arg)
+{
+  (*(std::atomic<uint_t> *)arg)++;
+}
+
+static void AddHook(void *arg)
+{
+  (*(std::atomic<uint_t> *)arg) += 100;
+}
+
+TEST_CASE("callbacklist")
+{
+  CallbackList list;
+  std::atomic<uint_t> count(0), count2(0);
+
+  list.Call();
+  CHECK(list.Count() == 0);
+
+  list.Add(&IncrementHook, &count);
+  list.Add(&IncrementHook, &count);
+  list.Add(&AddHook, &count2);
+  CHECK(list.Count() == 3);
+
+  list.Call();
+  CHECK(count  == 2);
+  CHECK(count2 == 100);
+
+  CHECK(list.Remove(&IncrementHook, &count));
+  CHECK(!list.Remove(&IncrementHook, &count));
+  CHECK(list.Count() == 1);
+
+  list.Call();
+  CHECK(count  == 2);
+  CHECK(count2 == 200);
+
+  list.Clear();
+  CHECK(list.Count() == 0);
+
+  SECTION("concurrent")
+  {
+    std::atomic<bool> stop(false);
+    std::atomic<uint_t> calls(0);
+    uint_t maxcalls = 0;
+    std::thread mutator([&]() {
+        uint_t i;
+        for (i = 0; i < 1000; i++)
+        {
+          list.Add(&IncrementHook, &calls);
+          list.Remove(&IncrementHook, &calls);
+        }
+        stop = true;
+      });
+
+    // list must always contain zero or one hooks
+    while (!stop)
+    {
+      list.Call();
+      maxcalls = std::max(maxcalls, (uint_t)calls);
+      calls    = 0;
+    }
+    mutator.join();
+
+    CHECK(maxcalls <= 1);
+    CHECK(list.Count() == 0);
+  }
+}
+
+static void NullHook(void *arg)
+{
+  UNUSED_PARAMETER(arg);
+}
+
+TEST_CASE("callbacklistbenchmark", "[.][benchmark]")
+{
+  const uint_t nhooks = 16, ncalls = 1000000;
+  CallbackList list;
+  CallbackHook::LIST vlist;
+  ThreadLockObject tlock;
+  std::atomic<bool> stop(false);
+  std::atomic<uint_t> mutations(0);
+  std::chrono::steady_clock::time_point start;
+  double lockedns, lockfreens;
+  uint_t i, j;
+
+  for (i = 0; i < nhooks; i++)
+  {
+    list.Add(&NullHook, NULL);
+    vlist.push_back(CallbackHook(&NullHook, NULL));
+  }
+
+  // control thread repeatedly adding and removing a hook from both lists
+  std::thread mutator([&]() {
+      while (!stop)
+      {
+        list.Add(&IncrementHook, &mutations);
+        list.Remove(&IncrementHook, &mutations);
+        {
+          ThreadLock lock(tlock);
+          vlist.push_back(CallbackHook(&IncrementHook, &mutations));
+        }
+        {
+          ThreadLock lock(tlock);
+          vlist.pop_back();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    });
+
+  // 'audio' thread firing hooks
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < ncalls; i++)
+  {
+    ThreadLock lock(tlock);
+    for (j = 0; j < vlist.size(); j++) vlist[j].Call();
+  }
+  lockedns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)ncalls;
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < ncalls; i++) list.Call();
+  lockfreens = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)ncalls;
+
+  stop = true;
+  mutator.join();
+
+  WARN("Locked vector:       " << lockedns   << "ns per Call() of " << nhooks << " hooks");
+  WARN("Lock-free list:      " << lockfreens << "ns per Call() of " << nhooks << " hooks");
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,449 @@
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+
+#include <catch/catch.hpp>
+
+#include "json.h"
+#include "CBORReader.h"
+#include "CBORWriter.h"
+#include "ParameterSet.h"
+#include "NamedParameter.h"
+
+BBC_AUDIOTOOLBOX_START
+
+/*--------------------------------------------------------------------------------*/
+/** Convert hex string to data
+ */
+/*--------------------------------------------------------------------------------*/
+static std::vector<uint8_t> FromHex(const char *str)
+{
+  std::vector<uint8_t> data;
+  uint_t val;
+
+  while (sscanf(str, "%02x", &val) == 1)
+  {
+    data.push_back((uint8_t)val);
+    str += 2;
+  }
+
+  return data;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Convert data to hex string
+ */
+/*--------------------------------------------------------------------------------*/
+static std::string ToHex(const std::vector<uint8_t>& data)
+{
+  std::string str;
+  size_t i;
+
+  for (i = 0; i < data.size(); i++) Printf(str, "%02x", (uint_t)data[i]);
+
+  return str;
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return JSON text of CBOR data
+ */
+/*--------------------------------------------------------------------------------*/
+static std::string CBORToJSONString(const std::vector<uint8_t>& data)
+{
+  CBORReader reader(data);
+  JSONValue  obj;
+
+  if (!reader.ReadValue(obj) || (reader.Next() != CBORReader::Token_End)) return "<error: " + reader.GetError() + ">";
+
+  return json::ToJSONString(obj, false);
+}
+
+TEST_CASE("cborwriter")
+{
+  CBORWriter writer;
+  uint_t i;
+
+  // examples from RFC 8949 appendix A (floats are written as 32 or 64 bits only)
+  writer.UInt(0);                          CHECK(ToHex(writer.GetData()) == "00"); writer.Reset();
+  writer.UInt(23);                         CHECK(ToHex(writer.GetData()) == "17"); writer.Reset();
+  writer.UInt(24);                         CHECK(ToHex(writer.GetData()) == "1818"); writer.Reset();
+  writer.UInt(1000);                       CHECK(ToHex(writer.GetData()) == "1903e8"); writer.Reset();
+  writer.UInt(1000000);                    CHECK(ToHex(writer.GetData()) == "1a000f4240"); writer.Reset();
+  writer.UInt(1000000000000ULL);           CHECK(ToHex(writer.GetData()) == "1b000000e8d4a51000"); writer.Reset();
+  writer.UInt(18446744073709551615ULL);    CHECK(ToHex(writer.GetData()) == "1bffffffffffffffff"); writer.Reset();
+  writer.Int(-1);                          CHECK(ToHex(writer.GetData()) == "20"); writer.Reset();
+  writer.Int(-1000);                       CHECK(ToHex(writer.GetData()) == "3903e7"); writer.Reset();
+  writer.Int(-9223372036854775807LL - 1);  CHECK(ToHex(writer.GetData()) == "3b7fffffffffffffff"); writer.Reset();
+  writer.Int(10);                          CHECK(ToHex(writer.GetData()) == "0a"); writer.Reset();
+  writer.Double(1.5);                      CHECK(ToHex(writer.GetData()) == "fa3fc00000"); writer.Reset();
+  writer.Double(100000.0);                 CHECK(ToHex(writer.GetData()) == "fa47c35000"); writer.Reset();
+  writer.Double(1.1);                      CHECK(ToHex(writer.GetData()) == "fb3ff199999999999a"); writer.Reset();
+  writer.Double(1.0e300);                  CHECK(ToHex(writer.GetData()) == "fb7e37e43c8800759c"); writer.Reset();
+  writer.Double(-4.1);                     CHECK(ToHex(writer.GetData()) == "fbc010666666666666"); writer.Reset();
+  writer.Bool(false);                      CHECK(ToHex(writer.GetData()) == "f4"); writer.Reset();
+  writer.Bool(true);                       CHECK(ToHex(writer.GetData()) == "f5"); writer.Reset();
+  writer.Null();                           CHECK(ToHex(writer.GetData()) == "f6"); writer.Reset();
+  writer.String("");                       CHECK(ToHex(writer.GetData()) == "60"); writer.Reset();
+  writer.String("IETF");                   CHECK(ToHex(writer.GetData()) == "6449455446"); writer.Reset();
+  writer.String("\xc3\xbc");               CHECK(ToHex(writer.GetData()) == "62c3bc"); writer.Reset();
+
+  writer.StartArray();
+  writer.EndArray();
+  CHECK(ToHex(writer.GetData()) == "80");
+  writer.Reset();
+
+  writer.StartObject();
+  writer.EndObject();
+  CHECK(ToHex(writer.GetData()) == "a0");
+  writer.Reset();
+
+  // {"a": 1, "b": [2, 3]}
+  writer.StartObject();
+  writer.Key("a"); writer.UInt(1);
+  writer.Key("b"); writer.StartArray(); writer.UInt(2); writer.UInt(3); writer.EndArray();
+  writer.EndObject();
+  CHECK(ToHex(writer.GetData()) == "a26161016162820203");
+  writer.Reset();
+
+  // 25 elements need a longer head which is inserted when the array ends
+  writer.StartArray();
+  for (i = 1; i <= 25; i++) writer.UInt(i);
+  writer.EndArray();
+  CHECK(ToHex(writer.GetData()) == "98190102030405060708090a0b0c0d0e0f101112131415161718181819");
+}
+
+TEST_CASE("cborreader")
+{
+  // examples from RFC 8949 appendix A (including encodings never written by CBORWriter)
+  static const struct
+  {
+    const char *hex;
+    const char *json;
+  } examples[] = {
+    {"00",                       "0\n"},
+    {"1bffffffffffffffff",       "18446744073709551615\n"},
+    {"3b7fffffffffffffff",       "-9223372036854775808\n"},
+    {"3903e7",                   "-1000\n"},
+    {"f93e00",                   "1.5\n"},
+    {"f90001",                   "5.9604644775390625e-08\n"},
+    {"f9c400",                   "-4.0\n"},
+    {"fa47c35000",               "100000.0\n"},
+    {"fb3ff199999999999a",       "1.1000000000000001\n"},
+    {"f4",                       "false\n"},
+    {"f7",                       "{}"},
+    {"c11a514b67b0",             "1363896240\n"},
+    {"6449455446",               "\"IETF\"\n"},
+    {"83010203",                 "[1,2,3]\n"},
+    {"a26161016162820203",       "{\"a\":1,\"b\":[2,3]}\n"},
+    {"9f018202039f0405ffff",     "[1,[2,3],[4,5]]\n"},
+    {"bf61610161629f0203ffff",   "{\"a\":1,\"b\":[2,3]}\n"},
+    {"bfff",                     "{}\n"},
+    {"",                         "<error: >"},
+    // invalid data
+    {"18",                       "<error: Unexpected end of data at offset 1>"},
+    {"62c3",                     "<error: Unexpected end of data at offset 1>"},
+    {"8301",                     "<error: Invalid length at offset 1>"},
+    {"0102",                     "<error: Unexpected data after value at offset 1>"},
+    {"a10102",                   "<error: Expected member name at offset 2>"},
+    {"4100",                     "<error: Byte strings not supported at offset 1>"},
+    {"7f6161ff",                 "<error: Indefinite length strings not supported at offset 1>"},
+    {"ff",                       "<error: Unexpected break at offset 1>"},
+    {"1c",                       "<error: Invalid additional information at offset 1>"},
+    {"bf6161ff",                 "<error: Missing value at offset 3>"},
+    {"9bffffffffffffffff",       "<error: Invalid length at offset 9>"},
+  };
+  uint_t i, mismatches = 0;
+
+  for (i = 0; i < NUMBEROF(examples); i++)
+  {
+    std::string str = CBORToJSONString(FromHex(examples[i].hex));
+
+    if (str != examples[i].json)
+    {
+      WARN("CBOR '" << examples[i].hex << "': expected '" << examples[i].json << "' found '" << str << "'");
+      mismatches++;
+    }
+  }
+  CHECK(mismatches == 0);
+
+  // integers are only integers if they were written as integers
+  std::vector<uint8_t> data = FromHex("83fa40000000183b3903e7");
+  CBORReader reader(data);
+  sllong_t   sval = 0;
+  ullong_t   uval = 0;
+
+  CHECK(reader.Next() == CBORReader::Token_ArrayStart);
+  CHECK(reader.Next() == CBORReader::Token_Number);
+  CHECK(reader.GetDouble() == 2.0);
+  CHECK(reader.IsInteger() == false);
+  CHECK(reader.GetInteger(sval) == false);
+  CHECK(reader.Next() == CBORReader::Token_Number);
+  CHECK(reader.GetInteger(uval) == true);
+  CHECK(uval == 59);
+  CHECK(reader.Next() == CBORReader::Token_Number);
+  CHECK(reader.GetInteger(uval) == false);
+  CHECK(reader.GetInteger(sval) == true);
+  CHECK(sval == -1000);
+  CHECK(reader.Next() == CBORReader::Token_ArrayEnd);
+  CHECK(reader.Next() == CBORReader::Token_End);
+}
+
+TEST_CASE("cbordepth")
+{
+  std::vector<uint8_t> data;
+  uint_t i;
+
+  // nesting up to the limit is allowed
+  data.assign(CBORReader::MaxDepth, 0x81);
+  data.push_back(0x00);
+  CBORReader reader1(data);
+  CHECK(reader1.SkipValue() == true);
+  CHECK(reader1.Next() == CBORReader::Token_End);
+
+  // a megabyte of one-element arrays (or maps) is an error rather than a stack overflow
+  data.assign(1000000, 0x81);
+  CHECK(CBORToJSONString(data) == "<error: Nesting too deep at offset " + StringFrom((uint_t)CBORReader::MaxDepth + 1) + ">");
+
+  ParameterSet parameters;
+  data.clear();
+  for (i = 0; i < 1000000; i++)
+  {
+    data.push_back(0xa1);
+    data.push_back(0x61);
+    data.push_back('a');
+  }
+  CHECK(parameters.FromCBOR(data) == false);
+}
+
+TEST_CASE("cborjson")
+{
+  JSONValue  obj;
+  CBORWriter writer;
+  uint_t     i;
+
+  obj["int"]     = (Json::Int64)-10000000000LL;
+  obj["uint"]    = (Json::UInt64)18446744073709551615ULL;
+  obj["zero"]    = 0;
+  obj["true"]    = true;
+  obj["null"]    = JSONValue();
+  obj["string"]  = std::string("\"\\\x01\xc3\xa9\0x", 7);
+  obj["emptyobj"] = JSONValue(Json::objectValue);
+  obj["emptyarr"] = JSONValue(Json::arrayValue);
+  obj["nested"]["a"]["b"]["c"] = "deep";
+  obj["nested"]["arr"][0] = 1;
+  obj["nested"]["arr"][1]["x"] = 1.5;
+  obj["nested"]["arr"][2][0] = "y";
+
+  static const double reals[] = {0.0, -0.0, 1.0, -2.0, 0.1, 3.4, 1.0 / 3.0, 1e300, -1e-300, 4.9e-324, (double)3.4f, 16777217.0};
+  for (i = 0; i < NUMBEROF(reals); i++) obj["reals"][i] = reals[i];
+  for (i = 0; i < 300; i++) obj["long"][i] = i * 1000;
+
+  // JSON -> CBOR -> JSON is lossless
+  writer.Write(obj);
+  CHECK(CBORToJSONString(writer.GetData()) == json::ToJSONString(obj, false));
+
+  // ...and reals are bit exact
+  CBORReader reader(writer.GetData());
+  JSONValue  obj2;
+  uint_t     mismatches = 0;
+
+  REQUIRE(reader.ReadValue(obj2));
+  for (i = 0; i < NUMBEROF(reals); i++)
+  {
+    double val = obj2["reals"][i].asDouble();
+    mismatches += ((memcmp(&val, &reals[i], sizeof(val)) != 0) || !obj2["reals"][i].isDouble());
+  }
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("cborobjects")
+{
+  NAMEDPARAMETER(sint_t, count);
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(std::string, label);
+  NAMEDPARAMETER(Position, position);
+  NAMEDPARAMETER(Quaternion, rotation);
+  NAMEDPARAMETERDEF(bool, enabled, true);
+  INamedParameter *list[] = {&rotation, &label, &count, &position, &enabled, &gain};
+  ParameterSet parameters1, parameters2;
+  Position     pos1(1.0 / 3.0, -2.5, 0.1), pos2, pos3 = Position(30.0, 10.0, 2.0).Polar(), pos4;
+  Quaternion   rot1(0.5, 0.5, -0.5, 1.0 / 7.0), rot2;
+  CBORWriter   writer;
+  JSONWriter   jsonwriter(false);
+
+  // same member names as JSON
+  pos1.ToJSON(writer);
+  CHECK(CBORToJSONString(writer.GetData()) == pos1.ToJSONString(false));
+  writer.Reset();
+  rot1.ToJSON(writer);
+  CHECK(CBORToJSONString(writer.GetData()) == rot1.ToJSONString(false));
+
+  // exact round trips
+  CHECK(pos2.FromCBOR(pos1.ToCBOR()) == true);
+  CHECK(pos2 == pos1);
+  CHECK(pos2.pos.x == pos1.pos.x);
+  CHECK(pos4.FromCBOR(pos3.ToCBOR()) == true);
+  CHECK(pos4.polar == true);
+  CHECK(pos4.pos.az == pos3.pos.az);
+  CHECK(pos4.pos.el == pos3.pos.el);
+  CHECK(pos4.pos.d  == pos3.pos.d);
+  CHECK(rot2.FromCBOR(rot1.ToCBOR()) == true);
+  CHECK(rot2.w == rot1.w);
+  CHECK(rot2.z == rot1.z);
+
+  // parameters are written with their native types
+  parameters1.Set("a", 1);
+  parameters1.Set("b", -2);
+  parameters1.Set("c", 1.0 / 3.0);
+  parameters1.Set("d", (sint64_t)-10000000000LL);
+  parameters1.Set("e", (uint64_t)18446744073709551615ULL);
+  parameters1.Set("f", "text");
+  parameters1.Set("g", true);
+  parameters1.Set("h", 2.0);
+  parameters1.Set("i.x", 1.5);
+  parameters1.Set("i.y.z", "deep");
+  parameters1.Set("j", "value");
+  parameters1.Set("j.hidden", 1);
+  CHECK(parameters2.FromCBOR(parameters1.ToCBOR()) == true);
+  CHECK(parameters2.GetCount() == 11);
+  parameters1.Delete("j.hidden");
+  CHECK(parameters2 == parameters1);
+  CHECK(parameters2.ToJSONString() == parameters1.ToJSONString());
+  CHECK(parameters2.GetValue("b")->GetType() == ParameterValue::Type_Int);
+  CHECK(parameters2.GetValue("c")->GetType() == ParameterValue::Type_Double);
+  CHECK(parameters2.GetValue("g")->GetType() == ParameterValue::Type_Bool);
+  CHECK(parameters2.GetValue("h")->GetType() == ParameterValue::Type_Double);
+  CHECK(parameters2.GetValue("e")->GetType() == ParameterValue::Type_UInt);
+
+  // parameters read from JSON survive a trip through CBOR
+  ParameterSet parameters3, parameters4;
+  CHECK(parameters3.FromJSONString(parameters1.ToJSONString()) == true);
+  CHECK(parameters4.FromCBOR(parameters3.ToCBOR()) == true);
+  CHECK(parameters4.ToJSONString() == parameters1.ToJSONString());
+
+  // NamedParameter lists
+  count = -7;
+  gain = 0.1;
+  label = "violin";
+  position = pos1;
+  rotation = rot1;
+  enabled = false;
+  writer.Reset();
+  json::ToJSON(list, NUMBEROF(list), writer);
+  json::ToJSON(list, NUMBEROF(list), jsonwriter);
+  CHECK(CBORToJSONString(writer.GetData()) == jsonwriter.GetString());
+  CHECK(writer.GetData().size() < jsonwriter.GetString().length());
+
+  count.Reset();
+  gain.Reset();
+  label.Reset();
+  position.Reset();
+  rotation.Reset();
+  enabled.Reset();
+  CBORReader reader(writer.GetData());
+  CHECK(json::FromJSON(reader, list, NUMBEROF(list)) == true);
+  CHECK(count == -7);
+  CHECK(gain == 0.1);
+  CHECK(label == "violin");
+  CHECK(position.Get() == pos1);
+  CHECK(rotation.Get().w == rot1.w);
+  CHECK(enabled == false);
+  CHECK(enabled.IsSet() == true);
+}
+
+TEST_CASE("cborbenchmark", "[.][benchmark]")
+{
+  NAMEDPARAMETER(std::string, name);
+  NAMEDPARAMETER(uint_t, channel);
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(bool, muted);
+  NAMEDPARAMETER(Position, position);
+  NAMEDPARAMETER(Quaternion, rotation);
+  INamedParameter *list[] = {&name, &channel, &gain, &muted, &position, &rotation};
+  const uint_t objects = 100, iterations = 200;
+  std::vector<ParameterSet> sets(objects);
+  std::chrono::steady_clock::time_point start;
+  JSONWriter jsonwriter(false);
+  CBORWriter writer;
+  std::string jsonstr;
+  std::vector<uint8_t> data;
+  uint_t i, j, count = 0;
+  double ns;
+
+  name = "object";
+  channel = 3;
+  muted = true;
+  rotation = Quaternion(1, 0, 0, 0);
+  for (i = 0; i < objects; i++)
+  {
+    sets[i].Set("name", "object").Set("channel", i).Set("gain", 1.0 / (double)(i + 1));
+    sets[i].Set("position.x", (double)i * 0.5).Set("position.y", (double)i * -0.25).Set("position.z", 1.5);
+  }
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < objects; j++)
+    {
+      gain = 1.0 / (double)(j + 1);
+      position = Position((double)j * 0.5, (double)j * -0.25, 1.5);
+      jsonwriter.Reset();
+      json::ToJSON((const INamedParameter * const *)list, NUMBEROF(list), jsonwriter);
+      JSONReader reader(jsonwriter.GetString());
+      count += json::FromJSON(reader, list, NUMBEROF(list));
+    }
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("NamedParameters to and from JSON text: " << ns << "ns per object (" << jsonwriter.GetString().length() << " bytes)");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < objects; j++)
+    {
+      gain = 1.0 / (double)(j + 1);
+      position = Position((double)j * 0.5, (double)j * -0.25, 1.5);
+      writer.Reset();
+      json::ToJSON((const INamedParameter * const *)list, NUMBEROF(list), writer);
+      CBORReader reader(writer.GetData());
+      count += json::FromJSON(reader, list, NUMBEROF(list));
+    }
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("NamedParameters to and from CBOR: " << ns << "ns per object (" << writer.GetData().size() << " bytes)");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < objects; j++)
+    {
+      ParameterSet parameters;
+      jsonwriter.Reset();
+      sets[j].ToJSON(jsonwriter);
+      JSONReader reader(jsonwriter.GetString());
+      count += parameters.FromJSON(reader);
+    }
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("ParameterSet to and from JSON text: " << ns << "ns per object (" << jsonwriter.GetString().length() << " bytes)");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < objects; j++)
+    {
+      ParameterSet parameters;
+      writer.Reset();
+      sets[j].ToJSON(writer);
+      CBORReader reader(writer.GetData());
+      count += parameters.FromJSON(reader);
+    }
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("ParameterSet to and from CBOR: " << ns << "ns per object (" << writer.GetData().size() << " bytes)");
+
+  CHECK(count == 4 * iterations * objects);
+}
+
+BBC_AUDIOTOOLBOX_END
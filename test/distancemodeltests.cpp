@@ -0,0 +1,161 @@
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include <catch/catch.hpp>
+
+#include "DistanceModel.h"
+#include "PositionBatch.h"
+
+BBC_AUDIOTOOLBOX_START
+
+TEST_CASE("distancemodel")
+{
+  DistanceModel& model = DistanceModel::Get();
+  std::mt19937 rng(10);
+  std::uniform_real_distribution<double> coord(-20.0, 20.0);
+  const uint_t n = 1000;
+  std::vector<Position> positions(n);
+  std::vector<double> d(n), level(n), delay(n);
+  double maxexp2err = 0.0, maxtableerr = 0.0, maxdelayerr = 0.0;
+  uint_t i, mismatches = 0;
+
+  for (i = 0; i < n; i++)
+  {
+    positions[i] = Position(coord(rng), coord(rng), coord(rng));
+    if (i & 1) positions[i] = positions[i].Polar();
+    d[i] = positions[i].Polar().pos.d;
+
+    // distance without polar conversion must be identical
+    mismatches += (DistanceModel::GetDistance(positions[i]) != d[i]);
+  }
+  d[0] = 0.0;
+
+  model.SetLevelMode(DistanceModel::LevelMode_Exact);
+  model.GetLevelsAndDelays(&d[0], &level[0], &delay[0], n, 48000.0);
+  for (i = 0; i < n; i++)
+  {
+    mismatches += (level[i] != model.GetLevel(d[i]));
+    mismatches += (delay[i] != model.GetDelay(d[i], 48000.0));
+    maxdelayerr = std::max(maxdelayerr, fabs(delay[i] - 48000.0 * d[i] / 340.0));
+  }
+
+  model.SetLevelMode(DistanceModel::LevelMode_Exp2);
+  model.GetLevels(&d[0], &level[0], n);
+  for (i = 0; i < n; i++) maxexp2err = std::max(maxexp2err, fabs(level[i] / model.GetLevel(d[i]) - 1.0));
+
+  model.SetLevelMode(DistanceModel::LevelMode_Table);
+  model.GetLevels(&d[0], &level[0], n);
+  for (i = 0; i < n; i++) maxtableerr = std::max(maxtableerr, fabs(level[i] / model.GetLevel(d[i]) - 1.0));
+
+  // batch of positions uses the same distances (polar batch so that distances are not recalculated)
+  PositionBatch batch(positions, true);
+  std::vector<double> level2(n), delay2(n);
+  d[0] = DistanceModel::GetDistance(positions[0]);
+  model.GetLevelsAndDelays(&d[0], &level[0], &delay[0], n, 48000.0);
+  model.GetLevelsAndDelays(batch, &level2[0], NULL);
+  for (i = 0; i < n; i++) mismatches += (level[i] != level2[i]);
+  model.GetLevelsAndDelays(batch, NULL, &delay2[0], 48000.0);
+  for (i = 0; i < n; i++) mismatches += (delay[i] != delay2[i]);
+  level2.assign(n, 0.0);
+  delay2.assign(n, 0.0);
+  model.GetLevelsAndDelays(batch, &level2[0], &delay2[0], 48000.0);
+  for (i = 0; i < n; i++) mismatches += (level[i] != level2[i]) + (delay[i] != delay2[i]);
+
+  model.SetLevelMode(DistanceModel::LevelMode_Exact);
+
+  CHECK(mismatches == 0);
+  CHECK(maxdelayerr < 1.0e-9);
+  CHECK(maxexp2err < 1.0e-13);
+  CHECK(maxtableerr < 1.0e-7);
+}
+
+TEST_CASE("distancemodelinstances")
+{
+  DistanceModel model1, model2(1.5, 0.0);
+  DistanceModel::PARAMETERS params;
+
+  // instances are independent of each other and the default model
+  model1.SetDecayPower(3.0);
+  model1.SetLevelMode(DistanceModel::LevelMode_Exp2);
+  CHECK(DistanceModel::Get().GetDecayPower() == 2.0);
+  CHECK(DistanceModel::Get().GetLevelMode() == DistanceModel::LevelMode_Exact);
+  CHECK(model1.GetLevel(2.0) == Approx(1.0 / 9.0));
+  CHECK(model2.GetLevel(2.0) == Approx(1.0 / 2.25));
+  CHECK(model2.GetDelay(10.0) == 0.0);
+
+  // copies take all parameters
+  DistanceModel model3(model1);
+  params = model3.GetParameters();
+  CHECK(params.decaypower == 3.0);
+  CHECK(params.log2decaypower == log2(3.0));
+  CHECK(params.invspeedofsound == 1.0 / 340.0);
+  CHECK(params.levelmode == DistanceModel::LevelMode_Exp2);
+
+  model3 = model2;
+  CHECK(model3.GetSpeedOfSound() == 0.0);
+
+  // snapshots must always be consistent whilst another thread is updating the model
+  std::atomic<bool> quit(false);
+  std::thread writer([&]() {
+      uint_t i;
+      for (i = 0; !quit; i++)
+      {
+        model1.SetDecayPower((double)(1 + (i & 7)));
+        model1.SetSpeedOfSound((double)(100 + (i & 7)));
+      }
+    });
+  uint_t i, inconsistent = 0;
+
+  for (i = 0; i < 100000; i++)
+  {
+    model1.GetParameters(params);
+    inconsistent += ((params.log2decaypower != log2(params.decaypower)) ||
+                     (params.invspeedofsound != 1.0 / params.speedofsound));
+  }
+  quit = true;
+  writer.join();
+
+  CHECK(inconsistent == 0);
+}
+
+TEST_CASE("distancemodelbenchmark", "[.][benchmark]")
+{
+  DistanceModel model;
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<double> dist(0.0, 20.0);
+  const uint_t n = 4096, iterations = 200;
+  std::vector<double> d(n), level(n), delay(n);
+  std::chrono::steady_clock::time_point start;
+  double ns;
+  uint_t i, j;
+
+  for (i = 0; i < n; i++) d[i] = dist(rng);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) model.GetLevelAndDelay(d[j], level[j], delay[j]);
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+  WARN("Per-distance GetLevelAndDelay(): " << ns << "ns per distance");
+
+  static const struct {
+    DistanceModel::LEVELMODE mode;
+    const char *name;
+  } modes[] = {
+    {DistanceModel::LevelMode_Exact, "exact"},
+    {DistanceModel::LevelMode_Exp2,  "exp2"},
+    {DistanceModel::LevelMode_Table, "table"},
+  };
+  for (i = 0; i < NUMBEROF(modes); i++)
+  {
+    model.SetLevelMode(modes[i].mode);
+    start = std::chrono::steady_clock::now();
+    for (j = 0; j < iterations; j++) model.GetLevelsAndDelays(&d[0], &level[0], &delay[0], n);
+    ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+    WARN("GetLevelsAndDelays() (" << modes[i].name << "): " << ns << "ns per distance");
+  }
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,223 @@
+#include <chrono>
+#include <random>
+
+#include <catch/catch.hpp>
+
+#include "FastTrig.h"
+#include "PositionBatch.h"
+
+BBC_AUDIOTOOLBOX_START
+
+TEST_CASE("fasttrig")
+{
+  std::mt19937 rng(4);
+  std::uniform_real_distribution<double> angle(-1.0e4, 1.0e4), coord(-1.0, 1.0), unit(-1.0, 1.0);
+  const uint_t n = 100000;
+  std::vector<double> x(n), y(n), s(n), c(n), res(n);
+  double maxsin = 0.0, maxcos = 0.0, maxatan2 = 0.0, maxasin = 0.0;
+  uint_t i, mismatches = 0;
+
+  // sin/cos
+  for (i = 0; i < n; i++) x[i] = (i & 1) ? angle(rng) : 4.0 * coord(rng);
+  FastSinCos(&x[0], &s[0], &c[0], n);
+  for (i = 0; i < n; i++)
+  {
+    maxsin = std::max(maxsin, fabs(s[i] - sin(x[i])));
+    maxcos = std::max(maxcos, fabs(c[i] - cos(x[i])));
+    mismatches += ((s[i] != FastSin(x[i])) || (c[i] != FastCos(x[i])));
+  }
+  CHECK(maxsin < 4.0e-7);
+  CHECK(maxcos < 4.0e-7);
+
+  // atan2
+  for (i = 0; i < n; i++)
+  {
+    x[i] = coord(rng);
+    y[i] = coord(rng);
+  }
+  FastAtan2(&y[0], &x[0], &res[0], n);
+  for (i = 0; i < n; i++)
+  {
+    maxatan2 = std::max(maxatan2, fabs(res[i] - atan2(y[i], x[i])));
+    mismatches += (res[i] != FastAtan2(y[i], x[i]));
+  }
+  CHECK(maxatan2 < 5.0e-8);
+  CHECK(FastAtan2(0.0, 0.0) == 0.0);
+  CHECK(FastAtan2(-0.0, -1.0) == Approx(-M_PI));
+  CHECK(FastAtan2(1.0, 0.0) == Approx(0.5 * M_PI));
+
+  // asin, including end points
+  for (i = 0; i < n; i++) x[i] = unit(rng);
+  x[0] = 1.0; x[1] = -1.0; x[2] = 0.0;
+  FastAsin(&x[0], &res[0], n);
+  for (i = 0; i < n; i++)
+  {
+    maxasin = std::max(maxasin, fabs(res[i] - asin(x[i])));
+    mismatches += (res[i] != FastAsin(x[i]));
+  }
+  CHECK(maxasin < 5.0e-8);
+
+  // batch and scalar versions must be identical
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("fasttrigpositionbatch")
+{
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<double> coord(-10.0, 10.0);
+  std::vector<Position> positions(1000);
+  uint_t i, errors = 0;
+
+  for (i = 0; i < positions.size(); i++) positions[i] = Position(coord(rng), coord(rng), coord(rng));
+  positions[0] = Position();
+  positions[1] = Position(0.0, -1.0, 0.0);
+
+  PositionBatch batch(positions);
+  batch.ToPolar(true);
+  for (i = 0; i < positions.size(); i++)
+  {
+    Position pos1 = batch.Get(i), pos2 = positions[i].Polar();
+    errors += ((fabs(pos1.pos.az - pos2.pos.az) > 1.0e-5) ||
+               (fabs(pos1.pos.el - pos2.pos.el) > 1.0e-5) ||
+               (pos1.pos.d != pos2.pos.d));
+  }
+
+  batch.ToCart(true);
+  for (i = 0; i < positions.size(); i++) errors += ((batch.Get(i) - positions[i]).Mod() > 1.0e-5);
+
+  CHECK(errors == 0);
+}
+
+TEST_CASE("fasttrigposition")
+{
+  std::mt19937 rng(6);
+  std::uniform_real_distribution<double> coord(-10.0, 10.0);
+  std::vector<Position> positions(1000);
+  uint_t i, errors = 0, mismatches = 0;
+
+  for (i = 0; i < positions.size(); i++) positions[i] = Position(coord(rng), coord(rng), coord(rng));
+  positions[0] = Position();
+  positions[1] = Position(0.0, -1.0, 0.0);
+  positions[2] = Position(0.0, 0.0, 2.0);
+
+  PositionBatch batch(positions);
+  batch.ToPolar(true);
+  for (i = 0; i < positions.size(); i++)
+  {
+    Position pos1 = positions[i].Polar(true), pos2 = positions[i].Polar();
+
+    errors += (!pos1.polar ||
+               (fabs(pos1.pos.az - pos2.pos.az) > 1.0e-5) ||
+               (fabs(pos1.pos.el - pos2.pos.el) > 1.0e-5) ||
+               (pos1.pos.d != pos2.pos.d));
+    errors += ((pos1.Cart(true) - positions[i]).Mod() > 1.0e-5);
+    errors += ((pos2.Cart(true) - pos2.Cart()).Mod() > 1.0e-5);
+
+    // scalar and batch versions must be identical
+    Position pos3 = batch.Get(i);
+    mismatches += ((pos1.pos.az != pos3.pos.az) || (pos1.pos.el != pos3.pos.el) || (pos1.pos.d != pos3.pos.d));
+  }
+
+  batch.ToCart(true);
+  for (i = 0; i < positions.size(); i++)
+  {
+    Position pos1 = positions[i].Polar(true).Cart(true), pos2 = batch.Get(i);
+    mismatches += ((pos1.pos.x != pos2.pos.x) || (pos1.pos.y != pos2.pos.y) || (pos1.pos.z != pos2.pos.z));
+  }
+
+  // already in the requested co-ordinates: unchanged
+  errors += (positions[3].Cart(true).pos.x != positions[3].pos.x);
+
+  CHECK(errors == 0);
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("fasttrigbenchmark", "[.][benchmark]")
+{
+  const uint_t n = 4096, iterations = 500;
+  std::vector<double> x(n), y(n), s(n), c(n);
+  std::chrono::steady_clock::time_point start;
+  double libmns, fastns;
+  uint_t i, j;
+
+  for (i = 0; i < n; i++)
+  {
+    x[i] = 2.0 * M_PI * (double)i / (double)n - M_PI;
+    y[i] = sin(x[i]);
+  }
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++)
+    {
+      s[j] = sin(x[j]);
+      c[j] = cos(x[j]);
+    }
+  }
+  libmns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++) FastSinCos(&x[0], &s[0], &c[0], n);
+  fastns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  WARN("sin+cos: libm " << libmns << "ns, fast " << fastns << "ns (max error 4e-7)");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) s[j] = atan2(y[j], x[j]);
+  }
+  libmns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++) FastAtan2(&y[0], &x[0], &s[0], n);
+  fastns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  WARN("atan2: libm " << libmns << "ns, fast " << fastns << "ns (max error 5e-8)");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) s[j] = asin(y[j]);
+  }
+  libmns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++) FastAsin(&y[0], &s[0], n);
+  fastns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  WARN("asin: libm " << libmns << "ns, fast " << fastns << "ns (max error 5e-8)");
+
+  std::vector<Position> positions(n);
+  for (i = 0; i < n; i++) positions[i] = Position(x[i], y[i], 0.5);
+
+  PositionBatch batch(positions);
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++) {batch.ToPolar(false); batch.ToCart(false);}
+  libmns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++) {batch.ToPolar(true); batch.ToCart(true);}
+  fastns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  WARN("PositionBatch cart->polar->cart: libm " << libmns << "ns, fast " << fastns << "ns per position");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) positions[j] = positions[j].Polar(false).Cart(false);
+  }
+  libmns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) positions[j] = positions[j].Polar(true).Cart(true);
+  }
+  fastns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  WARN("Position cart->polar->cart: libm " << libmns << "ns, fast " << fastns << "ns per position");
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -1,6 +1,12 @@
+#include <chrono>
+
 #include <catch/catch.hpp>
 
 #include "json.h"
+#include "JSONReader.h"
+#include "JSONWriter.h"
+#include "ParameterSet.h"
+#include "NamedParameter.h"
 
 BBC_AUDIOTOOLBOX_START
 
@@ -200,4 +206,633 @@ TEST_CASE("fromjson")
   CHECK(str == "aaa");
 }
 
+TEST_CASE("jsonreader")
+{
+  const char *jsonstr = ("// comment\n"
+                         "{\"a\" : [1, -2.5e1, true, false, null, [], {}],\n"
+                         " /* comment */ \"b\":{\"c\":\"esc\\\"\\\\\\/\\b\\f\\n\\r\\t\\u0041\\u00e9\\u20ac\\ud83d\\ude00\"}}");
+  static const JSONReader::TOKEN expected[] = {
+    JSONReader::Token_ObjectStart,
+    JSONReader::Token_Key,
+    JSONReader::Token_ArrayStart,
+    JSONReader::Token_Number,
+    JSONReader::Token_Number,
+    JSONReader::Token_Bool,
+    JSONReader::Token_Bool,
+    JSONReader::Token_Null,
+    JSONReader::Token_ArrayStart,
+    JSONReader::Token_ArrayEnd,
+    JSONReader::Token_ObjectStart,
+    JSONReader::Token_ObjectEnd,
+    JSONReader::Token_ArrayEnd,
+    JSONReader::Token_Key,
+    JSONReader::Token_ObjectStart,
+    JSONReader::Token_Key,
+    JSONReader::Token_String,
+    JSONReader::Token_ObjectEnd,
+    JSONReader::Token_ObjectEnd,
+    JSONReader::Token_End,
+  };
+  JSONReader reader(jsonstr, strlen(jsonstr));
+  uint_t i, mismatches = 0;
+
+  for (i = 0; i < NUMBEROF(expected); i++)
+  {
+    JSONReader::TOKEN token = reader.Next();
+
+    mismatches += (token != expected[i]);
+    if ((i == 3) || (i == 4)) CHECK(reader.GetDouble() == ((i == 3) ? 1.0 : -25.0));
+    if (i == 5) CHECK(reader.GetBool() == true);
+    if (i == 15) CHECK(reader.GetKey() == "c");
+  }
+  CHECK(mismatches == 0);
+  CHECK(reader.GetString() == "esc\"\\/\b\f\n\r\tA\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80");
+
+  // skipping
+  JSONReader reader2(jsonstr, strlen(jsonstr));
+  CHECK(reader2.Next() == JSONReader::Token_ObjectStart);
+  CHECK(reader2.Next() == JSONReader::Token_Key);
+  CHECK(reader2.SkipValue() == true);
+  CHECK(reader2.Next() == JSONReader::Token_Key);
+  CHECK(reader2.GetKey() == "b");
+  CHECK(reader2.SkipValue() == true);
+  CHECK(reader2.Next() == JSONReader::Token_ObjectEnd);
+  CHECK(reader2.Next() == JSONReader::Token_End);
+
+  // integers
+  static const struct {
+    const char *str;
+    bool     sok;
+    sllong_t sval;
+    bool     uok;
+    ullong_t uval;
+  } integers[] = {
+    {"0",                     true,  0,                         true,  0},
+    {"-0",                    true,  0,                         true,  0},
+    {"2.0",                   true,  2,                         true,  2},
+    {"2.5",                   false, 0,                         false, 0},
+    {"-3",                    true,  -3,                        false, 0},
+    {"9223372036854775807",   true,  9223372036854775807LL,     true,  9223372036854775807ULL},
+    {"-9223372036854775808",  true,  (sllong_t)(1ULL << 63),    false, 0},
+    {"18446744073709551615",  false, 0,                         true,  18446744073709551615ULL},
+    {"18446744073709551616",  false, 0,                         false, 0},
+    {"1e3",                   true,  1000,                      true,  1000},
+  };
+  for (i = mismatches = 0; i < NUMBEROF(integers); i++)
+  {
+    JSONReader reader3(integers[i].str);
+    sllong_t sval = 0;
+    ullong_t uval = 0;
+
+    mismatches += (reader3.Next() != JSONReader::Token_Number);
+    mismatches += (reader3.GetInteger(sval) != integers[i].sok) || (integers[i].sok && (sval != integers[i].sval));
+    mismatches += (reader3.GetInteger(uval) != integers[i].uok) || (integers[i].uok && (uval != integers[i].uval));
+  }
+  CHECK(mismatches == 0);
+
+  // syntax errors
+  static const char *errors[] = {
+    "{",
+    "{\"a\"}",
+    "{\"a\":}",
+    "{\"a\":1,}",
+    "{a:1}",
+    "[1 2]",
+    "[1,]",
+    "\"abc",
+    "\"\\x\"",
+    "\"\\ud83d\"",
+    "tru",
+    "-",
+    "1e",
+    "{} {}",
+    "]",
+  };
+  for (i = mismatches = 0; i < NUMBEROF(errors); i++)
+  {
+    JSONReader reader4(errors[i]);
+    JSONReader::TOKEN token;
+
+    while (((token = reader4.Next()) != JSONReader::Token_Error) && (token != JSONReader::Token_End)) ;
+    mismatches += ((token != JSONReader::Token_Error) || reader4.GetError().empty());
+  }
+  CHECK(mismatches == 0);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Compare conversion of a value using jsoncpp and the streaming reader
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename T>
+static bool CompareConversion(const char *str, const T& initial)
+{
+  JSONValue  obj;
+  JSONReader reader(str);
+  T val1 = initial, val2 = initial;
+  bool res1, res2;
+
+  json::FromJSONString(str, obj);
+  res1 = json::FromJSON(obj, val1);
+  res2 = json::FromJSON(reader, val2);
+
+  return ((res1 == res2) && (val1 == val2) && reader.Skip());
+}
+
+TEST_CASE("jsonreaderconversions")
+{
+  static const char *values[] = {
+    "1", "-2", "3.4", "-3.4", "-10000000000", "10000000000", "\"aaa\"", "null", "true", "false",
+    "2.0", "-0", "-0.5", "1e30", "-1e30", "4294967295", "4294967296", "-2147483648", "-2147483649",
+    "9223372036854775807", "9223372036854775808", "18446744073709551615",
+    "[1,2]", "{\"a\":1}",
+  };
+  uint_t i, mismatches = 0;
+
+  for (i = 0; i < NUMBEROF(values); i++)
+  {
+    const char *str = values[i];
+    uint_t n = mismatches;
+
+    mismatches += !CompareConversion(str, (bool)true);
+    mismatches += !CompareConversion(str, (sint_t)7);
+    mismatches += !CompareConversion(str, (uint_t)7);
+    mismatches += !CompareConversion(str, (sint64_t)7);
+    // jsoncpp throws converting reals that are too big for uint64_t
+    if ((strcmp(str, "1e30") != 0) && (strcmp(str, "[1,2]") != 0)) mismatches += !CompareConversion(str, (uint64_t)7);
+    mismatches += !CompareConversion(str, (float)7.f);
+    mismatches += !CompareConversion(str, (double)7.0);
+    mismatches += !CompareConversion(str, std::string("<unused>"));
+    if (mismatches != n) WARN("Conversion mismatch for '" << str << "'");
+  }
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("jsonreaderparameterset")
+{
+  const char *jsonstr = ("{"
+                         "\"a\":1,"
+                         "\"b\":-2,"
+                         "\"c\":3.4,"
+                         "\"d\":-10000000000,"
+                         "\"e\":10000000000,"
+                         "\"f\":\"aaa\","
+                         "\"g\":true,"
+                         "\"h\":null,"
+                         "\"i\":2.0,"
+                         "\"j\":1e30,"
+                         "\"k\":{\"x\":1.5,\"y\":{\"z\":\"deep\"},\"empty\":{}},"
+                         "\"l\":18446744073709551615"
+                         "}");
+  ParameterSet parameters1, parameters2;
+  JSONValue    obj;
+  JSONReader   reader(jsonstr);
+  ParameterSet::Iterator it;
+  uint_t mismatches = 0;
+  double dval = 0.0;
+
+  REQUIRE(json::FromJSONString(jsonstr, obj) == true);
+  CHECK(parameters1.FromJSON(obj) == true);
+  CHECK(parameters2.FromJSON(reader) == true);
+
+  // same values with the same native types
+  CHECK(parameters1 == parameters2);
+  CHECK(parameters1.GetCount() == 13);
+  for (it = parameters1.GetBegin(); it != parameters1.GetEnd(); ++it)
+  {
+    const ParameterValue *value = parameters2.GetValue(it.GetName());
+    mismatches += (!value || (value->GetType() != it.GetValue().GetType()));
+  }
+  CHECK(mismatches == 0);
+
+  CHECK(parameters2.Get("c", dval));
+  CHECK(dval == 3.4);
+  CHECK(parameters2.GetValue("g")->GetType() == ParameterValue::Type_Bool);
+  CHECK(parameters2.GetValue("i")->GetType() == ParameterValue::Type_UInt);
+  CHECK(parameters2.GetValue("j")->GetType() == ParameterValue::Type_Double);
+  CHECK(parameters2.Raw("k.y.z") == "deep");
+
+  // JSONSerializable::FromJSONString() uses the streaming reader
+  ParameterSet parameters3;
+  CHECK(parameters3.FromJSONString(jsonstr) == true);
+  CHECK(parameters3 == parameters1);
+
+  // round trip
+  ParameterSet parameters4;
+  CHECK(parameters4.FromJSONString(parameters2.ToJSONString()) == true);
+  CHECK(parameters4.ToString() == parameters2.ToString());
+
+  // not an object
+  ParameterSet parameters5;
+  CHECK(parameters5.FromJSONString("[1,2]") == false);
+  CHECK(parameters5.FromJSONString("{\"a\":") == false);
+}
+
+TEST_CASE("jsonreaderdepth")
+{
+  std::string deep, limit;
+  uint_t i;
+
+  // nesting up to the limit is allowed
+  for (i = 0; i < JSONReader::MaxDepth; i++) limit += "[";
+  for (i = 0; i < JSONReader::MaxDepth; i++) limit += "]";
+  JSONReader reader1(limit);
+  CHECK(reader1.SkipValue() == true);
+  CHECK(reader1.Next() == JSONReader::Token_End);
+
+  // deeper nesting is an error rather than a stack overflow in recursive readers
+  for (i = 0; i < 1000000; i++) deep += "[";
+  JSONReader reader2(deep);
+  JSONValue  obj;
+  CHECK(reader2.ReadValue(obj) == false);
+  CHECK(reader2.GetError() == "Nesting too deep at offset " + StringFrom((uint_t)JSONReader::MaxDepth));
+
+  deep.clear();
+  for (i = 0; i < 1000000; i++) deep += "{\"a\":";
+  ParameterSet parameters;
+  CHECK(parameters.FromJSONString(deep) == false);
+}
+
+TEST_CASE("jsonreadernamedparameters")
+{
+  NAMEDPARAMETER(sint_t, count);
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(std::string, label);
+  NAMEDPARAMETER(Position, position);
+  NAMEDPARAMETER(Quaternion, rotation);
+  NAMEDPARAMETERDEF(bool, enabled, true);
+  INamedParameter *list[] = {&count, &gain, &label, &position, &rotation, &enabled};
+  const char *jsonstr = ("{"
+                         "\"gain\":0.5,"
+                         "\"unknown\":{\"gain\":[1,2,3]},"
+                         "\"label\":\"violin\","
+                         "\"position\":{\"y\":2,\"z\":3,\"x\":1},"
+                         "\"rotation\":{\"x\":0,\"y\":0,\"z\":1,\"w\":0},"
+                         "\"count\":7"
+                         "}");
+  JSONReader reader(jsonstr);
+
+  enabled = false;
+  CHECK(json::FromJSON(reader, list, NUMBEROF(list)) == true);
+  CHECK(count == 7);
+  CHECK(gain == 0.5);
+  CHECK(label == "violin");
+  CHECK(position.Get() == Position(1, 2, 3));
+  CHECK(rotation.Get() == Quaternion(0, 0, 0, 1));
+  CHECK(enabled.IsSet() == false);
+  CHECK(enabled == true);           // reset to default
+
+  // polar position (polar member after co-ordinates)
+  JSONReader reader2("{\"az\":30,\"el\":10,\"d\":2,\"polar\":true}");
+  Position pos;
+  CHECK(json::FromJSON(reader2, pos) == true);
+  CHECK(pos.polar == true);
+  CHECK(pos.pos.az == 30.0);
+  CHECK(pos.pos.el == 10.0);
+  CHECK(pos.pos.d == 2.0);
+
+  // missing co-ordinate
+  JSONReader reader3("{\"x\":1,\"y\":2}");
+  CHECK(json::FromJSON(reader3, pos) == false);
+  CHECK(pos.polar == true);         // unchanged
+
+  // wrong type
+  JSONReader reader4("{\"count\":\"seven\"}");
+  CHECK(json::FromJSON(reader4, list, NUMBEROF(list), false) == false);
+  CHECK(count == 7);                // unchanged
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return JSON text of the DOM and streaming versions of an object
+ */
+/*--------------------------------------------------------------------------------*/
+template<typename T>
+static bool CompareOutput(const T& val, bool pretty)
+{
+  JSONValue  obj;
+  JSONWriter writer(pretty);
+
+  json::ToJSON(val, obj);
+  json::ToJSON(val, writer);
+
+  bool same = (writer.GetString() == json::ToJSONString(obj, pretty));
+  if (!same) WARN("Expected:\n" << json::ToJSONString(obj, pretty) << "Found:\n" << writer.GetString());
+  return same;
+}
+
+TEST_CASE("jsonwriter")
+{
+  JSONValue  obj, sub;
+  JSONWriter writer(false);
+  uint_t     i, mismatches = 0;
+
+  // scalars
+  writer.Int(-2);
+  CHECK(writer.GetString() == "-2\n");
+  writer.Reset();
+  writer.Null();
+  CHECK(writer.GetString() == "{}");
+  writer.Reset();
+  CHECK(writer.GetString() == "{}");
+
+  // explicit calls
+  writer.Reset(true);
+  writer.StartObject();
+  writer.Key("a"); writer.StartArray(); writer.UInt(1); writer.Double(2.0); writer.EndArray();
+  writer.Key("b"); writer.StartObject(); writer.EndObject();
+  writer.Key("c"); writer.StartObject(); writer.Key("d"); writer.String("e\"f"); writer.EndObject();
+  writer.EndObject();
+  CHECK(writer.GetString() == "{\n\t\"a\" : \n\t[\n\t\t1,\n\t\t2.0\n\t],\n\t\"b\" : {},\n\t\"c\" : \n\t{\n\t\t\"d\" : \"e\\\"f\"\n\t}\n}\n");
+
+  // everything jsoncpp can hold
+  obj["int"]     = (Json::Int64)-10000000000LL;
+  obj["uint"]    = (Json::UInt64)18446744073709551615ULL;
+  obj["zero"]    = 0;
+  obj["true"]    = true;
+  obj["false"]   = false;
+  obj["null"]    = JSONValue();
+  obj["empty"]   = "";
+  obj["escapes"] = std::string("\"\\/\b\f\n\r\t\x01\x1f\x7f", 12);
+  obj["utf8"]    = "\xc3\xa9\xe2\x82\xac\xf0\x9f\x8e\xb5";
+  obj["invalid"] = "\xc3\x28\xe2\x82\xff\xf8\x80\xc0\xaf\xed\xa0\x80\xe2";
+  obj["emptyobj"] = JSONValue(Json::objectValue);
+  obj["emptyarr"] = JSONValue(Json::arrayValue);
+  obj["nested"]["a"]["b"]["c"] = "deep";
+  obj["nested"]["arr"][0] = 1;
+  obj["nested"]["arr"][1] = JSONValue(Json::objectValue);
+  obj["nested"]["arr"][2]["x"] = 1.5;
+  obj["nested"]["arr"][3][0] = "y";
+  obj["nested"]["arr"][4] = JSONValue(Json::arrayValue);
+  obj[std::string("key\twith\xc3\xa9 escapes")] = 1;
+
+  static const double reals[] = {0.0, -0.0, 1.0, -2.0, 0.1, 3.4, 1.0 / 3.0, 1e300, -1e-300, 123456789012345678.0, 4.9e-324, (double)3.4f};
+  for (i = 0; i < NUMBEROF(reals); i++) obj["reals"][i] = reals[i];
+
+  // long array
+  for (i = 0; i < 40; i++) sub[i] = i * 3;
+  obj["long"] = sub;
+
+  mismatches += !CompareOutput(obj, true);
+  mismatches += !CompareOutput(obj, false);
+  mismatches += !CompareOutput(obj["nested"]["arr"], true);
+  mismatches += !CompareOutput(obj["nested"]["arr"], false);
+  mismatches += !CompareOutput(obj["reals"], false);
+  mismatches += !CompareOutput(obj["utf8"], true);
+  mismatches += !CompareOutput(obj["emptyobj"], true);
+  mismatches += !CompareOutput(obj["emptyarr"], false);
+  mismatches += !CompareOutput(JSONValue(), true);
+
+  // basic types
+  mismatches += !CompareOutput(true, true);
+  mismatches += !CompareOutput((sint_t)-2147483647 - 1, true);
+  mismatches += !CompareOutput((uint_t)4294967295U, true);
+  mismatches += !CompareOutput((sint64_t)-9223372036854775807LL - 1, true);
+  mismatches += !CompareOutput((uint64_t)18446744073709551615ULL, false);
+  mismatches += !CompareOutput(3.4f, false);
+  mismatches += !CompareOutput(1.0 / 3.0, false);
+  mismatches += !CompareOutput(std::string("aaa"), false);
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("jsonwriterobjects")
+{
+  NAMEDPARAMETER(sint_t, count);
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(std::string, label);
+  NAMEDPARAMETER(Position, position);
+  NAMEDPARAMETER(Quaternion, rotation);
+  NAMEDPARAMETERDEF(bool, enabled, true);
+  const INamedParameter *list[] = {&rotation, &label, &count, &position, &enabled, &gain};
+  ParameterSet parameters;
+  JSONValue    obj;
+  JSONWriter   writer(false);
+  uint_t       mismatches = 0;
+  uint_t       pretty;
+
+  for (pretty = 0; pretty < 2; pretty++)
+  {
+    mismatches += !CompareOutput(Position(1.0, -2.5, 0.1), pretty != 0);
+    mismatches += !CompareOutput(Position(30.0, 10.0, 2.0).Polar(), pretty != 0);
+    mismatches += !CompareOutput(Quaternion(0.5, 0.5, -0.5, 0.5), pretty != 0);
+    mismatches += !CompareOutput(parameters, pretty != 0);
+  }
+
+  // values of all types, sub-objects and values hiding sub-objects
+  parameters.Set("a", 1);
+  parameters.Set("b", -2);
+  parameters.Set("c", 3.4);
+  parameters.Set("d", (sint64_t)-10000000000LL);
+  parameters.Set("e", (uint64_t)10000000000ULL);
+  parameters.Set("f", "text with \"quotes\"");
+  parameters.Set("g", true);
+  parameters.Set("h.x", 1.5);
+  parameters.Set("h.y.z", "deep");
+  parameters.Set("h.w", 0);
+  parameters.Set("i", "value");
+  parameters.Set("i.hidden", 1);
+  parameters.Set("j.k", 1);
+  parameters.Set("j-k", 2);
+  parameters.Set("l.m.n", 1);
+  parameters.Delete("l.m.n");
+  for (pretty = 0; pretty < 2; pretty++) mismatches += !CompareOutput(parameters, pretty != 0);
+
+  // JSONSerializable::ToJSONString() uses the streaming writer
+  parameters.ToJSON(obj);
+  CHECK(parameters.ToJSONString() == json::ToJSONString(obj, true));
+  CHECK(parameters.ToJSONString(false) == json::ToJSONString(obj, false));
+
+  // NamedParameter lists (written in name order regardless of list order)
+  json::ToJSON(list, NUMBEROF(list), writer);
+  CHECK(writer.GetString() == "{}");
+  count = 7;
+  gain = 0.5;
+  label = "violin";
+  position = Position(1, 2, 3);
+  rotation = Quaternion(0, 0, 0, 1);
+  for (pretty = 0; pretty < 2; pretty++)
+  {
+    uint_t all;
+
+    for (all = 0; all < 2; all++)
+    {
+      obj = JSONValue();
+      json::ToJSON(list, NUMBEROF(list), obj, (all != 0));
+      writer.Reset(pretty != 0);
+      json::ToJSON(list, NUMBEROF(list), writer, (all != 0));
+      mismatches += (writer.GetString() != json::ToJSONString(obj, pretty != 0));
+    }
+  }
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("jsonreaderbenchmark", "[.][benchmark]")
+{
+  NAMEDPARAMETER(std::string, name);
+  NAMEDPARAMETER(uint_t, channel);
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(bool, muted);
+  NAMEDPARAMETER(Position, position);
+  NAMEDPARAMETER(Quaternion, rotation);
+  INamedParameter *list[] = {&name, &channel, &gain, &muted, &position, &rotation};
+  const uint_t objects = 2000, iterations = 20;
+  std::chrono::steady_clock::time_point start;
+  std::string jsonstr = "{";
+  uint_t i, count = 0;
+  double ns;
+
+  // large configuration: objects with nested positions and parameters
+  for (i = 0; i < objects; i++)
+  {
+    Printf(jsonstr, "%s\"object%u\":{\"name\":\"object %u\",\"channel\":%u,\"gain\":%0.6lf,\"muted\":%s,"
+           "\"position\":{\"polar\":false,\"x\":%0.4lf,\"y\":%0.4lf,\"z\":%0.4lf},"
+           "\"rotation\":{\"w\":1.0,\"x\":0.0,\"y\":0.0,\"z\":0.0},"
+           "\"options\":{\"delay\":%u,\"label\":\"track\\t%u\"}}",
+           i ? "," : "", i, i, i, 1.0 / (double)(i + 1), (i & 1) ? "true" : "false",
+           (double)i * 0.5, (double)i * -0.25, 1.5, i * 10, i);
+  }
+  jsonstr += "}";
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    ParameterSet parameters;
+    JSONValue obj;
+    json::FromJSONString(jsonstr, obj);
+    parameters.FromJSON(obj);
+    count += parameters.GetCount();
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("ParameterSet from JSON (jsoncpp): " << ns << "ns per object");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    ParameterSet parameters;
+    JSONReader reader(jsonstr);
+    parameters.FromJSON(reader);
+    count += parameters.GetCount();
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("ParameterSet from JSON (streaming): " << ns << "ns per object");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    JSONValue obj;
+    JSONValue::const_iterator it;
+    json::FromJSONString(jsonstr, obj);
+    for (it = obj.begin(); it != obj.end(); ++it)
+    {
+      count += json::FromJSON(*it, list, NUMBEROF(list));
+    }
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("NamedParameters from JSON (jsoncpp): " << ns << "ns per object");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    JSONReader reader(jsonstr);
+    if (reader.Next() == JSONReader::Token_ObjectStart)
+    {
+      while (reader.Next() == JSONReader::Token_Key)
+      {
+        count += json::FromJSON(reader, list, NUMBEROF(list));
+      }
+    }
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("NamedParameters from JSON (streaming): " << ns << "ns per object");
+
+  // 14 parameters per object for each ParameterSet and 1 for each successful NamedParameter list
+  CHECK(count == iterations * objects * (2 * 14 + 2));
+}
+
+TEST_CASE("jsonwriterbenchmark", "[.][benchmark]")
+{
+  NAMEDPARAMETER(std::string, name);
+  NAMEDPARAMETER(uint_t, channel);
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(bool, muted);
+  NAMEDPARAMETER(Position, position);
+  NAMEDPARAMETER(Quaternion, rotation);
+  const INamedParameter *list[] = {&name, &channel, &gain, &muted, &position, &rotation};
+  const uint_t objects = 100, iterations = 200;
+  std::vector<ParameterSet> sets(objects);
+  std::chrono::steady_clock::time_point start;
+  JSONWriter writer(false);
+  uint_t i, j;
+  size_t length = 0;
+  double ns;
+
+  name = "object";
+  channel = 3;
+  muted = true;
+  rotation = Quaternion(1, 0, 0, 0);
+  for (i = 0; i < objects; i++)
+  {
+    sets[i].Set("name", "object").Set("channel", i).Set("gain", 1.0 / (double)(i + 1));
+    sets[i].Set("position.x", (double)i * 0.5).Set("position.y", (double)i * -0.25).Set("position.z", 1.5);
+  }
+
+  // per-block state updates: each object written as a separate compact message
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < objects; j++)
+    {
+      gain = 1.0 / (double)(j + 1);
+      position = Position((double)j * 0.5, (double)j * -0.25, 1.5);
+      JSONValue obj;
+      json::ToJSON(list, NUMBEROF(list), obj);
+      length += json::ToJSONString(obj, false).length();
+    }
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("NamedParameters to JSON (jsoncpp): " << ns << "ns per object");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < objects; j++)
+    {
+      gain = 1.0 / (double)(j + 1);
+      position = Position((double)j * 0.5, (double)j * -0.25, 1.5);
+      writer.Reset();
+      json::ToJSON(list, NUMBEROF(list), writer);
+      length -= writer.GetString().length();
+    }
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("NamedParameters to JSON (streaming): " << ns << "ns per object");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < objects; j++)
+    {
+      JSONValue obj;
+      sets[j].ToJSON(obj);
+      length += json::ToJSONString(obj, false).length();
+    }
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("ParameterSet to JSON (jsoncpp): " << ns << "ns per object");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < objects; j++)
+    {
+      writer.Reset();
+      sets[j].ToJSON(writer);
+      length -= writer.GetString().length();
+    }
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(iterations * objects);
+  WARN("ParameterSet to JSON (streaming): " << ns << "ns per object");
+
+  // both methods produce the same amount of text
+  CHECK(length == 0);
+}
+
 BBC_AUDIOTOOLBOX_END
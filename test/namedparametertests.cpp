@@ -0,0 +1,449 @@
+#include <chrono>
+#include <thread>
+
+#include <catch/catch.hpp>
+
+#include "NamedParameter.h"
+#include "NamedParameterGroup.h"
+
+BBC_AUDIOTOOLBOX_START
+
+TEST_CASE("namedparameter")
+{
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(double, level);
+  NAMEDPARAMETERDEF(sint_t, count, 3);
+  NAMEDPARAMETER(std::string, label);
+  INamedParameter& igain  = gain;
+  INamedParameter& ilevel = level;
+  INamedParameter& icount = count;
+  INamedParameter& ilabel = label;
+
+  // type tags
+  CHECK(igain.GetTypeID() == ilevel.GetTypeID());
+  CHECK(igain.GetTypeID() == NamedParameter<double>::TypeID());
+  CHECK(igain.GetTypeID() != icount.GetTypeID());
+  CHECK(icount.GetTypeID() != ilabel.GetTypeID());
+
+  // value access
+  count.Reset();
+  CHECK(count == 3);
+  CHECK(count.IsSet() == false);
+  gain = 0.5;
+  CHECK(gain.IsSet() == true);
+  CHECK(gain.Get() == 0.5);
+  CHECK((double)gain == 0.5);
+  gain.GetWritable() = 0.25;
+  gain.MarkAsSet();
+  CHECK(gain == 0.25);
+  level.Set() = 2.0;
+  CHECK(level.IsSet() == true);
+  CHECK(igain.IsSet() == true);
+
+  // non-virtual accessors
+  CHECK(gain.Value() == 0.25);
+  CHECK(gain.IsValueSet() == true);
+  count.Reset();
+  CHECK(count.IsValueSet() == false);
+  count.SetValue(5);
+  CHECK(count.IsValueSet() == true);
+  CHECK(count.Get() == 5);
+
+  // assignment and comparison through the interface
+  CHECK((igain == ilevel) == false);
+  ilevel = igain;
+  CHECK(level == 0.25);
+  CHECK((igain == ilevel) == true);
+  CHECK((igain == icount) == false);
+
+  // parameters of different types are left unchanged
+  count = 7;
+  icount = igain;
+  CHECK(count == 7);
+  igain = icount;
+  CHECK(gain == 0.25);
+  label = "text";
+  ilabel = icount;
+  CHECK(label == "text");
+
+  icount.Reset();
+  CHECK(count == 3);
+  CHECK(count.IsSet() == false);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Implementation of INamedParameter that only supplies the original interface
+ */
+/*--------------------------------------------------------------------------------*/
+class CustomParameter : public INamedParameter
+{
+public:
+  CustomParameter() : value(0),
+                      valueset(false) {}
+
+  virtual CustomParameter& operator = (const INamedParameter& obj) {(void)obj; return *this;}
+  virtual bool operator == (const INamedParameter& obj) const {return (&obj == this);}
+  virtual void Reset() {value = 0; valueset = false; generation++;}
+  virtual bool IsSet() const {return valueset;}
+  virtual const char *GetName() const {return "custom";}
+  virtual std::string ToString() const {return StringFrom(value);}
+  virtual bool FromString(const std::string& str) {bool success = Evaluate(str, value); if (success) {valueset = true; generation++;} return success;}
+#if ENABLE_JSON
+  virtual CustomParameter& operator = (const JSONValue& obj) {FromJSON(obj); return *this;}
+  virtual void ToJSON(JSONValue& obj) const {obj = value;}
+  virtual bool FromJSON(const JSONValue& obj) {bool success = json::FromJSON(obj, value); if (success) {valueset = true; generation++;} return success;}
+#endif
+
+protected:
+  sint_t value;
+  bool   valueset;
+};
+
+TEST_CASE("namedparametercustom")
+{
+  NAMEDPARAMETER(sint_t, count);
+  CustomParameter custom;
+  INamedParameter& icount  = count;
+  INamedParameter& icustom = custom;
+
+  // parameters without a type tag are never compatible with NamedParameter<TYPE>
+  CHECK(icustom.GetTypeID() == NULL);
+  CHECK(custom.FromString("3") == true);
+  count = 7;
+  icount = icustom;
+  CHECK(count == 7);
+  CHECK((icount == icustom) == false);
+  CHECK((icustom == icustom) == true);
+  CHECK(icustom.Clone() == NULL);
+
+  // the mailbox ignores parameters it cannot copy
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(double, level);
+  CustomParameter custom2;
+  NamedParameterGroup control, audio;
+  control.Add(gain);
+  control.Add(custom);
+  audio.Add(level);
+  audio.Add(custom2);
+  NamedParameterMailbox mailbox(audio);
+
+  gain = 0.5;
+  CHECK(custom.FromString("4") == true);
+  CHECK(mailbox.Post(control) == true);
+  CHECK(mailbox.Receive(audio) == 1);
+  CHECK(level == 0.5);
+  CHECK(custom.FromString("5") == true);
+  CHECK(mailbox.Post(control) == false);
+  CHECK(mailbox.Receive(audio) == 0);
+  CHECK(custom2.IsSet() == false);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Parameter whose name is not static storage
+ */
+/*--------------------------------------------------------------------------------*/
+class DynamicNameParameter : public NamedParameter<double>
+{
+public:
+  DynamicNameParameter(const std::string& _name) : NamedParameter<double>(),
+                                                   name(_name) {}
+
+  virtual const char *GetName() const {return name.c_str();}
+
+protected:
+  std::string name;
+};
+
+TEST_CASE("namedparametergroup")
+{
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(Position, position);
+  NAMEDPARAMETER(std::string, label);
+  INamedParameter *list[] = {&gain, &position, &label};
+  NamedParameterGroup group(list, NUMBEROF(list));
+  uint_t generation = gain.GetGeneration();
+
+  // every parameter is reported as changed initially
+  CHECK(group.GetCount() == 3);
+  CHECK(group.HasChanged() == true);
+  CHECK(group.Consume() == 3);
+  CHECK(group.WasChanged(0) == true);
+  CHECK(group.HasChanged() == false);
+  CHECK(group.Consume() == 0);
+  CHECK(group.WasChanged(0) == false);
+  CHECK(group.GetChanged().size() == 0);
+
+  // every way of setting a parameter changes its generation
+  gain = 1.0;
+  CHECK(gain.GetGeneration() == ++generation);
+  gain.Set(1.0);
+  CHECK(gain.GetGeneration() == ++generation);
+  gain.Set() = 2.0;
+  CHECK(gain.GetGeneration() == ++generation);
+  gain.GetWritable() = 3.0;
+  CHECK(gain.GetGeneration() == generation);
+  gain.MarkAsSet();
+  CHECK(gain.GetGeneration() == ++generation);
+  gain.SetValue(3.5);
+  CHECK(gain.GetGeneration() == ++generation);
+  CHECK(gain.FromString("4.0") == true);
+  CHECK(gain.GetGeneration() == ++generation);
+  CHECK(gain.FromString("x") == false);
+  CHECK(gain.GetGeneration() == generation);
+  gain.Reset();
+  CHECK(gain.GetGeneration() == ++generation);
+  CHECK(gain.Get() == 0.0);
+
+  // only changed parameters are reported
+  label = "text";
+  CHECK(group.HasChanged() == true);
+  CHECK(group.Consume() == 2);
+  CHECK(group.WasChanged(0) == true);
+  CHECK(group.WasChanged(position) == false);
+  CHECK(group.WasChanged(label) == true);
+  REQUIRE(group.GetChanged().size() == 2);
+  CHECK(group.GetChanged()[0] == 0);
+  CHECK(group.GetChanged()[1] == 2);
+  CHECK(group.Consume() == 0);
+  CHECK(group.WasChanged(label) == false);
+
+  // setting to the same value still counts as a change
+  label = "text";
+  CHECK(group.Consume() == 1);
+  CHECK(group.WasChanged(label) == true);
+
+  // clones have the same type and value
+  INamedParameter *copy = position.Clone();
+  position = Position(1.0, 2.0, 3.0);
+  CHECK((*copy == position) == false);
+  *copy = position;
+  CHECK((*copy == position) == true);
+  CHECK(copy->GetTypeID() == position.GetTypeID());
+  CHECK(strcmp(copy->GetName(), "position") == 0);
+  CHECK(copy->IsSet() == true);
+  delete copy;
+
+  // clones keep their own copy of the name
+  {
+    DynamicNameParameter *dynamic = new DynamicNameParameter("dynamic");
+    copy = dynamic->Clone();
+    delete dynamic;
+    CHECK(strcmp(copy->GetName(), "dynamic") == 0);
+    delete copy;
+  }
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Parameters of a processor (one set each for the control and audio threads)
+ */
+/*--------------------------------------------------------------------------------*/
+class MailboxParameters
+{
+public:
+  MailboxParameters()
+  {
+    group.Add(gain);
+    group.Add(count);
+    group.Add(label);
+  }
+
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(sint_t, count);
+  NAMEDPARAMETER(std::string, label);
+  NamedParameterGroup group;
+};
+
+TEST_CASE("namedparametermailbox")
+{
+  MailboxParameters control, audio;
+  NamedParameterMailbox mailbox(audio.group);
+
+  audio.group.Consume();
+
+  // nothing posted
+  CHECK(mailbox.Receive(audio.group) == 0);
+  CHECK(mailbox.Post(control.group) == false);
+  CHECK(mailbox.Receive(audio.group) == 0);
+
+  // only changed parameters are copied and reported
+  control.gain = 0.5;
+  control.label = "violin";
+  CHECK(mailbox.Post(control.group) == true);
+  CHECK(mailbox.Post(control.group) == false);
+  CHECK(mailbox.Receive(audio.group) == 2);
+  CHECK(audio.gain == 0.5);
+  CHECK(audio.label == "violin");
+  CHECK(audio.label.IsSet() == true);
+  CHECK(audio.count.IsSet() == false);
+  CHECK(audio.group.Consume() == 2);
+  CHECK(audio.group.WasChanged(audio.count) == false);
+  CHECK(mailbox.Receive(audio.group) == 0);
+  CHECK(audio.group.Consume() == 0);
+
+  // several posts between receives deliver the latest values, including parameters
+  // changed in earlier posts that were never received
+  control.count = 1;
+  CHECK(mailbox.Post(control.group) == true);
+  control.gain = 0.25;
+  CHECK(mailbox.Post(control.group) == true);
+  control.gain = 0.125;
+  CHECK(mailbox.Post(control.group) == true);
+  control.label = "cello";
+  CHECK(mailbox.Post(control.group) == true);
+  CHECK(mailbox.Receive(audio.group) == 3);
+  CHECK(audio.gain == 0.125);
+  CHECK(audio.count == 1);
+  CHECK(audio.label == "cello");
+  CHECK(audio.group.Consume() == 3);
+
+  // parameters set by the receiving thread are only overwritten by new posts
+  audio.gain = 2.0;
+  control.count = 2;
+  CHECK(mailbox.Post(control.group) == true);
+  CHECK(mailbox.Receive(audio.group) == 1);
+  CHECK(audio.gain == 2.0);
+  CHECK(audio.count == 2);
+}
+
+TEST_CASE("namedparametermailboxthreads")
+{
+  MailboxParameters control, audio;
+  NamedParameterMailbox mailbox(audio.group);
+  const sint_t updates = 100000;
+  std::atomic<bool> done(false);
+  uint_t errors = 0, received = 0;
+  sint_t last = 0;
+
+  audio.group.Consume();
+
+  // control thread always sets gain to -count
+  std::thread thread([&]() {
+      sint_t i;
+
+      for (i = 1; i <= updates; i++)
+      {
+        control.count = i;
+        control.gain  = -i;
+        mailbox.Post(control.group);
+      }
+      done = true;
+    });
+
+  // audio thread must only ever see consistent, increasing values
+  while (true)
+  {
+    bool finished = done;
+
+    if (mailbox.Receive(audio.group))
+    {
+      errors += ((audio.gain.Get() != -audio.count.Get()) || (audio.count.Get() <= last));
+      last = audio.count;
+      received++;
+    }
+    else if (finished) break;
+  }
+  thread.join();
+
+  CHECK(errors == 0);
+  CHECK(last == updates);
+  CHECK(received > 0);
+  CHECK(audio.group.Consume() == 2);
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Return time in ns per operation
+ */
+/*--------------------------------------------------------------------------------*/
+static double GetNS(const std::chrono::steady_clock::time_point& start, ullong_t ops)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)ops;
+}
+
+TEST_CASE("namedparameterbenchmark", "[.][benchmark]")
+{
+  NAMEDPARAMETER(double, gain);
+  NAMEDPARAMETER(double, level);
+  NAMEDPARAMETER(double, delay);
+  NAMEDPARAMETER(double, width);
+  NAMEDPARAMETER(sint_t, count);
+  NamedParameter<double> *params[] = {&gain, &level, &delay, &width};
+  INamedParameter *iparams[] = {&gain, &level, &delay, &width, &count};
+  const uint_t iterations = 2000000, n = NUMBEROF(params);
+  std::chrono::steady_clock::time_point start;
+  volatile uint_t index = 0;
+  double sum = 0.0;
+  uint_t i, j, matches = 0;
+
+  for (j = 0; j < n; j++) *params[j] = (double)j;
+
+  // typical per-block reading of parameters through pointers
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) sum += params[(j + index) % n]->Get();
+  }
+  WARN("NamedParameter Get(): " << GetNS(start, (ullong_t)iterations * n) << "ns per read (" << sum << ")");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++)
+    {
+      const NamedParameter<double>& param = *params[(j + index) % n];
+      if (param.IsSet()) sum += param;
+    }
+  }
+  WARN("NamedParameter IsSet() and cast: " << GetNS(start, (ullong_t)iterations * n) << "ns per read (" << sum << ")");
+
+  // non-virtual accessors
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) sum += params[(j + index) % n]->Value();
+  }
+  WARN("NamedParameter Value(): " << GetNS(start, (ullong_t)iterations * n) << "ns per read (" << sum << ")");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++)
+    {
+      const NamedParameter<double>& param = *params[(j + index) % n];
+      if (param.IsValueSet()) sum += param.Value();
+    }
+  }
+  WARN("NamedParameter IsValueSet() and Value(): " << GetNS(start, (ullong_t)iterations * n) << "ns per read (" << sum << ")");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) params[(j + index) % n]->Set((double)i);
+  }
+  WARN("NamedParameter Set(): " << GetNS(start, (ullong_t)iterations * n) << "ns per write");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) params[(j + index) % n]->SetValue((double)i);
+  }
+  WARN("NamedParameter SetValue(): " << GetNS(start, (ullong_t)iterations * n) << "ns per write");
+
+  // assignment and comparison through the interface (including mismatched types)
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < NUMBEROF(iparams); j++) *iparams[(j + index) % NUMBEROF(iparams)] = *iparams[(j + index + 1) % NUMBEROF(iparams)];
+  }
+  WARN("INamedParameter assignment: " << GetNS(start, (ullong_t)iterations * NUMBEROF(iparams)) << "ns per assignment");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < NUMBEROF(iparams); j++) matches += (*iparams[(j + index) % NUMBEROF(iparams)] == *iparams[(j + index + 1) % NUMBEROF(iparams)]);
+  }
+  WARN("INamedParameter comparison: " << GetNS(start, (ullong_t)iterations * NUMBEROF(iparams)) << "ns per comparison (" << matches << ")");
+
+  CHECK(sum > 0.0);
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,725 @@
+#include <chrono>
+#include <map>
+#include <thread>
+
+#include <catch/catch.hpp>
+
+#include "ParameterSet.h"
+#include "3DPosition.h"
+#include "SelfRegisteringParametricObject.h"
+
+BBC_AUDIOTOOLBOX_START
+
+TEST_CASE("parameterset")
+{
+  ParameterSet parameters;
+  std::string str;
+  bool     bval   = false;
+  sint_t   sval   = 0;
+  uint_t   uval   = 0;
+  sllong_t llval  = 0;
+  ullong_t ullval = 0;
+  float    fval   = 0.0f;
+  double   dval   = 0.0;
+
+  parameters.Set("bool", true).Set("int", -5).Set("uint", 7U).Set("llong", (sllong_t)-1234567890123LL).Set("ullong", (ullong_t)1234567890123ULL);
+  parameters.Set("double", 2.75).Set("float", 0.5f).Set("string", "hello").Set("number", "12");
+
+  // native types
+  CHECK(parameters.GetValue("bool")->GetType()   == ParameterValue::Type_Bool);
+  CHECK(parameters.GetValue("int")->GetType()    == ParameterValue::Type_Int);
+  CHECK(parameters.GetValue("uint")->GetType()   == ParameterValue::Type_UInt);
+  CHECK(parameters.GetValue("double")->GetType() == ParameterValue::Type_Double);
+  CHECK(parameters.GetValue("string")->GetType() == ParameterValue::Type_String);
+  CHECK(parameters.GetValue("missing") == NULL);
+
+  // round trips
+  CHECK(parameters.Get("bool", bval));
+  CHECK(bval);
+  CHECK(parameters.Get("int", sval));
+  CHECK(sval == -5);
+  CHECK(parameters.Get("uint", uval));
+  CHECK(uval == 7);
+  CHECK(parameters.Get("llong", llval));
+  CHECK(llval == -1234567890123LL);
+  CHECK(parameters.Get("ullong", ullval));
+  CHECK(ullval == 1234567890123ULL);
+  CHECK(parameters.Get("double", dval));
+  CHECK(dval == 2.75);
+  CHECK(parameters.Get("float", fval));
+  CHECK(fval == 0.5f);
+  CHECK(parameters.Get("number", sval));
+  CHECK(sval == 12);
+  CHECK(!parameters.Get("string", dval));
+  CHECK(!parameters.Get("missing", dval));
+
+  // conversions give the same results as via strings
+  CHECK(parameters.Get("int", dval));
+  CHECK(dval == -5.0);
+  CHECK(parameters.Get("double", sval));
+  CHECK(sval == 2);
+  CHECK(parameters.Get("bool", uval));
+  CHECK(uval == 1);
+  CHECK(parameters.Set("small", 0.25).Get("small", bval));
+  CHECK(!bval);
+
+  // string forms are as before
+  CHECK(parameters.Get("bool", str));
+  CHECK(str == "1");
+  CHECK(parameters.Raw("int") == "-5");
+  CHECK(parameters.Raw("double") == StringFrom(2.75));
+  CHECK(parameters.Raw("string") == "hello");
+
+  uint_t n = 0, mismatches = 0;
+  ParameterSet::Iterator it;
+  for (it = parameters.GetBegin(); it != parameters.GetEnd(); ++it, n++)
+  {
+    mismatches += (it->second != parameters.Raw(it->first));
+    mismatches += (it->first != it.GetName());
+  }
+  CHECK(n == 10);
+  CHECK(mismatches == 0);
+
+  // comparison uses string forms
+  ParameterSet parameters2;
+  parameters2.Set("int", "-5").Set("double", StringFrom(2.75));
+  CHECK(parameters.Contains(parameters2));
+  parameters2.Set("int", -6);
+  CHECK(!parameters.Contains(parameters2));
+
+  // sub-parameters keep their native values
+  ParameterSet sub;
+  ParameterSet parent;
+  parent.Set("x", 1.5).Set("a", 1).Set("z", "end");
+  parent.Set("sub", parameters);
+  CHECK(parent.GetSubParameters(sub, "sub"));
+  CHECK(sub == parameters);
+  CHECK(sub.GetValue("double")->GetType() == ParameterValue::Type_Double);
+  CHECK(!parent.GetSubParameters(sub, "su"));
+}
+
+TEST_CASE("parametersethierarchy")
+{
+  ParameterSet parameters;
+  std::string names;
+  uint_t i, mismatches = 0;
+
+  parameters.Set("b", 1).Set("a.z", 2).Set("a", 3).Set("a.b.c", 4).Set("c.a", 5).Set("a.b", 6);
+
+  // names in order with sub-parameters following their prefix
+  ParameterSet::Iterator it;
+  for (it = parameters.GetBegin(); it != parameters.GetEnd(); ++it) names += it->first + " ";
+  CHECK(names == "a a.b a.b.c a.z b c.a ");
+
+  ParameterSet sub = parameters.GetSubParameters("a");
+  CHECK(sub.ToString() == "b 6, b.c 4, z 2");
+  CHECK(parameters.GetSubParameters("a.b").ToString() == "c 4");
+  CHECK(parameters.GetSubParameters("c").ToString() == "a 5");
+  CHECK(parameters.GetSubParameters("b").IsEmpty());
+  CHECK(parameters.GetSubParameters("d").IsEmpty());
+
+  // prefixes without values are not visible
+  CHECK(!parameters.Exists("c"));
+  CHECK(parameters.Delete("a.b"));
+  CHECK(!parameters.Delete("a.b"));
+  CHECK(!parameters.Exists("a.b"));
+  CHECK(parameters.GetSubParameters("a").ToString() == "b.c 4, z 2");
+  parameters.Set("a.b", 7);
+  CHECK(parameters.Raw("a.b") == "7");
+
+  // comparison is independent of the order values were set in
+  ParameterSet parameters2;
+  parameters2.Set("a.b", 7).Set("a.b.c", 4).Set("c.a", 5).Set("a", 3).Set("a.z", 2).Set("b", 1);
+  CHECK(parameters == parameters2);
+  parameters2.Delete("b");
+  CHECK(parameters != parameters2);
+  parameters2.Set("b", "1");
+  CHECK(parameters == parameters2);
+
+  // large sets
+  parameters.Clear();
+  CHECK(parameters.IsEmpty());
+  for (i = 0; i < 5000; i++)
+  {
+    parameters.Set("objects." + StringFrom(i % 50) + ".item" + StringFrom(i), i);
+  }
+  for (i = 0; i < 5000; i++)
+  {
+    uint_t val = ~0U;
+    mismatches += !(parameters.Get("objects." + StringFrom(i % 50) + ".item" + StringFrom(i), val) && (val == i));
+  }
+  CHECK(mismatches == 0);
+  CHECK(parameters.GetSubParameters("objects.7").Get("item107", i));
+  CHECK(i == 107);
+  CHECK(parameters.GetSubParameters("objects").GetSubParameters("49").ToString() == parameters.GetSubParameters("objects.49").ToString());
+}
+
+TEST_CASE("parametersetview")
+{
+  ParameterSet parameters;
+  double dval = 0.0;
+  sint_t sval = 0;
+  std::string names;
+
+  parameters.Set("pos.x", 1.5).Set("pos.y", -2).Set("pos.extra.z", "3").Set("pos", "stub").Set("posx", 4).Set("other.x", 5);
+
+  ParameterSetView view(parameters, "pos");
+  CHECK(!view.IsEmpty());
+  CHECK(view.Exists("x"));
+  CHECK(view.Exists("extra.z"));
+  CHECK(!view.Exists("pos"));
+  CHECK(!view.Exists("z"));
+  CHECK(view.Get("x", dval));
+  CHECK(dval == 1.5);
+  CHECK(view.Get("extra.z", sval));
+  CHECK(sval == 3);
+  CHECK(view.GetValue("y")->GetType() == ParameterValue::Type_Int);
+
+  // same contents and order as a copy
+  ParameterSet::Iterator it;
+  for (it = view.GetBegin(); it != view.GetEnd(); ++it) names += it->first + "=" + it->second + " ";
+  CHECK(names == "extra.z=3 x=" + StringFrom(1.5) + " y=-2 ");
+  CHECK(view.ToString() == parameters.GetSubParameters("pos").ToString());
+  CHECK(ParameterSet(view) == parameters.GetSubParameters("pos"));
+
+  // nested views
+  ParameterSetView extra(view, "extra");
+  CHECK(extra.ToString() == "z 3");
+  CHECK(ParameterSetView(parameters, "pos.extra").ToString() == "z 3");
+  CHECK(ParameterSetView(extra, "z").IsEmpty());
+
+  // changes to the set are visible
+  parameters.Set("pos.z", 7).Delete("pos.x");
+  CHECK(!view.Exists("x"));
+  CHECK(view.Get("z", sval));
+  CHECK(sval == 7);
+
+  // unknown prefixes
+  CHECK(ParameterSetView(parameters, "parametersetview.unknown.prefix").IsEmpty());
+  CHECK(!ParameterSetView(parameters, "parametersetview.unknown.prefix").Exists("x"));
+  CHECK(ParameterSetView(parameters, "posx").IsEmpty());
+
+  // Position and Quaternion read their values through a view
+  Position pos(1, 2, 3), pos2;
+  Quaternion rot(0.5, 0.5, -0.5, 0.5), rot2;
+  pos.SetParameters(parameters, "position");
+  rot.SetParameters(parameters, "rotation");
+  CHECK(pos2.GetFromParameters(parameters, "position"));
+  CHECK(pos2 == pos);
+  CHECK(rot2.GetFromParameters(parameters, "rotation"));
+  CHECK(rot2 == rot);
+  CHECK(!pos2.GetFromParameters(parameters, "rotation.none"));
+}
+
+TEST_CASE("parametersetcopyonwrite")
+{
+  ParameterSet parameters;
+  uint_t i, mismatches = 0;
+
+  parameters.Set("a", 1).Set("b.c", 2).Set("b.d", "three");
+
+  // copies are independent
+  ParameterSet copy1 = parameters;
+  ParameterSet copy2(parameters);
+  CHECK(copy1 == parameters);
+  copy1.Set("a", 10);
+  CHECK(parameters.Raw("a") == "1");
+  CHECK(copy2.Raw("a") == "1");
+  CHECK(copy1.Raw("a") == "10");
+  CHECK(copy1 != parameters);
+  CHECK(copy2 == parameters);
+
+  CHECK(copy2.Delete("b.c"));
+  CHECK(parameters.Exists("b.c"));
+  CHECK(!copy2.Delete("b.c"));
+
+  // operators
+  ParameterSet sum = parameters + copy1;
+  CHECK(sum.Raw("a") == "10");
+  CHECK(parameters.Raw("a") == "1");
+  ParameterSet diff = parameters - copy2;
+  CHECK(diff.ToString() == "b.c 2");
+  CHECK(parameters.ToString() == "a 1, b.c 2, b.d three");
+  diff = parameters;
+  diff -= diff;
+  CHECK(diff.IsEmpty());
+  CHECK(!parameters.IsEmpty());
+  diff += parameters;
+  diff += diff;
+  CHECK(diff == parameters);
+  diff.Clear();
+  CHECK(diff.IsEmpty());
+  CHECK(parameters.ToString() == "a 1, b.c 2, b.d three");
+
+  // views of copies
+  ParameterSet copy3 = parameters;
+  ParameterSetView view(copy3, "b");
+  copy3.Set("b.e", 5);
+  CHECK(view.ToString() == "c 2, d three, e 5");
+  CHECK(!ParameterSetView(parameters, "b").Exists("e"));
+
+  // shared tables can be copied and modified from multiple threads
+  const uint_t nthreads = 4, n = 2000;
+  std::vector<std::thread> threads;
+  std::vector<uint_t> errors(nthreads);
+  for (i = 0; i < nthreads; i++)
+  {
+    threads.push_back(std::thread([&parameters, &errors, i, n]() {
+          uint_t j;
+          for (j = 0; j < n; j++)
+          {
+            ParameterSet copy = parameters;
+            sint_t val = 0;
+
+            copy.Set("thread", (sint_t)(i * n + j));
+            errors[i] += !(copy.Get("thread", val) && (val == (sint_t)(i * n + j)));
+            errors[i] += !(copy.Get("a", val) && (val == 1));
+            errors[i] += (copy.GetCount() != 4);
+          }
+        }));
+  }
+  for (i = 0; i < nthreads; i++)
+  {
+    threads[i].join();
+    mismatches += errors[i];
+  }
+  CHECK(mismatches == 0);
+  CHECK(!parameters.Exists("thread"));
+}
+
+/*--------------------------------------------------------------------------------*/
+/** Objects that keep a copy of their parameters (as many parametric objects do)
+ */
+/*--------------------------------------------------------------------------------*/
+class ParameterSetTestObject : public SelfRegisteringParametricObject
+{
+public:
+  ParameterSetTestObject(const ParameterSet& _parameters) : SelfRegisteringParametricObject(_parameters),
+                                                            parameters(_parameters) {position.GetFromParameters(parameters, "position");}
+
+  ParameterSet parameters;
+  Position     position;
+};
+
+class ParameterSetDeepCopyTestObject : public SelfRegisteringParametricObject
+{
+public:
+  ParameterSetDeepCopyTestObject(const ParameterSet& _parameters) : SelfRegisteringParametricObject(_parameters)
+  {
+    ParameterSet::Iterator it;
+
+    // copy every value as copying a set used to
+    for (it = _parameters.GetBegin(); it != _parameters.GetEnd(); ++it) parameters.Set(it.GetName(), it.GetValue());
+    position.GetFromParameters(parameters, "position");
+  }
+
+  ParameterSet parameters;
+  Position     position;
+};
+
+TEST_CASE("parametersetinstantiationbenchmark", "[.][benchmark]")
+{
+  SelfRegisteringParametricObjectFactory<ParameterSetTestObject>         factory("parametersettest", true);
+  SelfRegisteringParametricObjectFactory<ParameterSetDeepCopyTestObject> deepfactory("parametersetdeepcopytest", true);
+  ParameterSet parameters;
+  const uint_t iterations = 20000;
+  std::chrono::steady_clock::time_point start;
+  double ns;
+  uint_t i, valid = 0;
+
+  parameters.Set("id", "object");
+  Position(1, 2, 3).SetParameters(parameters, "position");
+  Quaternion(1, 0, 0, 0).SetParameters(parameters, "rotation");
+  for (i = 0; i < 20; i++) parameters.Set("options.option" + StringFrom(i), (double)i);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    SelfRegisteringParametricObject *obj = deepfactory.Create(parameters);
+    valid += obj->IsObjectValid();
+    delete obj;
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)iterations;
+  WARN("Object instantiation (copying values): " << ns << "ns per object");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    SelfRegisteringParametricObject *obj = factory.Create(parameters);
+    valid += obj->IsObjectValid();
+    delete obj;
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)iterations;
+  WARN("Object instantiation (shared table): " << ns << "ns per object");
+
+  CHECK(valid == 2 * iterations);
+}
+
+TEST_CASE("messagetemplate")
+{
+  static const struct {
+    const char *format;
+    const char *allowempty;             // message generated with allowempty = true
+    const char *notempty;               // message generated with allowempty = false
+  } tests[] = {
+    {"plain", "plain", "plain"},
+    {"", "", ""},
+    {"{x}", "1.25000000000000000000000000000000", "1.25000000000000000000000000000000"},
+    {"{x:%0.3lf}", "1.250", "1.250"},
+    {"{index:+1:%u}", "5", "5"},
+    {"{index:-2:%d}", "2", "2"},
+    {"{neg:+1.5:%0.1lf}", "-1.5", "-1.5"},
+    {"{neg:%u}", "4294967293", "4294967293"},
+    {"{neg:%x}", "fffffffd", "fffffffd"},
+    {"{neg:%ld}", "-3", "-3"},
+    {"{id:%lx}", "1234abcd", "1234abcd"},
+    {"{id:%lu}", "305441741", "305441741"},
+    {"{name:%-10s}|", "violin    |", "violin    |"},
+    {"{name:%s}", "violin", "violin"},
+    {"{x:%s}", "1.25000000000000000000000000000000", "1.25000000000000000000000000000000"},
+    {"{muted?yes:no}", "no", "no"},
+    {"{on?yes:no}", "yes", "yes"},
+    {"{name?yes:no}", "violin", "violin"},
+    {"{missing?yes:no}", "", "{missing?yes:no}"},
+    {"{missing}", "", "{missing}"},
+    {"{missing:%d}", "", "{missing:%d}"},
+    {"{a.b}", "2", "2"},
+    {"{x:}", "1.25000000000000000000000000000000", "1.25000000000000000000000000000000"},
+    {"{x:+1}", "1.25000000000000000000000000000000", "1.25000000000000000000000000000000"},
+    {"{x:+1:}", "1.25000000000000000000000000000000", "1.25000000000000000000000000000000"},
+    {"{x:zzz}", "1.25000000000000000000000000000000", "1.25000000000000000000000000000000"},
+    {"{x?a}", "1.25000000000000000000000000000000", "1.25000000000000000000000000000000"},
+    {"{x:%0.1lf?q}", "1.2?q", "1.2?q"},
+    {"{{x}}", "}", "{{x}}"},
+    {"{x", "{x", "{x"},
+    {"x}", "x}", "x}"},
+    {"{}{x}{}", "1.25000000000000000000000000000000", "{}1.25000000000000000000000000000000{}"},
+    {"{sval:%d}", "12", "12"},
+    {"{sval:%0.2lf}", "12.00", "12.00"},
+    {"{name:%d}", "", ""},
+    {"a{x}b{neg}c{name}d", "a1.25000000000000000000000000000000b-3cviolind", "a1.25000000000000000000000000000000b-3cviolind"},
+    {"{muted:%d}", "0", "0"},
+    {"{x:%d}", "1", "1"},
+    {"{index:%0.2lf}", "4.00", "4.00"},
+  };
+  ParameterSet parameters;
+  MessageTemplate msgtemplate;
+  std::string msg;
+  uint_t i, mismatches = 0;
+
+  parameters.Set("index", 4U).Set("x", 1.25).Set("neg", -3).Set("name", "violin").Set("muted", false).Set("on", "true").Set("id", (ulong_t)0x1234abcdUL).Set("sval", "12abc").Set("a.b", 2);
+
+  for (i = 0; i < NUMBEROF(tests); i++)
+  {
+    msgtemplate.SetFormat(tests[i].format);
+    msgtemplate.Generate(parameters, msg, true);
+    mismatches += (msg != tests[i].allowempty);
+    msgtemplate.Generate(parameters, msg, false);
+    mismatches += (msg != tests[i].notempty);
+    mismatches += (parameters.GenerateMessage(tests[i].format, true)  != tests[i].allowempty);
+    mismatches += (parameters.GenerateMessage(tests[i].format, false) != tests[i].notempty);
+  }
+  CHECK(mismatches == 0);
+
+  // templates pick up changes to values and long values
+  MessageTemplate msgtemplate2("{name:%s} {x:%0.1lf} {missing}");
+  CHECK(msgtemplate2.Generate(parameters) == "violin 1.2 ");
+  parameters.Set("name", std::string(1000, 'a')).Set("missing", 3).Set("x", 1e300);
+  msg = msgtemplate2.Generate(parameters);
+  CHECK(msg.length() == 1000 + 1 + 303 + 1 + 1);
+  CHECK(msg.substr(995, 10) == "aaaaa 1000");
+
+  // one-off messages do not add names to the global key table
+  uint_t keycount = ParameterKeys::Get().GetCount();
+  CHECK(parameters.GenerateMessage("{name:%0.1s} {neverusedname1} {neverused.name2:%d}", false) == "a {neverusedname1} {neverused.name2:%d}");
+  CHECK(parameters.GenerateMessage("{neverusedname3?yes:no}", true) == "");
+  CHECK(ParameterKeys::Get().GetCount() == keycount);
+  CHECK(ParameterKeys::Get().Find("neverusedname1") == ParameterKeys::Invalid);
+}
+
+TEST_CASE("messagetemplatebenchmark", "[.][benchmark]")
+{
+  ParameterSet parameters;
+  const std::string format = "/object/{index:+1:%u}/position {x:%0.3lf} {y:%0.3lf} {z:%0.3lf} gain {gain:%0.2lf} {name:%-12s} {muted?muted:active} {id:%016lx} {missing}";
+  const uint_t iterations = 20000;
+  std::chrono::steady_clock::time_point start;
+  std::string msg;
+  double ns;
+  uint_t i, len = 0;
+
+  parameters.Set("index", 4U).Set("x", 1.25).Set("y", -2.5).Set("z", 0.125).Set("gain", 0.7071).Set("name", "violin").Set("muted", false).Set("id", (ulong_t)0x1234abcdUL);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    msg = parameters.GenerateMessage(format, false);
+    len += (uint_t)msg.length();
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)iterations;
+  WARN("GenerateMessage(): " << ns << "ns per message");
+
+  MessageTemplate msgtemplate(format);
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    msgtemplate.Generate(parameters, msg, false);
+    len += (uint_t)msg.length();
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)iterations;
+  WARN("MessageTemplate::Generate(): " << ns << "ns per message");
+
+  CHECK(len == 2 * iterations * msg.length());
+}
+
+TEST_CASE("parameterkeys")
+{
+  ParameterKeys& keys = ParameterKeys::Get();
+  ParameterKeys::KEY key = keys.Intern("parameterkeys.test.name");
+  const uint_t nthreads = 4, n = 3000;
+  std::vector<std::thread> threads;
+  std::vector<std::vector<ParameterKeys::KEY> > results(nthreads);
+  uint_t i, j, mismatches = 0;
+
+  REQUIRE(key != ParameterKeys::Invalid);
+  CHECK(keys.Find("parameterkeys.test.name") == key);
+  CHECK(keys.GetName(key) == "parameterkeys.test.name");
+  CHECK(keys.GetName(keys.GetParent(key)) == "parameterkeys.test");
+  CHECK(keys.GetParent(keys.GetParent(keys.GetParent(key))) == ParameterKeys::Invalid);
+  CHECK(keys.Find("parameterkeys.never.interned") == ParameterKeys::Invalid);
+
+  // concurrent interning of the same names must give the same keys
+  for (i = 0; i < nthreads; i++)
+  {
+    threads.push_back(std::thread([&keys, &results, i, n]() {
+          uint_t j;
+          for (j = 0; j < n; j++) results[i].push_back(keys.Intern("parameterkeys.threads." + StringFrom(j % 100) + "." + StringFrom(j)));
+        }));
+  }
+  for (i = 0; i < nthreads; i++) threads[i].join();
+
+  for (i = 0; i < nthreads; i++)
+  {
+    for (j = 0; j < n; j++)
+    {
+      mismatches += (results[i][j] != results[0][j]);
+      mismatches += (keys.GetName(results[i][j]) != "parameterkeys.threads." + StringFrom(j % 100) + "." + StringFrom(j));
+    }
+  }
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("parameterkeysreclaim")
+{
+  ParameterKeys& keys = ParameterKeys::Get();
+  const uint_t keycount = keys.GetCount();
+  const uint_t maxcount = 2 * keycount + 2048;   // table may double in size before unreferenced names are removed
+  const uint_t nthreads = 4, n = 20000;
+  std::vector<std::thread> threads;
+  std::vector<uint_t> errors(nthreads);
+  ParameterKeys::KEY key;
+  uint_t i, count = 0, mismatches = 0;
+
+  // released names are kept until unreferenced names are removed
+  key = keys.Intern("reclaimtest.transient.name");
+  REQUIRE(key != ParameterKeys::Invalid);
+  CHECK(keys.GetCount() == keycount + 3);
+  keys.Release(key);
+  CHECK(keys.Intern("reclaimtest.transient.name") == key);
+  keys.Release(key);
+
+  // many unique names that are only used briefly (e.g. from JSON input) do not accumulate
+  for (i = 0; i < 200000; i++)
+  {
+    ParameterSet parameters;
+    sint_t val = -1;
+
+    parameters.Set("transient." + StringFrom(i) + ".value", (sint_t)i);
+    count = std::max(count, keys.GetCount());
+    mismatches += (!parameters.Get("transient." + StringFrom(i) + ".value", val) || (val != (sint_t)i));
+  }
+  CHECK(mismatches == 0);
+  CHECK(count <= maxcount);
+  CHECK(keys.Find("transient.0.value") == ParameterKeys::Invalid);
+  CHECK(keys.Find("reclaimtest.transient.name") == ParameterKeys::Invalid);
+
+  // deleted values do not keep their names or table entries
+  {
+    ParameterSet parameters;
+
+    parameters.Set("churn.kept", 1);
+    for (i = 0; i < 200000; i++)
+    {
+      std::string name = "churn." + StringFrom(i);
+
+      parameters.Set(name, (sint_t)i);
+      mismatches += !parameters.Delete(name);
+      count = std::max(count, keys.GetCount());
+    }
+    CHECK(mismatches == 0);
+    CHECK(count <= maxcount);
+    CHECK(parameters.ToString() == "churn.kept 1");
+  }
+
+  // names added and removed whilst other threads look up shared and transient names
+  {
+    ParameterSet shared;
+
+    shared.Set("reclaim.shared.value", 42);
+    for (i = 0; i < nthreads; i++)
+    {
+      threads.push_back(std::thread([&shared, &errors, i, n]() {
+            uint_t j;
+            for (j = 0; j < n; j++)
+            {
+              ParameterSet parameters(shared);
+              std::string  prefix = "reclaim." + StringFrom(i) + "." + StringFrom(j);
+              sint_t val = 0;
+
+              parameters.Set(prefix + ".value", (sint_t)j);
+              errors[i] += (!parameters.Get(prefix + ".value", val) || (val != (sint_t)j));
+              errors[i] += (!parameters.Get("reclaim.shared.value", val) || (val != 42));
+              errors[i] += (ParameterSetView(parameters, prefix).ToString() != ("value " + StringFrom(j)));
+            }
+          }));
+    }
+    for (i = 0; i < nthreads; i++) threads[i].join();
+    for (i = 0; i < nthreads; i++) CHECK(errors[i] == 0);
+  }
+  CHECK(keys.GetCount() <= maxcount);
+}
+
+TEST_CASE("parametersetbenchmark", "[.][benchmark]")
+{
+  ParameterSet parameters;
+  const uint_t iterations = 100000;
+  std::chrono::steady_clock::time_point start;
+  double ns, dval = 0.0, sum = 0.0;
+  sint_t sval = 0;
+  uint_t i;
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    // previous implementation: every value formatted and parsed as a string
+    parameters.Set("gain", StringFrom((double)i * 0.5));
+    parameters.Set("channel", StringFrom((sint_t)i));
+    Evaluate(parameters.Raw("gain"), dval);
+    Evaluate(parameters.Raw("channel"), sval);
+    sum += dval + (double)sval;
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(2 * iterations);
+  WARN("Set/Get via strings: " << ns << "ns per value");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    parameters.Set("gain", (double)i * 0.5);
+    parameters.Set("channel", (sint_t)i);
+    parameters.Get("gain", dval);
+    parameters.Get("channel", sval);
+    sum -= dval + (double)sval;
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(2 * iterations);
+  WARN("Set/Get native: " << ns << "ns per value");
+
+  CHECK(sum == 0.0);
+
+  // large configuration: 100 objects of 50 parameters each
+  std::map<std::string,ParameterValue> map;
+  std::vector<std::string> names;
+  const uint_t nobjects = 100, nparameters = 50, subiterations = 100;
+  uint_t j, found = 0;
+
+  parameters.Clear();
+  for (i = 0; i < nobjects; i++)
+  {
+    for (j = 0; j < nparameters; j++)
+    {
+      std::string name = "objects." + StringFrom(i) + ".param" + StringFrom(j);
+      parameters.Set(name, (double)j);
+      map[name] = ParameterValue((double)j);
+      names.push_back(name);
+    }
+  }
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < subiterations; i++)
+  {
+    for (j = 0; j < names.size(); j++) found += (map.find(names[j]) != map.end());
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(subiterations * names.size());
+  WARN("Lookup (std::map): " << ns << "ns per value");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < subiterations; i++)
+  {
+    for (j = 0; j < names.size(); j++) found += parameters.Exists(names[j]);
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(subiterations * names.size());
+  WARN("Lookup (interned): " << ns << "ns per value");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < subiterations; i++)
+  {
+    // scan and copy as a std::map based set would
+    std::string prefix = "objects." + StringFrom(i % nobjects) + ".";
+    std::map<std::string,ParameterValue> sub;
+    std::map<std::string,ParameterValue>::const_iterator it;
+
+    for (it = map.begin(); it != map.end(); ++it)
+    {
+      if (it->first.find(prefix) == 0) sub[it->first.substr(prefix.length())] = it->second;
+    }
+    found += (uint_t)sub.size();
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)subiterations;
+  WARN("GetSubParameters() (std::map scan): " << ns << "ns per object");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < subiterations; i++)
+  {
+    ParameterSet sub;
+
+    parameters.GetSubParameters(sub, "objects." + StringFrom(i % nobjects));
+    found += sub.IsEmpty() ? 0 : nparameters;
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)subiterations;
+  WARN("GetSubParameters() (tree): " << ns << "ns per object");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < subiterations; i++)
+  {
+    ParameterSetView view(parameters, "objects." + StringFrom(i % nobjects));
+    ParameterSet::Iterator it;
+
+    for (it = view.GetBegin(); it != view.GetEnd(); ++it) found++;
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)subiterations;
+  WARN("ParameterSetView iteration: " << ns << "ns per object");
+
+  // reading a position from a large set
+  Position pos;
+  for (i = 0; i < nobjects; i++) Position(i, 1, 2).SetParameters(parameters, "objects." + StringFrom(i) + ".position");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < subiterations; i++)
+  {
+    // copy then read as previous implementation of GetFromParameters() did
+    ParameterSet sub = parameters.GetSubParameters("objects." + StringFrom(i % nobjects) + ".position");
+    found += (sub.Get("x", pos.pos.x) && sub.Get("y", pos.pos.y) && sub.Get("z", pos.pos.z));
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)subiterations;
+  WARN("Position from copy: " << ns << "ns per position");
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < subiterations; i++)
+  {
+    found += pos.GetFromParameters(parameters, "objects." + StringFrom(i % nobjects) + ".position");
+  }
+  ns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)subiterations;
+  WARN("Position::GetFromParameters(): " << ns << "ns per position");
+
+  CHECK(found == subiterations * (2 * names.size() + 3 * nparameters + 2));
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,365 @@
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include <catch/catch.hpp>
+
+#include "PositionBatch.h"
+
+BBC_AUDIOTOOLBOX_START
+
+static void GenerateRandomPositions(std::vector<Position>& positions, uint_t n, bool polar)
+{
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> coord(-10.0, 10.0), az(-180.0, 180.0), el(-90.0, 90.0), d(0.0, 10.0);
+  uint_t i;
+
+  positions.resize(n);
+  for (i = 0; i < n; i++)
+  {
+    Position& pos = positions[i];
+
+    pos.polar = polar;
+    if (polar)
+    {
+      pos.pos.az = az(rng);
+      pos.pos.el = el(rng);
+      pos.pos.d  = d(rng);
+    }
+    else
+    {
+      pos.pos.x = coord(rng);
+      pos.pos.y = coord(rng);
+      pos.pos.z = coord(rng);
+    }
+  }
+
+  // include some special cases
+  if (n >= 3)
+  {
+    // origin
+    positions[0] = Position();
+    positions[0].polar = polar;
+    // on the z axis (azimuth undefined)
+    positions[1] = Position(0.0, 0.0, 2.0);
+    if (polar) positions[1] = positions[1].Polar();
+    positions[2] = Position(0.0, 0.0, -1.0);
+    if (polar) positions[2] = positions[2].Polar();
+  }
+}
+
+static bool CompareElements(const Position& pos1, const Position& pos2)
+{
+  return ((pos1.polar == pos2.polar) &&
+          (pos1.pos.elements[0] == pos2.pos.elements[0]) &&
+          (pos1.pos.elements[1] == pos2.pos.elements[1]) &&
+          (pos1.pos.elements[2] == pos2.pos.elements[2]));
+}
+
+TEST_CASE("positionbatch")
+{
+  std::vector<Position> positions;
+  std::vector<double>   dist;
+  uint_t i, errors;
+
+  SECTION("tocart")
+  {
+    GenerateRandomPositions(positions, 1000, true);
+
+    PositionBatch batch(positions, true);
+    batch.ToCart();
+    CHECK(!batch.IsPolar());
+
+    for (i = errors = 0; i < positions.size(); i++) errors += !CompareElements(batch.Get(i), positions[i].Cart());
+    CHECK(errors == 0);
+  }
+
+  SECTION("topolar")
+  {
+    GenerateRandomPositions(positions, 1000, false);
+
+    PositionBatch batch(positions);
+    batch.ToPolar();
+    CHECK(batch.IsPolar());
+
+    for (i = errors = 0; i < positions.size(); i++) errors += !CompareElements(batch.Get(i), positions[i].Polar());
+    CHECK(errors == 0);
+  }
+
+  SECTION("normalise and distance")
+  {
+    Position from(1.0, -2.0, 0.5);
+
+    GenerateRandomPositions(positions, 1000, false);
+
+    PositionBatch batch(positions);
+    dist.resize(batch.Size());
+
+    batch.GetDistances(&dist[0]);
+    for (i = errors = 0; i < positions.size(); i++) errors += (dist[i] != positions[i].Mod());
+    CHECK(errors == 0);
+
+    batch.GetDistances(from, &dist[0]);
+    for (i = errors = 0; i < positions.size(); i++) errors += (fabs(dist[i] - (positions[i] - from).Mod()) > 1.0e-12);
+    CHECK(errors == 0);
+
+    batch.Normalise();
+    for (i = errors = 0; i < positions.size(); i++) errors += (fabs(batch.Get(i).Mod() - ((positions[i].Mod() > 0.0) ? 1.0 : 0.0)) > 1.0e-12);
+    CHECK(errors == 0);
+  }
+}
+
+static bool ComparePositions(const Position& pos1, const Position& pos2, double tol = 1.0e-12)
+{
+  Position p1 = pos1.Cart(), p2 = pos2.Cart();
+
+  return ((fabs(p1.pos.x - p2.pos.x) <= tol) &&
+          (fabs(p1.pos.y - p2.pos.y) <= tol) &&
+          (fabs(p1.pos.z - p2.pos.z) <= tol));
+}
+
+TEST_CASE("positionbatchrotation")
+{
+  std::vector<Position> positions;
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<double> coeff(-1.0, 1.0);
+  uint_t i, j, errors = 0;
+
+  // odd number of positions to exercise SIMD remainder handling
+  GenerateRandomPositions(positions, 1001, false);
+
+  for (i = 0; i < 20; i++)
+  {
+    Quaternion q = Quaternion(coeff(rng), coeff(rng), coeff(rng), coeff(rng)).Normalised();
+    double matrix[3][3];
+
+    // matrix must be equivalent to Quaternion algebra
+    q.ToRotationMatrix(matrix);
+    errors += !ComparePositions(positions[3] * matrix, positions[3] * q);
+    q.ToInverseRotationMatrix(matrix);
+    errors += !ComparePositions(positions[3] * matrix, positions[3] / q);
+
+    PositionBatch batch(positions);
+    batch *= q;
+    for (j = 0; j < positions.size(); j++) errors += !ComparePositions(batch.Get(j), positions[j] * q);
+
+    batch /= q;
+    for (j = 0; j < positions.size(); j++) errors += !ComparePositions(batch.Get(j), positions[j]);
+
+    // polar batches remain polar
+    PositionBatch polarbatch(positions, true);
+    polarbatch *= q;
+    CHECK(polarbatch.IsPolar());
+    for (j = 0; j < positions.size(); j++) errors += !ComparePositions(polarbatch.Get(j), positions[j] * q, 1.0e-9);
+  }
+
+  CHECK(errors == 0);
+}
+
+TEST_CASE("positionbatchtransform")
+{
+  std::vector<Position> positions;
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> coeff(-1.0, 1.0);
+  PositionTransform trans;
+  uint_t i, j, errors = 0;
+
+  GenerateRandomPositions(positions, 257, false);
+
+  for (i = 0; i < 20; i++)
+  {
+    // modify public members directly: cached matrices must follow
+    trans.pretranslation  = Position(coeff(rng), coeff(rng), coeff(rng));
+    trans.rotation        = Quaternion(coeff(rng), coeff(rng), coeff(rng), coeff(rng)).Normalised();
+    trans.posttranslation = Position(coeff(rng), coeff(rng), coeff(rng));
+    if (i & 1) trans.posttranslation = trans.posttranslation.Polar();
+
+    PositionBatch batch(positions);
+    batch *= trans;
+    for (j = 0; j < positions.size(); j++) errors += !ComparePositions(batch.Get(j), positions[j] * trans, 1.0e-9);
+
+    batch /= trans;
+    for (j = 0; j < positions.size(); j++) errors += !ComparePositions(batch.Get(j), positions[j], 1.0e-9);
+
+    trans.rotation *= Quaternion(30.0, ZAxis);
+    trans.ApplyTransform(batch);
+    for (j = 0; j < positions.size(); j++) errors += !ComparePositions(batch.Get(j), positions[j] * trans, 1.0e-9);
+  }
+
+  CHECK(errors == 0);
+}
+
+TEST_CASE("positionbatchtransformthreads")
+{
+  std::vector<Position> positions;
+  PositionTransform trans;
+  uint_t i, errors[4] = {0};
+
+  GenerateRandomPositions(positions, 64, false);
+  trans.pretranslation  = Position(0.1, 0.2, 0.3);
+  trans.rotation        = Quaternion(30.0, ZAxis) * Quaternion(-15.0, XAxis);
+  trans.posttranslation = Position(-0.3, 0.2, -0.1);
+
+  // a const transform shared between threads must always give the same results
+  const PositionTransform& shared = trans;
+  std::vector<std::thread> threads;
+  for (i = 0; i < NUMBEROF(errors); i++)
+  {
+    threads.push_back(std::thread([&, i]() {
+          uint_t j, k;
+
+          for (j = 0; j < 200; j++)
+          {
+            PositionBatch batch(positions);
+
+            batch *= shared;
+            for (k = 0; k < positions.size(); k++) errors[i] += !ComparePositions(batch.Get(k), positions[k] * shared, 1.0e-9);
+            batch /= shared;
+            for (k = 0; k < positions.size(); k++) errors[i] += !ComparePositions(batch.Get(k), positions[k], 1.0e-9);
+          }
+        }));
+  }
+  for (i = 0; i < threads.size(); i++) threads[i].join();
+
+  for (i = 0; i < NUMBEROF(errors); i++) CHECK(errors[i] == 0);
+}
+
+TEST_CASE("positionbatchscreen")
+{
+  std::vector<Position> positions;
+  std::vector<double> z, scales;
+  ScreenTransform trans;
+  uint_t i, j, errors = 0;
+
+  trans.cx   = 0.2;
+  trans.cy   = -0.1;
+  trans.sx   = 1.5;
+  trans.sy   = 0.75;
+  trans.dist = 20.0;
+
+  for (i = 0; i < 2; i++)
+  {
+    GenerateRandomPositions(positions, 257, (i == 1));
+
+    PositionBatch batch(positions);
+    batch *= trans;
+    for (j = 0; j < positions.size(); j++) errors += !ComparePositions(batch.Get(j), positions[j] * trans, 1.0e-9);
+
+    trans.RemoveTransform(batch);
+    for (j = 0; j < positions.size(); j++) errors += !ComparePositions(batch.Get(j), positions[j], 1.0e-9);
+  }
+
+  // positions at the perspective distance are not scaled (positions[1] has z = 2)
+  trans.dist = 2.0;
+  GenerateRandomPositions(positions, 16, false);
+  for (i = 3; i < positions.size(); i++) positions[i].pos.z = (i & 1) ? 2.0 : 0.5 * positions[i].pos.z;
+
+  PositionBatch batch(positions);
+  trans.ApplyTransform(batch);
+  for (j = 0; j < positions.size(); j++) errors += !ComparePositions(batch.Get(j), positions[j] * trans, 1.0e-9);
+
+  batch /= trans;
+  for (j = 0; j < positions.size(); j++) errors += !ComparePositions(batch.Get(j), positions[j], 1.0e-9);
+
+  // array of distance scales must match individual calls exactly
+  for (j = 0; j < positions.size(); j++) z.push_back(positions[j].pos.z);
+  scales.resize(z.size());
+  trans.GetDistanceScales(&z[0], &scales[0], z.size());
+  for (j = 0; j < z.size(); j++) errors += (scales[j] != trans.GetDistanceScale(z[j]));
+
+  CHECK(errors == 0);
+}
+
+TEST_CASE("positionbatchbenchmark", "[.][benchmark]")
+{
+  const uint_t n = 4096, iterations = 200;
+  std::vector<Position> positions, output(n);
+  std::chrono::steady_clock::time_point start;
+  PositionBatch batch;
+  double objectns, batchns;
+  uint_t i, j;
+
+  GenerateRandomPositions(positions, n, true);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) output[j] = positions[j].Cart().Polar();
+  }
+  objectns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  batch.Set(positions);
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    batch.ToCart();
+    batch.ToPolar();
+  }
+  batchns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  WARN("Per-object polar->cart->polar: " << objectns << "ns per position");
+  WARN("PositionBatch polar->cart->polar: " << batchns << "ns per position");
+
+  Quaternion q = Quaternion(0.3, 0.2, -0.5, 0.1).Normalised();
+
+  GenerateRandomPositions(positions, n, false);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) output[j] = positions[j] * q;
+  }
+  objectns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  PositionBatch cartbatch(positions);
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++) cartbatch *= q;
+  batchns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  WARN("Per-object Quaternion rotation: " << objectns << "ns per position");
+  WARN("PositionBatch Quaternion rotation: " << batchns << "ns per position");
+
+  PositionTransform trans(q);
+  trans.pretranslation  = Position(0.1, 0.2, 0.3);
+  trans.posttranslation = Position(-0.5, 0.0, 1.0);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) output[j] = positions[j] * trans;
+  }
+  objectns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++) cartbatch *= trans;
+  batchns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  WARN("Per-object PositionTransform: " << objectns << "ns per position");
+  WARN("PositionBatch PositionTransform: " << batchns << "ns per position");
+
+  ScreenTransform screen;
+  screen.sx   = 1.5;
+  screen.sy   = 0.75;
+  screen.dist = 20.0;
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < n; j++) output[j] = positions[j] * screen;
+  }
+  objectns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+
+  cartbatch.Set(positions);
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    cartbatch *= screen;
+    cartbatch /= screen;
+  }
+  batchns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(2 * n * iterations);
+
+  WARN("Per-object ScreenTransform: " << objectns << "ns per position");
+  WARN("PositionBatch ScreenTransform: " << batchns << "ns per position");
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,156 @@
+#include <thread>
+#include <chrono>
+#include <vector>
+
+#include <catch/catch.hpp>
+
+#include "RefCount.h"
+
+BBC_AUDIOTOOLBOX_START
+
+class TestRefCountedObject : public RefCountedObject
+{
+public:
+  TestRefCountedObject(std::atomic<uint_t>& _deletions) : RefCountedObject(),
+                                                          deletions(_deletions) {}
+  virtual ~TestRefCountedObject() {deletions++;}
+
+protected:
+  std::atomic<uint_t>& deletions;
+};
+
+TEST_CASE("refcount")
+{
+  std::atomic<uint_t> deletions(0);
+
+  SECTION("copy and move")
+  {
+    RefCount<TestRefCountedObject> ref1(new TestRefCountedObject(deletions));
+    CHECK(!ref1.Obj()->IsShared());
+
+    RefCount<TestRefCountedObject> ref2(ref1);
+    CHECK(ref1.Obj()->IsShared());
+
+    RefCount<TestRefCountedObject> ref3(std::move(ref2));
+    CHECK(ref2.Obj() == NULL);
+    CHECK(ref3.Obj() == ref1.Obj());
+    CHECK(ref1.Obj()->IsShared());
+
+    ref1 = std::move(ref3);
+    CHECK(ref3.Obj() == NULL);
+    CHECK(!ref1.Obj()->IsShared());
+    CHECK(deletions == 0);
+
+    ref1 = NULL;
+    CHECK(deletions == 1);
+  }
+
+  SECTION("weak")
+  {
+    WeakRefCount<TestRefCountedObject> weak;
+    CHECK(weak.Expired());
+    {
+      RefCount<TestRefCountedObject> ref(new TestRefCountedObject(deletions));
+
+      weak = ref;
+      CHECK(!weak.Expired());
+
+      RefCount<TestRefCountedObject> ref2 = weak.Lock();
+      CHECK(ref2.Obj() == ref.Obj());
+      CHECK(ref.Obj()->IsShared());
+    }
+    CHECK(deletions == 1);
+    CHECK(weak.Expired());
+    CHECK(weak.Lock().Obj() == NULL);
+  }
+
+  SECTION("weak prevent deletion")
+  {
+    TestRefCountedObject obj(deletions);
+    WeakRefCount<TestRefCountedObject> weak(&obj);
+
+    obj.PreventDeletion();
+
+    // without a strong reference the object may be being destroyed so cannot be locked
+    CHECK(weak.Expired());
+    CHECK(weak.Lock().Obj() == NULL);
+    {
+      RefCount<TestRefCountedObject> ref(&obj);
+
+      CHECK(!weak.Expired());
+      CHECK(weak.Lock().Obj() == &obj);
+    }
+    CHECK(deletions == 0);
+    CHECK(weak.Expired());
+  }
+
+  SECTION("threaded")
+  {
+    const uint_t nthreads = 4, iterations = 10000;
+    std::vector<std::thread> threads;
+    WeakRefCount<TestRefCountedObject> weak;
+    uint_t i;
+
+    {
+      RefCount<TestRefCountedObject> ref(new TestRefCountedObject(deletions));
+
+      weak = ref;
+      for (i = 0; i < nthreads; i++)
+      {
+        threads.push_back(std::thread([ref, weak]() {
+              uint_t j;
+              for (j = 0; j < iterations; j++)
+              {
+                RefCount<TestRefCountedObject> copy(ref);
+                RefCount<TestRefCountedObject> locked = weak.Lock();
+                RefCount<TestRefCountedObject> moved(std::move(copy));
+              }
+            }));
+      }
+    }
+
+    // last strong reference may be released by any thread
+    for (i = 0; i < threads.size(); i++) threads[i].join();
+
+    CHECK(deletions == 1);
+    CHECK(weak.Lock().Obj() == NULL);
+  }
+}
+
+static double SharingBenchmark(bool move)
+{
+  const uint_t nthreads = 4, iterations = 1000000;
+  std::atomic<uint_t> deletions(0);
+  RefCount<TestRefCountedObject> ref(new TestRefCountedObject(deletions));
+  std::vector<std::thread> threads;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint_t i;
+
+  for (i = 0; i < nthreads; i++)
+  {
+    threads.push_back(std::thread([ref, move]() {
+          RefCount<TestRefCountedObject> a(ref), b;
+          uint_t j;
+          for (j = 0; j < iterations; j++)
+          {
+            // copying must increment and decrement the shared count, moving does neither
+            if (move) {b = std::move(a); a = std::move(b);}
+            else      {b = a; b = NULL;}
+          }
+        }));
+  }
+  for (i = 0; i < threads.size(); i++) threads[i].join();
+
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(2 * nthreads * iterations);
+}
+
+TEST_CASE("refcountbenchmark", "[.][benchmark]")
+{
+  double copyns = SharingBenchmark(false);
+  double movens = SharingBenchmark(true);
+
+  WARN("Contended RefCount copy: " << copyns << "ns per assignment");
+  WARN("Contended RefCount move: " << movens << "ns per assignment");
+}
+
+BBC_AUDIOTOOLBOX_END
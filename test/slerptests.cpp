@@ -0,0 +1,112 @@
+#include <chrono>
+#include <random>
+
+#include <catch/catch.hpp>
+
+#include "3DPosition.h"
+
+BBC_AUDIOTOOLBOX_START
+
+static double Difference(const Quaternion& q0, const Quaternion& q1)
+{
+  return std::max(std::max(fabs(q0.w - q1.w), fabs(q0.x - q1.x)), std::max(fabs(q0.y - q1.y), fabs(q0.z - q1.z)));
+}
+
+static Quaternion RandomRotation(std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> coord(-1.0, 1.0), angle(-180.0, 180.0);
+  return Quaternion(angle(rng), Position(coord(rng), coord(rng), coord(rng)).Unit());
+}
+
+TEST_CASE("slerpgenerator")
+{
+  std::mt19937 rng(7);
+  uint_t i, j, unfinished = 0;
+  double maxerr = 0.0, maxmatrixerr = 0.0;
+
+  for (i = 0; i < 50; i++)
+  {
+    Quaternion q0 = RandomRotation(rng);
+    // include pairs close together (linear interpolation) and far apart (negation)
+    Quaternion q1 = (i & 1) ? q0 * Quaternion(0.5, Position(0.0, 0.0, 1.0)) : RandomRotation(rng);
+    const uint_t steps = 1000 + i * 97;
+    SlerpGenerator gen(q0, q1, steps);
+
+    for (j = 0; j <= steps; j++)
+    {
+      Quaternion expected = Slerp(q0, q1, (double)j / (double)steps);
+
+      if ((j % 128) == 5)
+      {
+        double matrix[1][3][3], expmatrix[3][3];
+        uint_t k, l;
+
+        gen.Generate(matrix, 1);
+        expected.ToRotationMatrix(expmatrix);
+        for (k = 0; k < 3; k++)
+        {
+          for (l = 0; l < 3; l++) maxmatrixerr = std::max(maxmatrixerr, fabs(matrix[0][k][l] - expmatrix[k][l]));
+        }
+      }
+      else maxerr = std::max(maxerr, Difference(gen.Next(), expected));
+    }
+
+    // generator should stay at final orientation
+    unfinished += !gen.Finished();
+    maxerr = std::max(maxerr, Difference(gen.Next(), Slerp(q0, q1, 1.0)));
+  }
+  CHECK(unfinished == 0);
+  CHECK(maxerr < 1.0e-10);
+  CHECK(maxmatrixerr < 1.0e-10);
+}
+
+TEST_CASE("slerpbatch")
+{
+  std::mt19937 rng(8);
+  const uint_t n = 1000;
+  std::vector<Quaternion> q0(n), q1(n), res(n);
+  uint_t i;
+  double maxerr = 0.0;
+
+  for (i = 0; i < n; i++)
+  {
+    q0[i] = RandomRotation(rng);
+    q1[i] = (i & 1) ? q0[i] * Quaternion(2.0, Position(0.0, 1.0, 0.0)) : RandomRotation(rng);
+  }
+
+  Slerp(&q0[0], &q1[0], 0.3, &res[0], n);
+  for (i = 0; i < n; i++) maxerr = std::max(maxerr, Difference(res[i], Slerp(q0[i], q1[i], 0.3)));
+  CHECK(maxerr < 1.0e-12);
+}
+
+TEST_CASE("slerpbenchmark", "[.][benchmark]")
+{
+  std::mt19937 rng(9);
+  const uint_t steps = 48000, iterations = 20;
+  std::vector<Quaternion> res(steps);
+  std::chrono::steady_clock::time_point start;
+  Quaternion q0 = RandomRotation(rng), q1 = RandomRotation(rng);
+  SlerpGenerator gen;
+  double slerpns, genns;
+  uint_t i, j;
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    for (j = 0; j < steps; j++) res[j] = Slerp(q0, q1, (double)j / (double)steps);
+  }
+  slerpns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(steps * iterations);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < iterations; i++)
+  {
+    gen.Start(q0, q1, steps);
+    gen.Generate(&res[0], steps);
+  }
+  genns = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(steps * iterations);
+
+  WARN("Slerp(): " << slerpns << "ns per step");
+  WARN("SlerpGenerator: " << genns << "ns per step");
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,94 @@
+#include <thread>
+#include <chrono>
+
+#include <catch/catch.hpp>
+
+#include "ThreadLock.h"
+
+BBC_AUDIOTOOLBOX_START
+
+static bool FindStats(const std::string& name, ThreadLockObject::STATS& stats)
+{
+  std::vector<ThreadLockObject::STATS> list;
+  uint_t i;
+
+  ThreadLockObject::GetInstrumentationStats(list);
+
+  for (i = 0; i < list.size(); i++)
+  {
+    if (list[i].name == name)
+    {
+      stats = list[i];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+TEST_CASE("threadlockinstrumentation")
+{
+  ThreadLockObject::STATS stats;
+
+  ThreadLockObject::ResetInstrumentationStats();
+
+  {
+    ThreadLockObject tlock("test.uncontended");
+
+    // instrumentation disabled: nothing should be recorded
+    {
+      ThreadLock lock(tlock);
+    }
+    REQUIRE(FindStats("test.uncontended", stats));
+    CHECK(stats.acquisitions == 0);
+
+    ThreadLockObject::EnableInstrumentation();
+
+    // recursive locks only count once
+    {
+      ThreadLock lock1(tlock);
+      ThreadLock lock2(tlock);
+    }
+    tlock.Lock();
+    tlock.Unlock();
+
+    REQUIRE(FindStats("test.uncontended", stats));
+    CHECK(stats.acquisitions == 2);
+    CHECK(stats.contentions == 0);
+    CHECK(stats.totalwait == 0);
+  }
+
+  // statistics should be retained after lock has been destroyed
+  REQUIRE(FindStats("test.uncontended", stats));
+  CHECK(stats.acquisitions == 2);
+
+  {
+    ThreadLockObject   tlock("test.contended");
+    ThreadBoolSignalObject locked;
+    std::thread        thread([&]() {
+        ThreadLock lock(tlock);
+        locked.Signal();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      });
+
+    // wait for thread to take lock then attempt to lock it
+    locked.Wait();
+    {
+      ThreadLock lock(tlock);
+    }
+    thread.join();
+
+    REQUIRE(FindStats("test.contended", stats));
+    CHECK(stats.acquisitions == 2);
+    CHECK(stats.contentions == 1);
+    CHECK(stats.totalwait > 0);
+    CHECK(stats.maxhold > 0);
+  }
+
+  CHECK(ThreadLockObject::GetInstrumentationReport().find("test.contended") < std::string::npos);
+
+  ThreadLockObject::EnableInstrumentation(false);
+  ThreadLockObject::ResetInstrumentationStats();
+}
+
+BBC_AUDIOTOOLBOX_END
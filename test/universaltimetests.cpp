@@ -0,0 +1,138 @@
+#include <thread>
+#include <random>
+
+#include <catch/catch.hpp>
+
+#include "UniversalTime.h"
+
+BBC_AUDIOTOOLBOX_START
+
+class TestTimebaseReceiver : public UniversalTimeUpdateReceiver
+{
+public:
+  TestTimebaseReceiver() : updates(0) {}
+
+  virtual void TimebaseUpdated(const UniversalTime *timebase) {UNUSED_PARAMETER(timebase); updates++;}
+
+  std::atomic<uint_t> updates;
+};
+
+TEST_CASE("universaltime")
+{
+  UniversalTime timebase(48000);
+  UniversalTime::SNAPSHOT snapshot;
+  TestTimebaseReceiver receiver;
+
+  timebase.AddUpdateReceiver(&receiver);
+  timebase.AddUpdateReceiver(&receiver);
+
+  timebase += 48000;
+  CHECK(timebase.GetTime() == 1000000000ULL);
+  CHECK(receiver.updates == 1);
+
+  timebase.AddNanoSeconds(500);
+  timebase.GetSnapshot(snapshot);
+  CHECK(snapshot.current     == 1000000500ULL);
+  CHECK(snapshot.offset      == 500);
+  CHECK(snapshot.numerator   == 48000);
+  CHECK(snapshot.denominator == 48000);
+  CHECK(receiver.updates == 2);
+
+  timebase.SetDenominator(96000);
+  timebase += 48000;
+  CHECK(timebase.GetTime() == 1500000500ULL);
+  CHECK(timebase.GetRawTime() == 48000);
+
+  UniversalTime copy(timebase);
+  CHECK(copy.GetTime() == timebase.GetTime());
+
+  // reset recalculates the time and notifies receivers
+  copy.AddUpdateReceiver(&receiver);
+  copy.Reset();
+  copy.GetSnapshot(snapshot);
+  CHECK(snapshot.current   == 0);
+  CHECK(snapshot.offset    == 0);
+  CHECK(snapshot.numerator == 0);
+  CHECK(receiver.updates == 5);
+  copy.RemoveUpdateReceiver(&receiver);
+
+  timebase.RemoveUpdateReceiver(&receiver);
+  timebase += 1;
+  CHECK(receiver.updates == 5);
+
+  SECTION("concurrent")
+  {
+    const uint_t iterations = 100000;
+    TestTimebaseReceiver receiver2;
+    std::atomic<bool> stop(false);
+    uint_t inconsistent = 0;
+    std::thread writer([&]() {
+        uint_t i;
+        for (i = 0; i < iterations; i++)
+        {
+          timebase += 1;
+          if (!(i % 1000)) timebase.SetDenominator((i & 1000) ? 48000 : 96000);
+        }
+        stop = true;
+      });
+    std::thread registrar([&]() {
+        while (!stop)
+        {
+          timebase.AddUpdateReceiver(&receiver2);
+          timebase.RemoveUpdateReceiver(&receiver2);
+        }
+      });
+
+    // every snapshot must satisfy current = offset + 1e9 * numerator / denominator
+    while (!stop)
+    {
+      timebase.GetSnapshot(snapshot);
+      if (snapshot.current != (snapshot.offset + (1000000000ULL * snapshot.numerator) / snapshot.denominator)) inconsistent++;
+    }
+    writer.join();
+    registrar.join();
+
+    CHECK(inconsistent == 0);
+  }
+}
+
+TEST_CASE("universaltimeexact")
+{
+  // 48 hours of samples at 192kHz (more than 2^64 / (1e9 * 192000) = ~26.7 hours) overflows
+  // 1e9 * num in 64 bits, as does the inverse (ns * 192000)
+  UniversalTime timebase(192000);
+
+  timebase += 192000ULL * 3600 * 48 + 1;
+  CHECK(timebase.GetTime() == 172800000005208ULL);
+  CHECK(timebase.Calc(192000ULL * 3600 * 48 + 1) == 172800000005208ULL);
+  CHECK(timebase.Invert(172800000005209ULL) == 192000ULL * 3600 * 48 + 1);
+
+#ifdef __SIZEOF_INT128__
+  static const uint64_t denominators[] = {
+    1, 2, 3, 7, 1000, 44100, 48000, 96000, 192000, 1000000000ULL,
+    18446744073ULL, 18446744074ULL, 0x8000000000000001ULL, ~0ULL,
+  };
+  std::mt19937_64 rng(12345);
+  uint_t i, j, errors = 0;
+
+  for (i = 0; i < NUMBEROF(denominators); i++)
+  {
+    UniversalTime tb(denominators[i]);
+
+    for (j = 0; j < 10000; j++)
+    {
+      // use a range of magnitudes of numerator
+      uint64_t num = rng() >> (j % 64);
+      unsigned __int128 calc = ((unsigned __int128)num * 1000000000ULL) / denominators[i];
+      unsigned __int128 inv  = ((unsigned __int128)num * denominators[i]) / 1000000000ULL;
+
+      if ((calc >> 64) == 0) errors += (tb.Calc(num) != (uint64_t)calc);
+      if ((inv  >> 64) == 0) errors += (tb.Invert(num) != (uint64_t)inv);
+    }
+  }
+
+  CHECK(errors == 0);
+#endif
+}
+
+BBC_AUDIOTOOLBOX_END
@@ -0,0 +1,154 @@
+#include <chrono>
+#include <random>
+#include <type_traits>
+
+#include <string.h>
+
+#include <catch/catch.hpp>
+
+#include "3DPosition.h"
+
+BBC_AUDIOTOOLBOX_START
+
+static_assert(std::is_trivially_copyable<Vec3d>::value, "Vec3d must be trivially copyable");
+static_assert(std::is_trivially_copyable<Vec3f>::value, "Vec3f must be trivially copyable");
+static_assert(std::is_trivially_copyable<Quatd>::value, "Quatd must be trivially copyable");
+static_assert(std::is_trivially_copyable<Quatf>::value, "Quatf must be trivially copyable");
+static_assert(sizeof(Vec3d) == 3 * sizeof(double), "Vec3d must be dense");
+static_assert(sizeof(Vec3f) == 3 * sizeof(float),  "Vec3f must be dense");
+static_assert(sizeof(Quatd) == 4 * sizeof(double), "Quatd must be dense");
+static_assert(sizeof(Quatf) == 4 * sizeof(float),  "Quatf must be dense");
+
+// compile-time evaluation
+static constexpr Vec3d a(1.0, 2.0, 3.0), b(4.0, 5.0, 6.0);
+static_assert(a.Dot(b) == 32.0, "constexpr Dot failed");
+static_assert(a.Cross(b) == Vec3d(-3.0, 6.0, -3.0), "constexpr Cross failed");
+static_assert((a + b) * 2.0 - b == Vec3d(6.0, 9.0, 12.0), "constexpr arithmetic failed");
+static_assert(Quatd::Identity().Rotate(a) == a, "constexpr Rotate failed");
+static_assert(Quatd(0.0, 0.0, 0.0, 1.0).Rotate(Vec3d(1.0, 0.0, 0.0)) == Vec3d(-1.0, 0.0, 0.0), "constexpr Rotate failed");
+
+TEST_CASE("vector")
+{
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<double> coord(-10.0, 10.0), angle(-180.0, 180.0);
+  uint_t i, mismatches = 0;
+  double maxerr = 0.0;
+
+  for (i = 0; i < 1000; i++)
+  {
+    Position   pos(coord(rng), coord(rng), coord(rng));
+    Quaternion rot(angle(rng), Position(coord(rng), coord(rng), coord(rng)).Unit());
+    Vec3d      vec = ToVec3d(pos);
+    Quatd      q   = ToQuatd(rot);
+
+    // rotations must be identical to Position/Quaternion versions
+    mismatches += (ToPosition(q.Rotate(vec)) != pos * rot);
+    mismatches += (ToPosition(q.InverseRotate(vec)) != pos / rot);
+    mismatches += (ToQuaternion(q * ToQuatd(rot)) != rot * rot);
+    mismatches += (ToPosition(vec.Cross(ToVec3d(pos * rot))) != CrossProduct(pos, pos * rot));
+
+    // float version should be close
+    Vec3d fres(ToQuatf(rot).Rotate(ToVec3f(pos)));
+    maxerr = std::max(maxerr, (fres - ToVec3d(pos * rot)).Length());
+  }
+  CHECK(mismatches == 0);
+  CHECK(maxerr < 1.0e-4);
+
+  // round trips via polar
+  Position polar(30.0, 10.0, 2.0);
+  polar.polar = true;
+  CHECK(ToPosition(ToVec3d(polar)) == polar.Cart());
+  CHECK(ToVec3d(polar).Length() == Approx(2.0));
+
+  // array of vectors can be copied as memory
+  std::vector<Vec3f> vecs(16, Vec3f(1.f, 2.f, 3.f)), copy(16);
+  memcpy(&copy[0], &vecs[0], vecs.size() * sizeof(vecs[0]));
+  CHECK(copy[15] == Vec3f(1.f, 2.f, 3.f));
+}
+
+TEST_CASE("vectortransforms")
+{
+  std::mt19937 rng(6);
+  std::uniform_real_distribution<double> coord(-10.0, 10.0), angle(-180.0, 180.0);
+  PositionTransform trans;
+  ScreenTransform   screen;
+  uint_t i, mismatches = 0;
+  double maxerr = 0.0, maxferr = 0.0, maxbatcherr = 0.0;
+
+  trans.pretranslation  = Position(1.0, -2.0, 0.5);
+  trans.rotation        = Quaternion(30.0, Position(0.2, 0.4, 1.0).Unit());
+  trans.posttranslation = Position(-0.5, 3.0, 1.0);
+
+  screen.cx   = 0.1;
+  screen.cy   = -0.2;
+  screen.sx   = 1.5;
+  screen.sy   = 0.8;
+  screen.dist = 20.0;
+
+  const PositionTransformd transd  = ToPositionTransformd(trans);
+  const PositionTransformf transf  = ToPositionTransformf(trans);
+  const ScreenTransformd   screend = ToScreenTransformd(screen);
+  const ScreenTransformf   screenf = ToScreenTransformf(screen);
+  std::vector<Vec3f> vecs(1000), res(1000);
+
+  CHECK(ToPositionTransform(transd) == trans);
+  CHECK(ToScreenTransform(screend) == screen);
+
+  for (i = 0; i < vecs.size(); i++)
+  {
+    Position pos(coord(rng), coord(rng), coord(rng));
+    Vec3d    vec = ToVec3d(pos);
+
+    // double versions must be identical to Position versions
+    mismatches += (ToPosition(transd.Apply(vec))   != pos * trans);
+    mismatches += (ToPosition(transd.Remove(vec))  != pos / trans);
+    mismatches += (ToPosition(screend.Apply(vec))  != pos * screen);
+    mismatches += (ToPosition(screend.Remove(vec)) != pos / screen);
+
+    // round trip through polar
+    double az, el, d;
+    vec.ToPolar(az, el, d);
+    maxerr = std::max(maxerr, (Vec3d::FromPolar(az, el, d) - vec).Length());
+    maxerr = std::max(maxerr, (Vec3d::FromPolar(az, el, d) - ToVec3d(pos.Polar())).Length());
+
+    // float versions should be close
+    vecs[i] = ToVec3f(pos);
+    maxferr = std::max(maxferr, (Vec3d(transf.Apply(vecs[i])) - ToVec3d(pos * trans)).Length());
+    maxferr = std::max(maxferr, (Vec3d(screenf.Apply(vecs[i])) - ToVec3d(pos * screen)).Length());
+  }
+  CHECK(mismatches == 0);
+  CHECK(maxerr < 1.0e-12);
+  CHECK(maxferr < 1.0e-4);
+
+  // array version should match single vector version
+  transf.Apply(&vecs[0], &res[0], vecs.size());
+  for (i = 0; i < vecs.size(); i++) maxbatcherr = std::max(maxbatcherr, (double)(res[i] - transf.Apply(vecs[i])).Length());
+  CHECK(maxbatcherr < 1.0e-4);
+}
+
+template<typename T>
+static double BenchmarkTransform(const BasicPositionTransform<T>& trans, uint_t n, uint_t iterations)
+{
+  std::vector<BasicVec3<T> > vecs(n, BasicVec3<T>((T)1, (T)2, (T)3));
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint_t i;
+
+  for (i = 0; i < iterations; i++) trans.Apply(&vecs[0], &vecs[0], n);
+
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1.0e9 / (double)(n * iterations);
+}
+
+TEST_CASE("vectorbenchmark", "[.][benchmark]")
+{
+  PositionTransform trans;
+  const uint_t n = 4096, iterations = 2000;
+
+  trans.pretranslation  = Position(1.0, -2.0, 0.5);
+  trans.rotation        = Quaternion(30.0, Position(0.2, 0.4, 1.0).Unit());
+  trans.posttranslation = Position(-0.5, 3.0, 1.0);
+
+  WARN("PositionTransformd array transform: " << BenchmarkTransform(ToPositionTransformd(trans), n, iterations) << "ns per vector");
+  WARN("PositionTransformf array transform: " << BenchmarkTransform(ToPositionTransformf(trans), n, iterations) << "ns per vector");
+}
+
+BBC_AUDIOTOOLBOX_END